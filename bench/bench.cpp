@@ -3,6 +3,9 @@
 
 #include <benchmark/benchmark.h>
 
+#include "bench_matrix.h"
+#include "perf_counters.h"
+
 static constexpr int n_channels = 2;
 static constexpr int n_samples = 512;
 chowdsp::Buffer<float> buffer { n_channels, n_samples };
@@ -75,6 +78,7 @@ static void ref_interp2 (benchmark::State& state)
     chowdsp::ArenaAllocator<> arena { 1 << 14 };
     chowdsp::FIRPolyphaseInterpolator<float, 2, n_taps> ref_filter;
     ref_filter.prepare (n_channels, n_samples, coeffs, arena);
+    Perf_Counters_Scope perf_counters { state, (double) (n_samples * 2 * n_channels) };
     for (auto _ : state)
     {
         ref_filter.processBlock (buffer, buffer_x2);
@@ -86,6 +90,7 @@ static void ref_interp3 (benchmark::State& state)
     chowdsp::ArenaAllocator<> arena { 1 << 14 };
     chowdsp::FIRPolyphaseInterpolator<float, 3, n_taps> ref_filter;
     ref_filter.prepare (n_channels, n_samples, coeffs, arena);
+    Perf_Counters_Scope perf_counters { state, (double) (n_samples * 3 * n_channels) };
     for (auto _ : state)
     {
         ref_filter.processBlock (buffer, buffer_x3);
@@ -97,6 +102,7 @@ static void ref_decim2 (benchmark::State& state)
     chowdsp::ArenaAllocator<> arena { 1 << 14 };
     chowdsp::FIRPolyphaseDecimator<float, 2, n_taps> ref_filter;
     ref_filter.prepare (n_channels, n_samples * 2, coeffs, arena);
+    Perf_Counters_Scope perf_counters { state, (double) (n_samples * n_channels) };
     for (auto _ : state)
     {
         ref_filter.processBlock (buffer_x2, buffer);
@@ -108,6 +114,7 @@ static void ref_decim3 (benchmark::State& state)
     chowdsp::ArenaAllocator<> arena { 1 << 14 };
     chowdsp::FIRPolyphaseDecimator<float, 3, n_taps> ref_filter;
     ref_filter.prepare (n_channels, n_samples * 3, coeffs, arena);
+    Perf_Counters_Scope perf_counters { state, (double) (n_samples * n_channels) };
     for (auto _ : state)
     {
         ref_filter.processBlock (buffer_x3, buffer);
@@ -131,6 +138,7 @@ static void bench_interp (benchmark::State& s, chowdsp::Buffer<float>& buffer_ou
     pfir::load_coeffs (state, coeffs, n_taps);
 
     auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+    Perf_Counters_Scope perf_counters { s, (double) (n_samples * factor * n_channels) };
     for (auto _ : s)
     {
         pfir::process_interpolate (state,
@@ -160,6 +168,7 @@ static void bench_decim (benchmark::State& s, chowdsp::Buffer<float>& buffer_in,
     pfir::load_coeffs (state, coeffs, n_taps);
 
     auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+    Perf_Counters_Scope perf_counters { s, (double) (n_samples * n_channels) };
     for (auto _ : s)
     {
         pfir::process_decimate (state,
@@ -212,6 +221,65 @@ static void decim3_avx (benchmark::State& state)
     bench_decim (state, buffer_x3, 3, true);
 }
 
+/** The IIR half-band, head-to-head with the factor-2 FIR (which needs far more multiplies per output for a similar stopband) */
+static void bench_iir_halfband (benchmark::State& s, bool decimate, bool use_avx)
+{
+    namespace pfir = chowdsp::polyphase_fir;
+    const auto alignment = use_avx ? 32 : 16;
+    const auto n_coeffs = pfir::iir_halfband_coeffs_required (0.8, 90.0);
+    std::vector<float> iir_coeffs ((size_t) n_coeffs);
+    pfir::iir_halfband_design (iir_coeffs.data(), n_coeffs, 0.8);
+
+    const auto persistent_bytes = pfir::iir_halfband_persistent_bytes_required (n_channels, n_coeffs, alignment);
+    const auto scratch_bytes = pfir::iir_halfband_scratch_bytes_required (n_samples, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+
+    auto state = pfir::iir_halfband_init (n_channels, n_coeffs, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+    pfir::iir_halfband_load_coeffs (state, iir_coeffs.data(), n_coeffs);
+
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+    Perf_Counters_Scope perf_counters { s, (double) (n_samples * (decimate ? 1 : 2) * n_channels) };
+    for (auto _ : s)
+    {
+        if (decimate)
+            pfir::iir_halfband_process_decimate (state,
+                                                 buffer_x2.getArrayOfReadPointers(),
+                                                 buffer.getArrayOfWritePointers(),
+                                                 n_channels,
+                                                 n_samples * 2,
+                                                 scratch_data,
+                                                 use_avx);
+        else
+            pfir::iir_halfband_process_interpolate (state,
+                                                    buffer.getArrayOfReadPointers(),
+                                                    buffer_x2.getArrayOfWritePointers(),
+                                                    n_channels,
+                                                    n_samples,
+                                                    scratch_data,
+                                                    use_avx);
+    }
+}
+
+static void iir_interp2 (benchmark::State& state)
+{
+    bench_iir_halfband (state, false, false);
+}
+
+static void iir_interp2_avx (benchmark::State& state)
+{
+    bench_iir_halfband (state, false, true);
+}
+
+static void iir_decim2 (benchmark::State& state)
+{
+    bench_iir_halfband (state, true, false);
+}
+
+static void iir_decim2_avx (benchmark::State& state)
+{
+    bench_iir_halfband (state, true, true);
+}
+
 BENCHMARK (ref_interp2)->MinTime (1);
 BENCHMARK (ref_interp3)->MinTime (1);
 BENCHMARK (interp2)->MinTime (1);
@@ -220,6 +288,10 @@ BENCHMARK (interp3)->MinTime (1);
 BENCHMARK (interp2_avx)->MinTime (1);
 BENCHMARK (interp3_avx)->MinTime (1);
 #endif
+BENCHMARK (iir_interp2)->MinTime (1);
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+BENCHMARK (iir_interp2_avx)->MinTime (1);
+#endif
 
 BENCHMARK (ref_decim2)->MinTime (1);
 BENCHMARK (ref_decim3)->MinTime (1);
@@ -229,6 +301,10 @@ BENCHMARK (decim3)->MinTime (1);
 BENCHMARK (decim2_avx)->MinTime (1);
 BENCHMARK (decim3_avx)->MinTime (1);
 #endif
+BENCHMARK (iir_decim2)->MinTime (1);
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+BENCHMARK (iir_decim2_avx)->MinTime (1);
+#endif
 
 int main(int argc, char** argv)
 {
@@ -248,6 +324,8 @@ int main(int argc, char** argv)
            x = static_cast<float> (n);
    }
 
+   init_perf_counters (argc, argv);
+   register_matrix_benchmarks (argc, argv);
    ::benchmark::Initialize(&argc, argv);
    ::benchmark::RunSpecifiedBenchmarks();
 }
@@ -0,0 +1,227 @@
+#include "bench_matrix.h"
+#include "perf_counters.h"
+
+#include <chowdsp_filters/chowdsp_filters.h>
+#include <chowdsp_polyphase_fir.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace pfir = chowdsp::polyphase_fir;
+
+namespace
+{
+constexpr double pi = 3.14159265358979323846;
+
+struct Matrix_Kernel
+{
+    const char* name;
+    pfir::Polyphase_FIR_Kernel kernel;
+    int flags;
+};
+
+constexpr Matrix_Kernel matrix_kernels[] {
+    { "sse", pfir::FIR_Kernel_SSE, pfir::FIR_Flags_None },
+    { "sse_blocked", pfir::FIR_Kernel_SSE_Blocked, pfir::FIR_Flags_None },
+    { "sse_per_channel", pfir::FIR_Kernel_SSE, pfir::FIR_Flag_Per_Channel_Coeffs },
+    { "sse_f16", pfir::FIR_Kernel_SSE, pfir::FIR_Flag_Coeffs_F16 },
+    { "sse_bf16", pfir::FIR_Kernel_SSE, pfir::FIR_Flag_Coeffs_BF16 },
+    { "avx", pfir::FIR_Kernel_AVX, pfir::FIR_Flags_None },
+    { "avx_blocked", pfir::FIR_Kernel_AVX_Blocked, pfir::FIR_Flags_None },
+    { "avx_per_channel", pfir::FIR_Kernel_AVX, pfir::FIR_Flag_Per_Channel_Coeffs },
+    { "avx_f16", pfir::FIR_Kernel_AVX, pfir::FIR_Flag_Coeffs_F16 },
+    { "avx_bf16", pfir::FIR_Kernel_AVX, pfir::FIR_Flag_Coeffs_BF16 },
+    { "neon", pfir::FIR_Kernel_NEON, pfir::FIR_Flags_None },
+    { "neon_blocked", pfir::FIR_Kernel_NEON_Blocked, pfir::FIR_Flags_None },
+    { "neon_per_channel", pfir::FIR_Kernel_NEON, pfir::FIR_Flag_Per_Channel_Coeffs },
+    { "neon_f16", pfir::FIR_Kernel_NEON, pfir::FIR_Flag_Coeffs_F16 },
+    { "neon_bf16", pfir::FIR_Kernel_NEON, pfir::FIR_Flag_Coeffs_BF16 },
+    { "generic", pfir::FIR_Kernel_Generic, pfir::FIR_Flags_None },
+    { "generic_blocked", pfir::FIR_Kernel_Generic_Blocked, pfir::FIR_Flags_None },
+    { "generic_per_channel", pfir::FIR_Kernel_Generic, pfir::FIR_Flag_Per_Channel_Coeffs },
+    { "generic_f16", pfir::FIR_Kernel_Generic, pfir::FIR_Flag_Coeffs_F16 },
+    { "generic_bf16", pfir::FIR_Kernel_Generic, pfir::FIR_Flag_Coeffs_BF16 },
+};
+
+struct Matrix_Config
+{
+    bool decimate = false;
+    int n_channels = 2;
+    int block_size = 512;
+    int n_taps = 57;
+    int factor = 2;
+    Matrix_Kernel kernel {};
+};
+
+/** Hann-windowed sinc lowpass, cutting off at the Nyquist frequency of the lower sample rate */
+std::vector<float> make_lowpass (int n_taps, int factor)
+{
+    std::vector<float> h ((size_t) n_taps);
+    const auto centre = 0.5 * (n_taps - 1);
+    for (int i = 0; i < n_taps; ++i)
+    {
+        const auto t = ((double) i - centre) / (double) factor;
+        const auto sinc = t == 0.0 ? 1.0 : std::sin (pi * t) / (pi * t);
+        const auto window = 0.5 - 0.5 * std::cos (2.0 * pi * (i + 1) / (n_taps + 1));
+        h[(size_t) i] = (float) (sinc * window);
+    }
+    return h;
+}
+
+void bench_matrix (benchmark::State& s, const Matrix_Config& config)
+{
+    static constexpr int alignment = 32;
+    const auto n_samples_in = config.decimate ? config.block_size * config.factor : config.block_size;
+    const auto n_samples_out = config.decimate ? config.block_size : config.block_size * config.factor;
+
+    const auto persistent_bytes = pfir::persistent_bytes_required_with_flags (config.n_channels, config.n_taps, config.factor, config.block_size, config.kernel.flags, alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (config.n_taps, config.factor, config.block_size, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + 2 * alignment };
+    auto* state = pfir::init_with_flags (config.n_channels,
+                                         config.n_taps,
+                                         config.factor,
+                                         config.block_size,
+                                         config.kernel.flags,
+                                         arena.allocate_bytes (persistent_bytes, alignment),
+                                         alignment);
+    const auto coeffs = make_lowpass (config.n_taps, config.factor);
+    pfir::load_coeffs (state, coeffs.data(), config.n_taps);
+    pfir::set_kernels (state, config.kernel.kernel, config.kernel.kernel);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    chowdsp::Buffer<float> buffer_in { config.n_channels, n_samples_in };
+    chowdsp::Buffer<float> buffer_out { config.n_channels, n_samples_out };
+    for (auto [ch, data] : chowdsp::buffer_iters::channels (buffer_in))
+        for (auto [n, x] : chowdsp::enumerate (data))
+            x = std::sin (0.01f * (float) n + (float) ch);
+
+    const auto process = [&]
+    {
+        if (config.decimate)
+            pfir::process_decimate (state, buffer_in.getArrayOfReadPointers(), buffer_out.getArrayOfWritePointers(), config.n_channels, n_samples_in, scratch_data, false);
+        else
+            pfir::process_interpolate (state, buffer_in.getArrayOfReadPointers(), buffer_out.getArrayOfWritePointers(), config.n_channels, n_samples_in, scratch_data, false);
+    };
+    process(); // warm up
+
+    const auto outputs_per_iteration = (double) n_samples_out * (double) config.n_channels;
+    Perf_Counters_Scope perf_counters { s, outputs_per_iteration };
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : s)
+    {
+        process();
+        benchmark::DoNotOptimize (buffer_out.getWritePointer (0));
+        benchmark::ClobberMemory();
+    }
+    const auto elapsed_ns = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - start).count();
+
+    s.SetBytesProcessed ((int64_t) s.iterations() * (int64_t) (n_samples_in + n_samples_out) * config.n_channels * (int64_t) sizeof (float));
+    s.counters["samples_per_second"] = benchmark::Counter (outputs_per_iteration, benchmark::Counter::kIsIterationInvariantRate);
+    s.counters["ns_per_output"] = elapsed_ns / (outputs_per_iteration * (double) s.iterations());
+}
+
+std::vector<int> parse_int_list (const char* list)
+{
+    std::vector<int> values;
+    std::stringstream stream { list };
+    for (std::string value; std::getline (stream, value, ',');)
+        values.push_back (std::atoi (value.c_str()));
+    return values;
+}
+
+std::vector<std::string> parse_string_list (const char* list)
+{
+    std::vector<std::string> values;
+    std::stringstream stream { list };
+    for (std::string value; std::getline (stream, value, ',');)
+        values.push_back (value);
+    return values;
+}
+
+bool parse_arg (const char* arg, const char* flag, const char*& value)
+{
+    const auto flag_length = std::strlen (flag);
+    if (std::strncmp (arg, flag, flag_length) != 0 || arg[flag_length] != '=')
+        return false;
+    value = arg + flag_length + 1;
+    return true;
+}
+} // namespace
+
+void register_matrix_benchmarks (int& argc, char** argv)
+{
+    bool enabled = false;
+    std::vector<std::string> modes { "interp", "decim" };
+    std::vector<int> channels { 1, 2, 8, 32, 128 };
+    std::vector<int> block_sizes { 1, 64, 512, 8192 };
+    std::vector<int> taps { 16, 64, 256, 1024, 4096 };
+    std::vector<int> factors { 2, 3, 4, 8, 16 };
+    std::vector<std::string> kernels;
+    for (const auto& kernel : matrix_kernels)
+        kernels.emplace_back (kernel.name);
+
+    int n_remaining_args = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* value = nullptr;
+        if (std::strcmp (argv[i], "--matrix") == 0)
+            enabled = true;
+        else if (parse_arg (argv[i], "--matrix_modes", value))
+            modes = parse_string_list (value);
+        else if (parse_arg (argv[i], "--matrix_channels", value))
+            channels = parse_int_list (value);
+        else if (parse_arg (argv[i], "--matrix_block_sizes", value))
+            block_sizes = parse_int_list (value);
+        else if (parse_arg (argv[i], "--matrix_taps", value))
+            taps = parse_int_list (value);
+        else if (parse_arg (argv[i], "--matrix_factors", value))
+            factors = parse_int_list (value);
+        else if (parse_arg (argv[i], "--matrix_kernels", value))
+            kernels = parse_string_list (value);
+        else
+            argv[n_remaining_args++] = argv[i];
+    }
+    argc = n_remaining_args;
+
+    if (! enabled)
+        return;
+
+    for (const auto& mode : modes)
+    {
+        for (const auto& kernel : matrix_kernels)
+        {
+            if (! pfir::kernel_available (kernel.kernel) || std::find (kernels.begin(), kernels.end(), kernel.name) == kernels.end())
+                continue;
+
+            for (auto n_channels : channels)
+            {
+                for (auto block_size : block_sizes)
+                {
+                    for (auto n_taps : taps)
+                    {
+                        for (auto factor : factors)
+                        {
+                            const Matrix_Config config { mode == "decim", n_channels, block_size, n_taps, factor, kernel };
+                            const auto name = "matrix/" + mode
+                                              + "/channels:" + std::to_string (n_channels)
+                                              + "/block:" + std::to_string (block_size)
+                                              + "/taps:" + std::to_string (n_taps)
+                                              + "/factor:" + std::to_string (factor)
+                                              + "/kernel:" + kernel.name;
+                            benchmark::RegisterBenchmark (name.c_str(), [config] (benchmark::State& s)
+                                                          { bench_matrix (s, config); });
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+/**
+ * Registers the parameterized benchmark matrix, if `--matrix` was passed on the command line.
+ * Any `--matrix*` arguments are removed from argv, so this should be called before `benchmark::Initialize()`.
+ */
+void register_matrix_benchmarks (int& argc, char** argv);
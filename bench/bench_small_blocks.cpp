@@ -0,0 +1,99 @@
+#include <chowdsp_polyphase_fir.h>
+#include <chowdsp_polyphase_fir_design.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Small-block benchmarks, where the cost of each call matters the most. This file is also built on its own as
+ * bench_chowdsp_polyphase_fir_single_header, with CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION defined, so that the
+ * library can be inlined into (and specialized for) the constant arguments used here. The results of the two
+ * executables can be compared with bench/compare.py. bench_chowdsp_polyphase_fir_generic is the same, but built
+ * with CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD, to compare the generic kernels against SSE/NEON.
+ */
+namespace
+{
+namespace pfir = chowdsp::polyphase_fir;
+
+constexpr int n_channels = 2;
+constexpr int n_taps = 57;
+constexpr int max_block_size = 64;
+
+template <int factor, bool decimate>
+void bench_small_block (benchmark::State& s, bool use_avx)
+{
+    const auto block_size = (int) s.range (0); // at the lower sample rate
+    const auto max_samples_in = decimate ? max_block_size * factor : max_block_size;
+    const auto n_samples_in = decimate ? block_size * factor : block_size;
+    const auto n_samples_out = decimate ? block_size : block_size * factor;
+    const auto alignment = use_avx ? 32 : 16;
+
+    const auto persistent_bytes = pfir::persistent_bytes_required (n_channels, n_taps, factor, max_samples_in, alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, max_samples_in, alignment);
+    std::vector<std::byte> memory (persistent_bytes + scratch_bytes + alignment);
+    auto* data = memory.data() + (alignment - (int) ((uintptr_t) memory.data() % (uintptr_t) alignment)) % alignment;
+
+    auto* state = pfir::init (n_channels, n_taps, factor, max_samples_in, data, alignment);
+    const auto coeffs = pfir::design_kaiser_lowpass<n_taps> ({ .factor = factor, .gain = decimate ? 1.0 : (double) factor });
+    pfir::load_coeffs (state, coeffs.data(), n_taps);
+    auto* scratch_data = data + persistent_bytes;
+
+    std::vector<std::vector<float>> x (n_channels, std::vector<float> ((size_t) n_samples_in, 0.5f));
+    std::vector<std::vector<float>> y (n_channels, std::vector<float> ((size_t) n_samples_out));
+    const float* x_ptrs[n_channels] { x[0].data(), x[1].data() };
+    float* y_ptrs[n_channels] { y[0].data(), y[1].data() };
+
+    for (auto _ : s)
+    {
+        if constexpr (decimate)
+            pfir::process_decimate (state, x_ptrs, y_ptrs, n_channels, n_samples_in, scratch_data, use_avx);
+        else
+            pfir::process_interpolate (state, x_ptrs, y_ptrs, n_channels, n_samples_in, scratch_data, use_avx);
+        benchmark::ClobberMemory();
+    }
+    s.counters["samples_per_second"] = benchmark::Counter ((double) (n_samples_out * n_channels), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void small_interp2 (benchmark::State& state)
+{
+    bench_small_block<2, false> (state, false);
+}
+
+void small_decim2 (benchmark::State& state)
+{
+    bench_small_block<2, true> (state, false);
+}
+
+void small_decim3 (benchmark::State& state)
+{
+    bench_small_block<3, true> (state, false);
+}
+
+#if (defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)) && ! CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+void small_interp2_avx (benchmark::State& state)
+{
+    bench_small_block<2, false> (state, true);
+}
+
+void small_decim2_avx (benchmark::State& state)
+{
+    bench_small_block<2, true> (state, true);
+}
+
+void small_decim3_avx (benchmark::State& state)
+{
+    bench_small_block<3, true> (state, true);
+}
+#endif
+} // namespace
+
+BENCHMARK (small_interp2)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+BENCHMARK (small_decim2)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+BENCHMARK (small_decim3)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+#if (defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)) && ! CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+BENCHMARK (small_interp2_avx)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+BENCHMARK (small_decim2_avx)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+BENCHMARK (small_decim3_avx)->Arg (16)->Arg (32)->Arg (64)->MinTime (1);
+#endif
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Compares two JSON result files from bench_chowdsp_polyphase_fir, and flags regressions.
+
+Usage:
+    bench_chowdsp_polyphase_fir --matrix --benchmark_out=baseline.json --benchmark_out_format=json
+    (make some changes...)
+    bench_chowdsp_polyphase_fir --matrix --benchmark_out=contender.json --benchmark_out_format=json
+    python3 bench/compare.py baseline.json contender.json --threshold 5
+
+Benchmarks are compared by their `ns_per_output` counter if they have one, or by their real time otherwise.
+When a benchmark was run with repetitions, the fastest repetition (or the "median" aggregate) is used.
+The script exits with a non-zero status if any benchmark is slower than the threshold.
+"""
+
+import argparse
+import json
+import sys
+
+TIME_UNIT_TO_NS = {"ns": 1.0, "us": 1.0e3, "ms": 1.0e6, "s": 1.0e9}
+
+
+def load_results(path):
+    with open(path) as file:
+        data = json.load(file)
+
+    results = {}
+    medians = {}
+    for bench in data["benchmarks"]:
+        if bench.get("error_occurred", False):
+            continue
+
+        if "ns_per_output" in bench:
+            value = float(bench["ns_per_output"])
+        else:
+            value = float(bench["real_time"]) * TIME_UNIT_TO_NS[bench.get("time_unit", "ns")]
+
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = value
+            continue
+
+        results[name] = min(value, results.get(name, value))
+
+    results.update(medians)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="JSON results for the baseline")
+    parser.add_argument("contender", help="JSON results to compare against the baseline")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent slowdown that counts as a regression (default: 5)")
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    contender = load_results(args.contender)
+    common = [name for name in baseline if name in contender]
+    if not common:
+        print("No benchmarks in common!")
+        return 1
+
+    name_width = max(len(name) for name in common)
+    print(f"{'Benchmark':<{name_width}}  {'Baseline':>12}  {'Contender':>12}  {'Change':>8}")
+    n_regressions = 0
+    for name in common:
+        change = 100.0 * (contender[name] - baseline[name]) / baseline[name]
+        is_regression = change > args.threshold
+        n_regressions += int(is_regression)
+        flag = "  REGRESSION" if is_regression else ""
+        print(f"{name:<{name_width}}  {baseline[name]:>12.4f}  {contender[name]:>12.4f}  {change:>+7.1f}%{flag}")
+
+    for name in baseline:
+        if name not in contender:
+            print(f"Missing from contender: {name}")
+
+    print(f"\n{n_regressions} regression(s) out of {len(common)} benchmarks (threshold: {args.threshold}%)")
+    return 1 if n_regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
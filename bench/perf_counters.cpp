@@ -0,0 +1,211 @@
+#include "perf_counters.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+enum Perf_Counter_Kind
+{
+    Cycles = 0,
+    Instructions,
+    L1D_Misses,
+    FP_Ops,
+    Num_Counter_Kinds,
+};
+
+constexpr const char* counter_names[Num_Counter_Kinds] {
+    "cycles_per_output",
+    "instructions_per_output",
+    "l1d_misses_per_output",
+    "fp_ops_per_output",
+};
+
+struct Perf_Event
+{
+    const char* name;
+    Perf_Counter_Kind kind;
+    uint32_t type;
+    uint64_t config;
+    double weight; // operations per counted event, e.g. the number of lanes in a packed instruction
+    int fd;
+};
+
+bool perf_counters_enabled = false;
+std::vector<Perf_Event> events;
+
+#if defined(__linux__)
+constexpr uint64_t hw_cache_config (uint64_t cache, uint64_t op, uint64_t result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+
+std::vector<Perf_Event> get_events()
+{
+    std::vector<Perf_Event> candidates {
+        { "cycles", Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1.0, -1 },
+        { "instructions", Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, 1.0, -1 },
+        { "L1D read misses",
+          L1D_Misses,
+          PERF_TYPE_HW_CACHE,
+          hw_cache_config (PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS),
+          1.0,
+          -1 },
+    };
+
+    // There's no generic perf event for floating-point operations, so we use the raw events
+    // for single-precision arithmetic (the only kind this library does).
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_is ("intel"))
+    {
+        // FP_ARITH_INST_RETIRED counts instructions (FMAs twice), so each packed instruction is weighted by its width.
+        candidates.push_back ({ "FP_ARITH_INST_RETIRED.SCALAR_SINGLE", FP_Ops, PERF_TYPE_RAW, 0x02c7, 1.0, -1 });
+        candidates.push_back ({ "FP_ARITH_INST_RETIRED.128B_PACKED_SINGLE", FP_Ops, PERF_TYPE_RAW, 0x08c7, 4.0, -1 });
+        candidates.push_back ({ "FP_ARITH_INST_RETIRED.256B_PACKED_SINGLE", FP_Ops, PERF_TYPE_RAW, 0x20c7, 8.0, -1 });
+        candidates.push_back ({ "FP_ARITH_INST_RETIRED.512B_PACKED_SINGLE", FP_Ops, PERF_TYPE_RAW, 0x80c7, 16.0, -1 });
+    }
+    else if (__builtin_cpu_is ("amd"))
+    {
+        // Retired SSE/AVX FLOPs (PMCx003) already counts operations, including both halves of an FMA.
+        candidates.push_back ({ "Retired SSE/AVX FLOPs", FP_Ops, PERF_TYPE_RAW, 0xff03, 1.0, -1 });
+    }
+#endif
+
+    return candidates;
+}
+
+int open_event (const Perf_Event& event)
+{
+    perf_event_attr attr {};
+    attr.size = sizeof (attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // the counters aren't grouped, so the kernel may multiplex them if there are more events than hardware counters
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void open_events()
+{
+    for (auto& event : get_events())
+    {
+        event.fd = open_event (event);
+        if (event.fd < 0)
+        {
+            std::fprintf (stderr, "perf counters: unable to open \"%s\" (%s)\n", event.name, std::strerror (errno));
+            continue;
+        }
+        events.push_back (event);
+    }
+
+    if (events.empty())
+    {
+        std::fprintf (stderr, "perf counters: no events are available, so the counters will not be reported\n");
+        perf_counters_enabled = false;
+    }
+}
+
+/** Returns the event count, scaled up if the event was multiplexed, or a negative number if it never ran. */
+double read_event (const Perf_Event& event)
+{
+    struct
+    {
+        uint64_t value;
+        uint64_t time_enabled;
+        uint64_t time_running;
+    } data {};
+    if (read (event.fd, &data, sizeof (data)) != (ssize_t) sizeof (data) || data.time_running == 0)
+        return -1.0;
+    return (double) data.value * (double) data.time_enabled / (double) data.time_running;
+}
+#endif
+} // namespace
+
+void init_perf_counters (int& argc, char** argv)
+{
+    int n_remaining_args = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--perf_counters") == 0)
+            perf_counters_enabled = true;
+        else
+            argv[n_remaining_args++] = argv[i];
+    }
+    argc = n_remaining_args;
+
+    if (! perf_counters_enabled)
+        return;
+
+#if defined(__linux__)
+    open_events();
+#else
+    std::fprintf (stderr, "perf counters: only supported on Linux\n");
+    perf_counters_enabled = false;
+#endif
+}
+
+Perf_Counters_Scope::Perf_Counters_Scope (benchmark::State& s, double outputs_per_iter)
+    : state (s),
+      outputs_per_iteration (outputs_per_iter)
+{
+#if defined(__linux__)
+    if (! perf_counters_enabled)
+        return;
+
+    for (const auto& event : events)
+    {
+        ioctl (event.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl (event.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+Perf_Counters_Scope::~Perf_Counters_Scope()
+{
+#if defined(__linux__)
+    if (! perf_counters_enabled)
+        return;
+
+    for (const auto& event : events)
+        ioctl (event.fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    double totals[Num_Counter_Kinds] {};
+    bool measured[Num_Counter_Kinds] {};
+    for (const auto& event : events)
+    {
+        const auto count = read_event (event);
+        if (count < 0.0)
+            continue;
+        totals[event.kind] += event.weight * count;
+        measured[event.kind] = true;
+    }
+
+    const auto n_outputs = outputs_per_iteration * (double) state.iterations();
+    if (n_outputs <= 0.0)
+        return;
+
+    for (int kind = 0; kind < Num_Counter_Kinds; ++kind)
+    {
+        if (measured[kind])
+            state.counters[counter_names[kind]] = totals[kind] / n_outputs;
+    }
+
+    if (measured[Cycles] && measured[Instructions] && totals[Cycles] > 0.0)
+        state.counters["ipc"] = totals[Instructions] / totals[Cycles];
+#endif
+}
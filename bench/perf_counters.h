@@ -0,0 +1,33 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+/**
+ * Enables the hardware performance counters if `--perf_counters` was passed on the command line.
+ * The counters use `perf_event_open`, so they are only available on Linux, and may require
+ * `/proc/sys/kernel/perf_event_paranoid` to be 2 or lower. The argument is removed from argv,
+ * so this should be called before `benchmark::Initialize()`.
+ */
+void init_perf_counters (int& argc, char** argv);
+
+/**
+ * Counts cycles, instructions, L1D misses, and floating-point operations over the lifetime
+ * of this object, and reports them per output sample in the benchmark's counters, along
+ * with the instructions per cycle. Does nothing unless the perf counters are enabled.
+ *
+ * Floating-point operations are counted with vendor-specific events, and are only reported on
+ * Intel and AMD CPUs. Fused multiply-adds count as two operations.
+ */
+class Perf_Counters_Scope
+{
+public:
+    Perf_Counters_Scope (benchmark::State& state, double outputs_per_iteration);
+    ~Perf_Counters_Scope();
+
+    Perf_Counters_Scope (const Perf_Counters_Scope&) = delete;
+    Perf_Counters_Scope& operator= (const Perf_Counters_Scope&) = delete;
+
+private:
+    benchmark::State& state;
+    double outputs_per_iteration;
+};
@@ -1,31 +1,160 @@
 #include "chowdsp_polyphase_fir.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <tuple>
+#include <utility>
 
-#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+#ifndef M_PI // in single-header mode, the host might not define _USE_MATH_DEFINES
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifndef CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION
+#define CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION 0
+#endif
+
+#if CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION && defined(_MSC_VER)
+#include <intrin.h>
+#elif CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION && (defined(__SSE2__) || defined(__x86_64__))
+#include <x86intrin.h>
+#endif
+
+// Targets without SSE or NEON use the generic (vector extension) kernels, which can also be forced with
+// CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD=1. `simd_128` is whichever set of 4-float kernels is compiled in.
+#ifndef CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD 0
+#else
+#define CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD 1
+#endif
+#endif
+
+#if CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD && defined(_MSC_VER) && ! defined(__clang__)
+#error "chowdsp_polyphase_fir: the generic kernels need the GCC/Clang vector extensions"
+#endif
+
+#if CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+#include "simd/chowdsp_polyphase_fir_impl_generic.cpp"
+#define CHOWDSP_POLYPHASE_FIR_X86_KERNELS 0
+namespace chowdsp::polyphase_fir
+{
+namespace simd_128 = generic;
+}
+#elif defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
 #include "simd/chowdsp_polyphase_fir_impl_sse.cpp"
-#if CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX
+#define CHOWDSP_POLYPHASE_FIR_X86_KERNELS 1
+namespace chowdsp::polyphase_fir
+{
+namespace simd_128 = sse;
+}
+#if CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX && defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION)
+#include "simd/chowdsp_polyphase_fir_impl_avx.cpp" // single-header mode (see chowdsp_polyphase_fir.h)
+#elif CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX
 namespace chowdsp::polyphase_fir::avx
 {
+template <bool accumulate>
 void process_fir_interp (const Polyphase_FIR_State* state,
                          const float* ch_state,
                          float* y_data,
                          int n_samples_in,
-                         float* scratch);
+                         float* scratch,
+                         float gain);
+template <bool accumulate>
 void process_fir_decim (const Polyphase_FIR_State* state,
                         const float* ch_state,
                         float* y_data,
                         int n_samples_out,
-                        float* scratch);
+                        float* scratch,
+                        float gain);
+template <bool accumulate>
+void process_fir_interp_blocked (const Polyphase_FIR_State* state,
+                                 const float* ch_state,
+                                 float* y_data,
+                                 int n_samples_in,
+                                 float* scratch,
+                                 float gain);
+template <bool accumulate>
+void process_fir_decim_blocked (const Polyphase_FIR_State* state,
+                                const float* ch_state,
+                                float* y_data,
+                                int n_samples_out,
+                                float* scratch,
+                                float gain);
+template <bool accumulate>
+void process_fir_interp_channels (const Polyphase_FIR_State* state,
+                                  const float* group_coeffs,
+                                  const float* group_state,
+                                  float* const* y_data,
+                                  int n_lanes,
+                                  int n_samples_in,
+                                  const float* gains);
+template <bool accumulate>
+void process_fir_decim_channels (const Polyphase_FIR_State* state,
+                                 const float* group_coeffs,
+                                 const float* group_state,
+                                 float* const* y_data,
+                                 int n_lanes,
+                                 int n_samples_out,
+                                 const float* gains);
+template <bool accumulate>
+void process_fir_interp_half (const Polyphase_FIR_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              int n_samples_in,
+                              float* scratch,
+                              float gain);
+template <bool accumulate>
+void process_fir_decim_half (const Polyphase_FIR_State* state,
+                             const float* ch_state,
+                             float* y_data,
+                             int n_samples_out,
+                             float* scratch,
+                             float gain);
+void process_fir_asrc (const Polyphase_ASRC_State* state,
+                       const float* ch_state,
+                       float* y_data,
+                       const int* window_idx,
+                       const int* phase_row,
+                       const float* weights,
+                       int n_samples_out);
+void process_fir_branches (const float* coeffs,
+                           int taps_per_filter_padded,
+                           const float* ch_state,
+                           const int* window_idx,
+                           float* y_data,
+                           int n_branches);
+void process_iir_interp_channels (const Polyphase_IIR_State* state,
+                                  float* group_state,
+                                  const float* x_data,
+                                  float* y_data,
+                                  int n_lanes,
+                                  int n_samples_in);
+void process_iir_decim_channels (const Polyphase_IIR_State* state,
+                                 float* group_state,
+                                 const float* x_data,
+                                 float* y_data,
+                                 int n_lanes,
+                                 int n_samples_out);
+void convert_pcm_to_float (const std::byte* in, int format, float* out, int n_samples);
+void convert_float_to_int (const float* in, int32_t* out, int n_samples, float scale, float max_value, unsigned int* dither_state);
 } // namespace chowdsp::polyphase_fir::avx
 #endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #elif defined(__ARM_NEON__) || defined(_M_ARM64)
 #include "simd/chowdsp_polyphase_fir_impl_neon.cpp"
+#define CHOWDSP_POLYPHASE_FIR_X86_KERNELS 0
+namespace chowdsp::polyphase_fir
+{
+namespace simd_128 = neon;
+}
 #endif
 
 namespace chowdsp::polyphase_fir
@@ -66,29 +195,198 @@ static int get_state_per_filter_padded (int taps_per_filter_padded, int max_samp
                                    alignment / (int) sizeof (float));
 }
 
-static auto get_coeffs_state_bytes (int n_channels, int n_taps, int factor, int max_samples_in, int alignment)
+static constexpr int channel_group_size = 4; // channels per interleaved group, with FIR_Flag_Per_Channel_Coeffs
+
+static int get_n_channel_groups (int n_channels)
+{
+    return ceiling_divide (n_channels, channel_group_size);
+}
+
+static constexpr int tap_tail_size = 4; // the AVX kernels finish each filter with a 128-bit tail
+
+static constexpr int complex_flags = FIR_Flag_Complex_Samples | FIR_Flag_Complex_Coeffs;
+
+/** With complex samples, each sample (and each tap) takes 2 floats, so the state's sizes and offsets are all in floats. */
+static int get_floats_per_sample (int flags)
 {
-    const auto taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, alignment);
-    const auto coeffs_bytes = taps_per_filter_padded * factor * sizeof (float);
+    return (flags & complex_flags) != 0 ? 2 : 1;
+}
+
+static int get_taps_per_filter_padded (int n_taps, int factor, int flags, int alignment)
+{
+    // The complex kernels hold two complex taps in each 128-bit vector.
+    if ((flags & complex_flags) != 0)
+        return 2 * round_to_next_multiple (ceiling_divide (n_taps, factor), 2);
+
+    // With per-channel coefficients the kernels vectorize across channels rather than taps,
+    // so the taps only need to be padded to a multiple of 2 (the AVX kernel loads two taps at a time).
+    if ((flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+        return round_to_next_multiple (ceiling_divide (n_taps, factor), 2);
+
+    // Otherwise padding to the full vector width would multiply up to 7 zeros per filter with AVX,
+    // so the taps are only padded to a multiple of 4 (or less, for smaller alignments).
+    return get_taps_per_filter_padded (n_taps, factor, min_int (alignment, tap_tail_size * (int) sizeof (float)));
+}
 
-    const auto interp_state_per_filter_padded = get_state_per_filter_padded (taps_per_filter_padded, max_samples_in, alignment);
-    const auto interp_state_bytes = interp_state_per_filter_padded * n_channels * sizeof (float);
+static constexpr int half_coeffs_flags = FIR_Flag_Coeffs_F16 | FIR_Flag_Coeffs_BF16;
 
-    const auto decim_state_per_filter_padded = get_state_per_filter_padded (taps_per_filter_padded, max_samples_in, alignment);
-    const auto decim_state_bytes = decim_state_per_filter_padded * factor * n_channels * sizeof (float);
+static auto get_coeffs_state_bytes (int n_channels, int n_taps, int factor, int max_samples_in, int flags, int alignment)
+{
+    const auto taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, flags, alignment);
+    const auto state_per_filter_padded = get_state_per_filter_padded (taps_per_filter_padded, max_samples_in * get_floats_per_sample (flags), alignment);
+    const auto has_coeffs = (flags & FIR_Flag_External_Coeffs) == 0; // otherwise the coefficients live in a coefficient bank
+
+    if ((flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+    {
+        // each "tap" or "sample" holds one value for every channel in the group
+        const auto n_lanes = get_n_channel_groups (n_channels) * channel_group_size;
+        const auto coeffs_bytes = has_coeffs ? (size_t) round_to_next_multiple (taps_per_filter_padded * factor * n_lanes * (int) sizeof (float), alignment) : 0;
+        const auto interp_state_bytes = state_per_filter_padded * n_lanes * sizeof (float);
+        const auto decim_state_bytes = state_per_filter_padded * factor * n_lanes * sizeof (float);
+        return std::make_tuple (coeffs_bytes, interp_state_bytes, decim_state_bytes);
+    }
 
+    const auto coeff_size = (flags & half_coeffs_flags) != 0 ? (int) sizeof (uint16_t) : (int) sizeof (float);
+    const auto n_coeff_tables = (flags & FIR_Flag_Complex_Coeffs) != 0 ? 2 : 1; // see load_polyphase_coeffs_complex()
+    const auto coeffs_bytes = has_coeffs ? (size_t) round_to_next_multiple (taps_per_filter_padded * factor * n_coeff_tables * coeff_size, alignment) : 0;
+    const auto interp_state_bytes = state_per_filter_padded * n_channels * sizeof (float);
+    const auto decim_state_bytes = state_per_filter_padded * factor * n_channels * sizeof (float);
     return std::make_tuple (coeffs_bytes, interp_state_bytes, decim_state_bytes);
 }
 
+/** The largest coefficient and state sizes needed at any factor up to `max_factor` (see `set_factor()`). */
+static auto get_max_factor_coeffs_state_bytes (int n_channels, int max_n_taps, int max_factor, int max_samples_in, int flags, int alignment)
+{
+    size_t max_coeffs_bytes = 0, max_interp_state_bytes = 0, max_decim_state_bytes = 0;
+    for (int factor = 1; factor <= max_factor; ++factor)
+    {
+        const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = get_coeffs_state_bytes (n_channels, max_n_taps, factor, max_samples_in, flags, alignment);
+        max_coeffs_bytes = std::max (max_coeffs_bytes, coeffs_bytes);
+        max_interp_state_bytes = std::max (max_interp_state_bytes, interp_state_bytes);
+        max_decim_state_bytes = std::max (max_decim_state_bytes, decim_state_bytes);
+    }
+    return std::make_tuple (max_coeffs_bytes, max_interp_state_bytes, max_decim_state_bytes);
+}
+
+//=====================================================================
+// Instrumentation
+//
+// With CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION, each state gets a block of counters at the end of its
+// persistent data. The audio thread is the only writer, so a relaxed load + store is enough to keep
+// each counter readable (atomically) from other threads, without any locked instructions.
+
+#if CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION
+static unsigned long long read_cycle_counter()
+{
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    return __rdtsc();
+#elif defined(_M_ARM64)
+    return (unsigned long long) _ReadStatusReg (ARM64_CNTVCT);
+#elif defined(__aarch64__)
+    unsigned long long ticks;
+    asm volatile ("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void add_to_counter (unsigned long long& counter, unsigned long long value)
+{
+    std::atomic_ref<unsigned long long> counter_ref { counter };
+    counter_ref.store (counter_ref.load (std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/** Accumulates the time spent in each stage of a process call. */
+struct Stage_Timer
+{
+    explicit Stage_Timer (Polyphase_FIR_Stats* stats_to_update)
+        : stats (stats_to_update),
+          stage_start (read_cycle_counter())
+    {
+    }
+
+    void end_stage (Polyphase_FIR_Stage stage)
+    {
+        const auto now = read_cycle_counter();
+        add_to_counter (stats->cycles[stage], now - stage_start);
+        stage_start = now;
+    }
+
+    void end_call (int n_samples_in)
+    {
+        add_to_counter (stats->calls, 1);
+        add_to_counter (stats->samples_in, (unsigned long long) n_samples_in);
+    }
+
+    Polyphase_FIR_Stats* stats;
+    unsigned long long stage_start;
+};
+
+static constexpr size_t stats_bytes = sizeof (Polyphase_FIR_Stats);
+#else
+struct Stage_Timer
+{
+    explicit Stage_Timer (Polyphase_FIR_Stats*) {}
+    void end_stage (Polyphase_FIR_Stage) {}
+    void end_call (int) {}
+};
+
+static constexpr size_t stats_bytes = 0;
+#endif
+
+bool get_stats (const Polyphase_FIR_State* state, Polyphase_FIR_Stats* stats)
+{
+    *stats = {};
+#if CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION
+    auto& state_stats = *state->stats;
+    stats->calls = std::atomic_ref { state_stats.calls }.load (std::memory_order_relaxed);
+    stats->samples_in = std::atomic_ref { state_stats.samples_in }.load (std::memory_order_relaxed);
+    for (int stage = 0; stage < FIR_Num_Stages; ++stage)
+        stats->cycles[stage] = std::atomic_ref { state_stats.cycles[stage] }.load (std::memory_order_relaxed);
+    return true;
+#else
+    (void) state;
+    return false;
+#endif
+}
+
+void reset_stats (Polyphase_FIR_State* state)
+{
+    if (state->stats != nullptr)
+        *state->stats = {};
+}
+
 size_t persistent_bytes_required (int n_channels, int n_taps, int factor, int max_samples_in, int alignment)
+{
+    return persistent_bytes_required_with_flags (n_channels, n_taps, factor, max_samples_in, FIR_Flags_None, alignment);
+}
+
+size_t persistent_bytes_required_with_flags (int n_channels, int n_taps, int factor, int max_samples_in, int flags, int alignment)
 {
     const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_FIR_State), alignment);
-    const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = get_coeffs_state_bytes (n_channels, n_taps, factor, max_samples_in, alignment);
-    return state_object_bytes + coeffs_bytes + interp_state_bytes + decim_state_bytes;
+    const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = get_coeffs_state_bytes (n_channels, n_taps, factor, max_samples_in, flags, alignment);
+    return state_object_bytes + coeffs_bytes + interp_state_bytes + decim_state_bytes + stats_bytes;
 }
 
 Polyphase_FIR_State* init (int n_channels, int n_taps, int factor, int max_samples_in, void* persistent_data, int alignment)
 {
+    return init_with_flags (n_channels, n_taps, factor, max_samples_in, FIR_Flags_None, persistent_data, alignment);
+}
+
+static Polyphase_FIR_State* init_with_layout (int n_channels,
+                                              int n_taps,
+                                              int factor,
+                                              int max_samples_in,
+                                              int flags,
+                                              std::tuple<size_t, size_t, size_t> layout_bytes,
+                                              void* persistent_data,
+                                              int alignment)
+{
+    assert ((flags & half_coeffs_flags) != half_coeffs_flags);
+    assert ((flags & half_coeffs_flags) == 0 || (flags & FIR_Flag_Per_Channel_Coeffs) == 0);
+    assert ((flags & complex_flags) == 0 || (flags & ~complex_flags) == 0);
+
     auto* data = (std::byte*) persistent_data;
 
     // "allocate" state object
@@ -99,118 +397,813 @@ Polyphase_FIR_State* init (int n_channels, int n_taps, int factor, int max_sampl
     // initialize state
     *state = {};
     state->n_channels = n_channels;
-    state->taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, alignment);
-    state->state_per_filter_padded = get_state_per_filter_padded (state->taps_per_filter_padded, max_samples_in, alignment);
+    state->taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, flags, alignment);
+    state->state_per_filter_padded = get_state_per_filter_padded (state->taps_per_filter_padded, max_samples_in * get_floats_per_sample (flags), alignment);
     state->factor = factor;
+    state->flags = flags;
+    state->max_samples_in = max_samples_in;
+    state->alignment = alignment;
+    for (int i = 0; i < 8; ++i)
+        state->dither_state[i] = 0x9e3779b9u * (unsigned int) (i + 1); // any non-zero seeds will do
 
-    const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = get_coeffs_state_bytes (n_channels, n_taps, factor, max_samples_in, alignment);
-    state->coeffs = reinterpret_cast<float*> (data);
+    const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = layout_bytes;
+    state->coeffs = (flags & FIR_Flag_External_Coeffs) == 0 ? reinterpret_cast<float*> (data) : nullptr;
     data += coeffs_bytes;
     state->interp_state = reinterpret_cast<float*> (data);
     data += interp_state_bytes;
     state->decim_state = reinterpret_cast<float*> (data);
     data += decim_state_bytes;
+    if constexpr (stats_bytes > 0)
+    {
+        state->stats = reinterpret_cast<Polyphase_FIR_Stats*> (data);
+        *state->stats = {};
+    }
+
+    // channels in a group that are never loaded should still have well-defined coefficients
+    if ((flags & FIR_Flag_Per_Channel_Coeffs) != 0 && coeffs_bytes > 0)
+        std::memset (state->coeffs, 0, coeffs_bytes);
 
     reset (state);
 
     return state;
 }
 
+Polyphase_FIR_State* init_with_flags (int n_channels, int n_taps, int factor, int max_samples_in, int flags, void* persistent_data, int alignment)
+{
+    return init_with_layout (n_channels,
+                             n_taps,
+                             factor,
+                             max_samples_in,
+                             flags,
+                             get_coeffs_state_bytes (n_channels, n_taps, factor, max_samples_in, flags, alignment),
+                             persistent_data,
+                             alignment);
+}
+
+size_t persistent_bytes_required_max_factor (int n_channels, int max_n_taps, int max_factor, int max_samples_in, int flags, int alignment)
+{
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_FIR_State), alignment);
+    const auto [coeffs_bytes, interp_state_bytes, decim_state_bytes] = get_max_factor_coeffs_state_bytes (n_channels, max_n_taps, max_factor, max_samples_in, flags, alignment);
+    return state_object_bytes + coeffs_bytes + interp_state_bytes + decim_state_bytes + stats_bytes;
+}
+
+Polyphase_FIR_State* init_max_factor (int n_channels, int max_n_taps, int max_factor, int max_samples_in, int flags, void* persistent_data, int alignment)
+{
+    assert ((flags & complex_flags) == 0);
+    auto* state = init_with_layout (n_channels,
+                                    max_n_taps,
+                                    max_factor,
+                                    max_samples_in,
+                                    flags,
+                                    get_max_factor_coeffs_state_bytes (n_channels, max_n_taps, max_factor, max_samples_in, flags, alignment),
+                                    persistent_data,
+                                    alignment);
+    state->max_factor = max_factor;
+    state->max_n_taps = max_n_taps;
+    return state;
+}
+
+/**
+ * Splits a prototype filter into `n_filters` reversed + zero-padded polyphase filters.
+ * Tap `j` of filter `i` is taken from prototype index `i + j * factor + src_offset`.
+ */
+static void load_polyphase_coeffs (float* dest_coeffs,
+                                   int taps_per_filter_padded,
+                                   int n_filters,
+                                   int factor,
+                                   int src_offset,
+                                   const float* coeffs,
+                                   int n_taps)
+{
+    const auto coeffs_bytes = taps_per_filter_padded * n_filters * sizeof (float);
+    std::memset (dest_coeffs, 0, coeffs_bytes);
+
+    for (int i = 0; i < n_filters; ++i)
+    {
+        auto* filter_coeffs = dest_coeffs + taps_per_filter_padded * i;
+        for (int j = 0; j < taps_per_filter_padded; ++j)
+        {
+            const auto src_idx = i + j * factor + src_offset;
+            const auto dest_idx = taps_per_filter_padded - j - 1;
+            filter_coeffs[dest_idx] = (src_idx < 0 || src_idx >= n_taps) ? 0.0f : coeffs[src_idx]; // reverse coefficients
+        }
+    }
+}
+
+/** Rounds to the nearest fp16 value (ties to even), saturating to infinity. */
+static uint16_t float_to_half (float value)
+{
+    uint32_t x;
+    std::memcpy (&x, &value, sizeof (x));
+    const auto sign = (uint16_t) ((x >> 16) & 0x8000);
+    x &= 0x7fffffff;
+
+    if (x >= 0x47800000) // too large for fp16, or inf/NaN
+        return sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+    if (x < 0x38800000) // fp16 subnormal: let a float addition do the rounding
+    {
+        float shifted;
+        std::memcpy (&shifted, &x, sizeof (x));
+        shifted += 0.5f;
+        uint32_t y;
+        std::memcpy (&y, &shifted, sizeof (y));
+        return sign | (uint16_t) (y - 0x3f000000);
+    }
+
+    const auto mantissa_odd = (x >> 13) & 1;
+    x += ((uint32_t) (15 - 127) << 23) + 0xfff + mantissa_odd;
+    return sign | (uint16_t) (x >> 13);
+}
+
+/** Rounds to the nearest bf16 value (ties to even). */
+static uint16_t float_to_bfloat16 (float value)
+{
+    uint32_t x;
+    std::memcpy (&x, &value, sizeof (x));
+    if ((x & 0x7fffffff) > 0x7f800000) // keep NaNs quiet
+        return (uint16_t) ((x >> 16) | 0x40);
+    return (uint16_t) ((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+/** Widens an fp16 or bf16 value back to float (the scalar equivalent of the kernels' `load_half_coeffs()`). */
+static float half_to_float (uint16_t value, bool is_bf16)
+{
+    uint32_t x;
+    if (is_bf16)
+    {
+        x = (uint32_t) value << 16;
+    }
+    else
+    {
+        const auto sign = (uint32_t) (value & 0x8000) << 16;
+        const auto exponent = (uint32_t) (value >> 10) & 0x1f;
+        const auto mantissa = (uint32_t) value & 0x3ff;
+        if (exponent == 0) // zero or subnormal
+        {
+            const auto magnitude = (float) mantissa * (1.0f / 16777216.0f);
+            std::memcpy (&x, &magnitude, sizeof (x));
+            x |= sign;
+        }
+        else if (exponent == 0x1f) // inf/NaN
+        {
+            x = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else
+        {
+            x = sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+        }
+    }
+
+    float result;
+    std::memcpy (&result, &x, sizeof (result));
+    return result;
+}
+
+/** Same layout as `load_polyphase_coeffs()`, but rounded to fp16 or bf16. */
+static void load_polyphase_coeffs_half (uint16_t* dest_coeffs,
+                                        int taps_per_filter_padded,
+                                        int factor,
+                                        bool is_bf16,
+                                        const float* coeffs,
+                                        int n_taps,
+                                        float gain)
+{
+    for (int i = 0; i < factor; ++i)
+    {
+        auto* filter_coeffs = dest_coeffs + taps_per_filter_padded * i;
+        for (int j = 0; j < taps_per_filter_padded; ++j)
+        {
+            const auto src_idx = i + j * factor;
+            const auto coeff = src_idx < n_taps ? coeffs[src_idx] * gain : 0.0f;
+            filter_coeffs[taps_per_filter_padded - j - 1] = is_bf16 ? float_to_bfloat16 (coeff) : float_to_half (coeff); // reverse coefficients
+        }
+    }
+}
+
+/**
+ * Same as `load_polyphase_coeffs()`, for a filter with complex samples. Each (complex) tap is duplicated
+ * across the I and Q lanes. With complex coefficients, the real parts go in the first table, and a second table
+ * holds (-imag, imag) pairs, which the kernels multiply with the (Q, I) swapped samples.
+ */
+static void load_polyphase_coeffs_complex (float* dest_coeffs,
+                                           int taps_per_filter_padded,
+                                           int factor,
+                                           bool complex_coeffs,
+                                           const float* coeffs,
+                                           int n_taps,
+                                           float gain)
+{
+    const auto table_size = taps_per_filter_padded * factor;
+    std::memset (dest_coeffs, 0, (size_t) (table_size * (complex_coeffs ? 2 : 1)) * sizeof (float));
+
+    const auto complex_taps_per_filter = taps_per_filter_padded / 2;
+    for (int i = 0; i < factor; ++i)
+    {
+        auto* filter_coeffs = dest_coeffs + taps_per_filter_padded * i;
+        for (int j = 0; j < complex_taps_per_filter; ++j)
+        {
+            const auto src_idx = i + j * factor;
+            if (src_idx >= n_taps)
+                break;
+
+            const auto dest_idx = 2 * (complex_taps_per_filter - j - 1); // reverse coefficients
+            const auto re = gain * (complex_coeffs ? coeffs[2 * src_idx] : coeffs[src_idx]);
+            filter_coeffs[dest_idx] = re;
+            filter_coeffs[dest_idx + 1] = re;
+            if (complex_coeffs)
+            {
+                const auto im = gain * coeffs[2 * src_idx + 1];
+                filter_coeffs[table_size + dest_idx] = -im;
+                filter_coeffs[table_size + dest_idx + 1] = im;
+            }
+        }
+    }
+}
+
 void load_coeffs (Polyphase_FIR_State* state, const float* coeffs, int n_taps)
 {
-    const auto coeffs_bytes = state->taps_per_filter_padded * state->factor * sizeof (float);
-    std::memset (state->coeffs, 0, coeffs_bytes);
+    load_coeffs_with_gain (state, coeffs, n_taps, 1.0f);
+}
+
+void load_coeffs_with_gain (Polyphase_FIR_State* state, const float* coeffs, int n_taps, float gain)
+{
+    assert ((state->flags & FIR_Flag_External_Coeffs) == 0);
+    if ((state->flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+    {
+        for (int ch = 0; ch < state->n_channels; ++ch)
+            load_coeffs_channel_with_gain (state, ch, coeffs, n_taps, gain);
+        return;
+    }
 
+    if ((state->flags & complex_flags) != 0)
+    {
+        assert ((state->flags & FIR_Flag_Complex_Coeffs) == 0); // complex coefficients are loaded with load_coeffs_complex()
+        load_polyphase_coeffs_complex (state->coeffs, state->taps_per_filter_padded, state->factor, false, coeffs, n_taps, gain);
+        return;
+    }
+
+    if ((state->flags & half_coeffs_flags) != 0)
+    {
+        // the gain is applied before rounding, so the coefficients are as accurate as they can be
+        load_polyphase_coeffs_half (reinterpret_cast<uint16_t*> (state->coeffs),
+                                    state->taps_per_filter_padded,
+                                    state->factor,
+                                    (state->flags & FIR_Flag_Coeffs_BF16) != 0,
+                                    coeffs,
+                                    n_taps,
+                                    gain);
+        return;
+    }
+
+    load_polyphase_coeffs (state->coeffs,
+                           state->taps_per_filter_padded,
+                           state->factor,
+                           state->factor,
+                           0,
+                           coeffs,
+                           n_taps);
+    for (int i = 0; i < state->taps_per_filter_padded * state->factor; ++i)
+        state->coeffs[i] *= gain;
+}
+
+void load_coeffs_channel (Polyphase_FIR_State* state, int channel, const float* coeffs, int n_taps)
+{
+    load_coeffs_channel_with_gain (state, channel, coeffs, n_taps, 1.0f);
+}
+
+void load_coeffs_channel_with_gain (Polyphase_FIR_State* state, int channel, const float* coeffs, int n_taps, float gain)
+{
+    assert ((state->flags & FIR_Flag_Per_Channel_Coeffs) != 0 && (state->flags & FIR_Flag_External_Coeffs) == 0);
+    assert (channel >= 0 && channel < state->n_channels);
+    assert (n_taps <= state->taps_per_filter_padded * state->factor);
+
+    // Same reversed polyphase layout as `load_polyphase_coeffs()`,
+    // but tap `j` of each filter is followed by tap `j` of the other channels in the group.
+    const auto group_idx = channel / channel_group_size;
+    const auto lane = channel % channel_group_size;
+    const auto filter_stride = state->taps_per_filter_padded * channel_group_size;
+    auto* group_coeffs = state->coeffs + group_idx * filter_stride * state->factor;
     for (int i = 0; i < state->factor; ++i)
     {
-        auto* filter_coeffs = state->coeffs + state->taps_per_filter_padded * i;
+        auto* filter_coeffs = group_coeffs + filter_stride * i;
         for (int j = 0; j < state->taps_per_filter_padded; ++j)
         {
             const auto src_idx = i + j * state->factor;
             const auto dest_idx = state->taps_per_filter_padded - j - 1;
-            filter_coeffs[dest_idx] = src_idx >= n_taps ? 0.0f : coeffs[src_idx]; // reverse coefficients
+            filter_coeffs[dest_idx * channel_group_size + lane] = src_idx < n_taps ? coeffs[src_idx] * gain : 0.0f; // reverse coefficients
         }
     }
 }
 
+void load_coeffs_complex (Polyphase_FIR_State* state, const float* coeffs, int n_taps)
+{
+    assert ((state->flags & FIR_Flag_Complex_Coeffs) != 0);
+    load_polyphase_coeffs_complex (state->coeffs, state->taps_per_filter_padded, state->factor, true, coeffs, n_taps, 1.0f);
+}
+
 void reset (Polyphase_FIR_State* state)
 {
-    const auto interp_state_bytes = state->state_per_filter_padded * state->n_channels * sizeof (float);
+    const auto n_state_channels = (state->flags & FIR_Flag_Per_Channel_Coeffs) != 0
+                                      ? get_n_channel_groups (state->n_channels) * channel_group_size
+                                      : state->n_channels;
+    const auto interp_state_bytes = state->state_per_filter_padded * n_state_channels * sizeof (float);
     std::memset (state->interp_state, 0, interp_state_bytes);
 
-    const auto decim_state_bytes = state->state_per_filter_padded * state->factor * state->n_channels * sizeof (float);
+    const auto decim_state_bytes = state->state_per_filter_padded * state->factor * n_state_channels * sizeof (float);
     std::memset (state->decim_state, 0, decim_state_bytes);
 }
 
+void set_factor (Polyphase_FIR_State* state, int factor, int n_taps)
+{
+    assert (factor >= 1 && factor <= state->max_factor);
+    assert (n_taps <= state->max_n_taps);
+
+    const auto old_taps_per_filter_padded = state->taps_per_filter_padded;
+    const auto old_state_per_filter_padded = state->state_per_filter_padded;
+    state->factor = factor;
+    state->taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, state->flags, state->alignment);
+    state->state_per_filter_padded = get_state_per_filter_padded (state->taps_per_filter_padded, state->max_samples_in, state->alignment);
+
+    const auto per_channel_coeffs = (state->flags & FIR_Flag_Per_Channel_Coeffs) != 0;
+    const auto lanes_per_row = per_channel_coeffs ? channel_group_size : 1;
+    const auto n_rows = per_channel_coeffs ? get_n_channel_groups (state->n_channels) : state->n_channels;
+
+    // The interpolator's history is made of input samples at the lower sample rate, which doesn't change,
+    // so each channel keeps its most recent samples. Its stride in the state may grow or shrink though,
+    // so the channels are moved in the order that doesn't overwrite the history of a channel that hasn't moved yet.
+    const auto old_stride = old_state_per_filter_padded * lanes_per_row;
+    const auto new_stride = state->state_per_filter_padded * lanes_per_row;
+    const auto samples_to_keep = (min_int (old_taps_per_filter_padded, state->taps_per_filter_padded) - 1) * lanes_per_row;
+    const auto old_history_start = (old_taps_per_filter_padded - 1) * lanes_per_row - samples_to_keep;
+    const auto new_history_start = (state->taps_per_filter_padded - 1) * lanes_per_row - samples_to_keep;
+    for (int i = 0; i < n_rows; ++i)
+    {
+        const auto row = new_stride > old_stride ? n_rows - 1 - i : i;
+        auto* row_state = state->interp_state + row * new_stride;
+        std::memmove (row_state + new_history_start,
+                      state->interp_state + row * old_stride + old_history_start,
+                      (size_t) samples_to_keep * sizeof (float));
+        std::memset (row_state, 0, (size_t) new_history_start * sizeof (float));
+    }
+
+    // The decimator's history is at the old (higher) sample rate, so it can't be re-used.
+    const auto decim_state_bytes = (size_t) state->state_per_filter_padded * (size_t) factor * (size_t) (n_rows * lanes_per_row) * sizeof (float);
+    std::memset (state->decim_state, 0, decim_state_bytes);
+
+    // the coefficients are silent until the next `load_coeffs()`
+    if (state->coeffs != nullptr && (state->flags & FIR_Flag_External_Coeffs) == 0)
+    {
+        const auto coeff_size = (state->flags & half_coeffs_flags) != 0 ? sizeof (uint16_t) : sizeof (float);
+        const auto n_coeff_groups = per_channel_coeffs ? n_rows : 1;
+        std::memset (state->coeffs, 0, (size_t) state->taps_per_filter_padded * (size_t) factor * (size_t) (n_coeff_groups * lanes_per_row) * coeff_size);
+    }
+}
+
 size_t scratch_bytes_required (int n_taps, int factor, int max_samples_in, int alignment)
 {
-    const auto v_size = alignment / (int) sizeof (float);
+    // the kernels keep their accumulators in registers, so the scratch only needs to hold
+    // one row of interpolator outputs, or the history being saved for the next buffer
     const auto taps_per_filter_padded = get_taps_per_filter_padded (n_taps, factor, alignment);
     const auto buffer_bytes_padded = round_to_next_multiple (
-        max_int (taps_per_filter_padded + max_samples_in, max_samples_in * v_size) * (int) sizeof (float),
+        max_int (taps_per_filter_padded, max_samples_in) * (int) sizeof (float),
         alignment);
     return buffer_bytes_padded;
 }
 
-void process_interpolate (Polyphase_FIR_State* state,
-                          const float* const* in,
-                          float* const* out,
-                          int n_channels,
-                          int n_samples_in,
-                          void* scratch_data,
-                          [[maybe_unused]] bool use_avx)
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+static bool cpu_supports_avx2_fma()
 {
-    auto* scratch_start = (float*) scratch_data;
-    [[maybe_unused]] const auto n_samples_out = n_samples_in * state->factor;
+#if ! CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX
+    return false;
+#elif defined(_MSC_VER)
+    int info[4] {};
+    __cpuid (info, 0);
+    if (info[0] < 7)
+        return false;
 
-    for (int ch = 0; ch < n_channels; ++ch)
+    __cpuid (info, 1);
+    const auto has_fma = (info[2] & (1 << 12)) != 0;
+    const auto has_f16c = (info[2] & (1 << 29)) != 0;
+    const auto has_os_avx_support = (info[2] & (1 << 27)) != 0 && (_xgetbv (0) & 0x6) == 0x6;
+    if (! has_fma || ! has_f16c || ! has_os_avx_support)
+        return false;
+
+    __cpuidex (info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma") && __builtin_cpu_supports ("f16c");
+#endif
+}
+#endif
+
+bool kernel_available (Polyphase_FIR_Kernel kernel)
+{
+    switch (kernel)
     {
-        auto* ch_state = state->interp_state + ch * state->state_per_filter_padded;
+        case FIR_Kernel_Auto:
+            return true;
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        case FIR_Kernel_SSE:
+        case FIR_Kernel_SSE_Blocked:
+            return true;
+        case FIR_Kernel_AVX:
+        case FIR_Kernel_AVX_Blocked:
+            return cpu_supports_avx2_fma();
+#elif CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+        case FIR_Kernel_Generic:
+        case FIR_Kernel_Generic_Blocked:
+            return true;
+#else
+        case FIR_Kernel_NEON:
+        case FIR_Kernel_NEON_Blocked:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
 
-        { // copy x_data into ch_state
-            auto* x_data = in[ch];
-            std::memcpy (ch_state + state->taps_per_filter_padded - 1,
-                         x_data,
-                         n_samples_in * sizeof (float));
-        }
+void set_kernels (Polyphase_FIR_State* state, Polyphase_FIR_Kernel interp_kernel, Polyphase_FIR_Kernel decim_kernel)
+{
+    assert (kernel_available (interp_kernel) && kernel_available (decim_kernel));
+    state->interp_kernel = interp_kernel;
+    state->decim_kernel = decim_kernel;
+}
 
-        // apply filters
-#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
-        if (use_avx)
-            avx::process_fir_interp (state, ch_state, out[ch], n_samples_in, scratch_start);
-        else
-            sse::process_fir_interp (state, ch_state, out[ch], n_samples_in, scratch_start);
+/** Returns the kernel stored in the state, or if there isn't one, the kernel chosen by `use_avx`. */
+static int get_kernel (int state_kernel, [[maybe_unused]] bool use_avx)
+{
+    if (state_kernel != FIR_Kernel_Auto)
+        return state_kernel;
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+    return use_avx ? FIR_Kernel_AVX : FIR_Kernel_SSE;
+#elif CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD
+    return FIR_Kernel_Generic;
 #else
-        neon::process_fir_interp (state, ch_state, out[ch], n_samples_in, scratch_start);
+    return FIR_Kernel_NEON;
 #endif
+}
 
-        { // save channel state for next buffer
-            auto* scratch = scratch_start;
-            const auto samples_to_save = state->taps_per_filter_padded - 1;
-            std::memcpy (scratch,
-                         ch_state + n_samples_in,
-                         samples_to_save * sizeof (float));
-            std::memcpy (ch_state,
-                         scratch,
-                         samples_to_save * sizeof (float));
-        }
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+static bool is_avx_kernel (int kernel)
+{
+    return kernel == FIR_Kernel_AVX || kernel == FIR_Kernel_AVX_Blocked;
+}
+#endif
+
+template <bool accumulate>
+static void apply_fir_interp (int kernel,
+                              const Polyphase_FIR_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              int n_samples_in,
+                              float* scratch,
+                              float gain)
+{
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+    if ((state->flags & half_coeffs_flags) != 0)
+    {
+        if (is_avx_kernel (kernel))
+            avx::process_fir_interp_half<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+        else
+            sse::process_fir_interp_half<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+        return;
+    }
+
+    switch (kernel)
+    {
+        case FIR_Kernel_AVX:
+            avx::process_fir_interp<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+            break;
+        case FIR_Kernel_AVX_Blocked:
+            avx::process_fir_interp_blocked<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+            break;
+        case FIR_Kernel_SSE_Blocked:
+            sse::process_fir_interp_blocked<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+            break;
+        default:
+            sse::process_fir_interp<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+            break;
     }
+#else
+    if ((state->flags & half_coeffs_flags) != 0)
+        simd_128::process_fir_interp_half<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else if (kernel == FIR_Kernel_NEON_Blocked || kernel == FIR_Kernel_Generic_Blocked)
+        simd_128::process_fir_interp_blocked<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else
+        simd_128::process_fir_interp<accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+#endif
 }
 
-void process_decimate (struct Polyphase_FIR_State* state,
-                       const float* const* in,
-                       float* const* out,
-                       int n_channels,
-                       int n_samples_in,
-                       void* scratch_data,
-                       [[maybe_unused]] bool use_avx)
+template <bool accumulate>
+static void apply_fir_decim (int kernel,
+                             const Polyphase_FIR_State* state,
+                             const float* ch_state,
+                             float* y_data,
+                             int n_samples_out,
+                             float* scratch,
+                             float gain)
 {
-    auto* scratch_start = (float*) scratch_data;
-    [[maybe_unused]] const auto n_samples_out = n_samples_in / state->factor;
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+    if ((state->flags & half_coeffs_flags) != 0)
+    {
+        if (is_avx_kernel (kernel))
+            avx::process_fir_decim_half<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+        else
+            sse::process_fir_decim_half<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+        return;
+    }
 
-    for (int ch = 0; ch < n_channels; ++ch)
+    switch (kernel)
     {
-        auto* ch_state = state->decim_state + ch * (state->state_per_filter_padded * state->factor);
+        case FIR_Kernel_AVX:
+            avx::process_fir_decim<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+            break;
+        case FIR_Kernel_AVX_Blocked:
+            avx::process_fir_decim_blocked<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+            break;
+        case FIR_Kernel_SSE_Blocked:
+            sse::process_fir_decim_blocked<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+            break;
+        default:
+            sse::process_fir_decim<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+            break;
+    }
+#else
+    if ((state->flags & half_coeffs_flags) != 0)
+        simd_128::process_fir_decim_half<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+    else if (kernel == FIR_Kernel_NEON_Blocked || kernel == FIR_Kernel_Generic_Blocked)
+        simd_128::process_fir_decim_blocked<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+    else
+        simd_128::process_fir_decim<accumulate> (state, ch_state, y_data, n_samples_out, scratch, gain);
+#endif
+}
+
+template <bool accumulate>
+static void process_interpolate_channel_groups (Polyphase_FIR_State* state,
+                                                const float* const* in,
+                                                float* const* out,
+                                                int n_channels,
+                                                int n_samples_in,
+                                                [[maybe_unused]] int kernel,
+                                                const float* gains,
+                                                Stage_Timer& timer)
+{
+    const auto group_state_size = state->state_per_filter_padded * channel_group_size;
+    const auto group_coeffs_size = state->taps_per_filter_padded * state->factor * channel_group_size;
+
+    for (int group_start = 0; group_start < n_channels; group_start += channel_group_size)
+    {
+        const auto group_idx = group_start / channel_group_size;
+        const auto n_lanes = min_int (channel_group_size, n_channels - group_start);
+        auto* group_state = state->interp_state + group_idx * group_state_size;
+        const auto* group_coeffs = state->coeffs + group_idx * group_coeffs_size;
+
+        float group_gains[channel_group_size];
+        for (int lane = 0; lane < n_lanes; ++lane)
+            group_gains[lane] = gains != nullptr ? gains[group_start + lane] : 1.0f;
+
+        { // interleave x_data into group_state
+            auto* x_state = group_state + (state->taps_per_filter_padded - 1) * channel_group_size;
+            for (int lane = 0; lane < n_lanes; ++lane)
+            {
+                const auto* x_data = in[group_start + lane];
+                for (int n = 0; n < n_samples_in; ++n)
+                    x_state[n * channel_group_size + lane] = x_data[n];
+            }
+        }
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        // apply filters
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        if (is_avx_kernel (kernel))
+            avx::process_fir_interp_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_in, group_gains);
+        else
+            sse::process_fir_interp_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_in, group_gains);
+#else
+        simd_128::process_fir_interp_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_in, group_gains);
+#endif
+        timer.end_stage (FIR_Stage_Kernel);
+
+        // save group state for next buffer
+        std::memmove (group_state,
+                      group_state + n_samples_in * channel_group_size,
+                      (state->taps_per_filter_padded - 1) * channel_group_size * sizeof (float));
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+}
+
+template <bool accumulate>
+static void process_decimate_channel_groups (Polyphase_FIR_State* state,
+                                             const float* const* in,
+                                             float* const* out,
+                                             int n_channels,
+                                             int n_samples_out,
+                                             [[maybe_unused]] int kernel,
+                                             const float* gains,
+                                             Stage_Timer& timer)
+{
+    const auto filter_state_size = state->state_per_filter_padded * channel_group_size;
+    const auto group_state_size = filter_state_size * state->factor;
+    const auto group_coeffs_size = state->taps_per_filter_padded * state->factor * channel_group_size;
+    const auto samples_to_save = (state->taps_per_filter_padded - 1) * channel_group_size;
+
+    for (int group_start = 0; group_start < n_channels; group_start += channel_group_size)
+    {
+        const auto group_idx = group_start / channel_group_size;
+        const auto n_lanes = min_int (channel_group_size, n_channels - group_start);
+        auto* group_state = state->decim_state + group_idx * group_state_size;
+        const auto* group_coeffs = state->coeffs + group_idx * group_coeffs_size;
+
+        float group_gains[channel_group_size];
+        for (int lane = 0; lane < n_lanes; ++lane)
+            group_gains[lane] = gains != nullptr ? gains[group_start + lane] : 1.0f;
+
+        { // de-interleave x_data by phase, and interleave across channels into group_state
+            for (int lane = 0; lane < n_lanes; ++lane)
+            {
+                const auto* x_data = in[group_start + lane];
+                auto* filter_state = group_state + (state->taps_per_filter_padded - 1) * channel_group_size + lane;
+                for (int n = 0; n < n_samples_out; ++n)
+                    filter_state[n * channel_group_size] = x_data[n * state->factor];
+
+                for (int filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+                {
+                    filter_state = group_state + (state->factor - filter_idx) * filter_state_size
+                                   + state->taps_per_filter_padded * channel_group_size + lane;
+                    for (int n = 0; n < n_samples_out; ++n)
+                        filter_state[n * channel_group_size] = x_data[n * state->factor + filter_idx];
+                }
+            }
+        }
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        // apply filters
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        if (is_avx_kernel (kernel))
+            avx::process_fir_decim_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_out, group_gains);
+        else
+            sse::process_fir_decim_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_out, group_gains);
+#else
+        simd_128::process_fir_decim_channels<accumulate> (state, group_coeffs, group_state, out + group_start, n_lanes, n_samples_out, group_gains);
+#endif
+        timer.end_stage (FIR_Stage_Kernel);
+
+        { // save group state for next buffer
+            std::memmove (group_state,
+                          group_state + n_samples_out * channel_group_size,
+                          samples_to_save * sizeof (float));
+            for (int filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+            {
+                auto* filter_state = group_state + filter_idx * filter_state_size;
+                std::memmove (filter_state,
+                              filter_state + n_samples_out * channel_group_size,
+                              (samples_to_save + channel_group_size) * sizeof (float));
+            }
+        }
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+}
+
+/** Copies the end of the channel's input back to the start of its state, for the next buffer */
+static void save_interp_state (const Polyphase_FIR_State* state, float* ch_state, int n_samples_in, float* scratch)
+{
+    const auto samples_to_save = state->taps_per_filter_padded - 1;
+    std::memcpy (scratch,
+                 ch_state + n_samples_in,
+                 samples_to_save * sizeof (float));
+    std::memcpy (ch_state,
+                 scratch,
+                 samples_to_save * sizeof (float));
+}
+
+/** Returns where the new input samples for polyphase filter `filter_idx` go, in the channel's decimation state */
+static int get_decim_input_offset (const Polyphase_FIR_State* state, int filter_idx)
+{
+    if (filter_idx == 0)
+        return state->taps_per_filter_padded - 1;
+    return (state->factor - filter_idx) * state->state_per_filter_padded + state->taps_per_filter_padded;
+}
+
+static void save_decim_state (const Polyphase_FIR_State* state, float* ch_state, int n_samples_out, float* scratch)
+{
+    int filter_idx = 0;
+    auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded;
+    auto samples_to_save = state->taps_per_filter_padded - 1;
+    std::memcpy (scratch,
+                 filter_state + n_samples_out,
+                 samples_to_save * sizeof (float));
+    std::memcpy (filter_state,
+                 scratch,
+                 samples_to_save * sizeof (float));
+    for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+    {
+        // these filters read one sample further back than the first filter
+        filter_state = ch_state + filter_idx * state->state_per_filter_padded;
+        samples_to_save = state->taps_per_filter_padded;
+        std::memcpy (scratch,
+                     filter_state + n_samples_out,
+                     samples_to_save * sizeof (float));
+        std::memcpy (filter_state,
+                     scratch,
+                     samples_to_save * sizeof (float));
+    }
+}
+
+void process_interpolate_with_gain (Polyphase_FIR_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    const float* gains,
+                                    bool accumulate,
+                                    int n_channels,
+                                    int n_samples_in,
+                                    void* scratch_data,
+                                    [[maybe_unused]] bool use_avx)
+{
+    assert ((state->flags & complex_flags) == 0); // see process_interpolate_complex()
+    auto* scratch_start = (float*) scratch_data;
+    [[maybe_unused]] const auto n_samples_out = n_samples_in * state->factor;
+    const auto kernel = get_kernel (state->interp_kernel, use_avx);
+    Stage_Timer timer { state->stats };
+
+    if ((state->flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+    {
+        if (accumulate)
+            process_interpolate_channel_groups<true> (state, in, out, n_channels, n_samples_in, kernel, gains, timer);
+        else
+            process_interpolate_channel_groups<false> (state, in, out, n_channels, n_samples_in, kernel, gains, timer);
+        timer.end_call (n_samples_in);
+        return;
+    }
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->interp_state + ch * state->state_per_filter_padded;
+
+        { // copy x_data into ch_state
+            auto* x_data = in[ch];
+            std::memcpy (ch_state + state->taps_per_filter_padded - 1,
+                         x_data,
+                         n_samples_in * sizeof (float));
+        }
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        // apply filters
+        const auto gain = gains != nullptr ? gains[ch] : 1.0f;
+        if (accumulate)
+            apply_fir_interp<true> (kernel, state, ch_state, out[ch], n_samples_in, scratch_start, gain);
+        else
+            apply_fir_interp<false> (kernel, state, ch_state, out[ch], n_samples_in, scratch_start, gain);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        // save channel state for next buffer
+        save_interp_state (state, ch_state, n_samples_in, scratch_start);
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+void process_interpolate (Polyphase_FIR_State* state,
+                          const float* const* in,
+                          float* const* out,
+                          int n_channels,
+                          int n_samples_in,
+                          void* scratch_data,
+                          bool use_avx)
+{
+    process_interpolate_with_gain (state, in, out, nullptr, false, n_channels, n_samples_in, scratch_data, use_avx);
+}
+
+void process_decimate_with_gain (Polyphase_FIR_State* state,
+                                 const float* const* in,
+                                 float* const* out,
+                                 const float* gains,
+                                 bool accumulate,
+                                 int n_channels,
+                                 int n_samples_in,
+                                 void* scratch_data,
+                                 [[maybe_unused]] bool use_avx)
+{
+    assert ((state->flags & complex_flags) == 0); // see process_decimate_complex()
+    auto* scratch_start = (float*) scratch_data;
+    [[maybe_unused]] const auto n_samples_out = n_samples_in / state->factor;
+    const auto kernel = get_kernel (state->decim_kernel, use_avx);
+    Stage_Timer timer { state->stats };
+
+    if ((state->flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+    {
+        if (accumulate)
+            process_decimate_channel_groups<true> (state, in, out, n_channels, n_samples_out, kernel, gains, timer);
+        else
+            process_decimate_channel_groups<false> (state, in, out, n_channels, n_samples_out, kernel, gains, timer);
+        timer.end_call (n_samples_in);
+        return;
+    }
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->decim_state + ch * (state->state_per_filter_padded * state->factor);
 
         { // copy x_data into ch_state
             auto* x_data = in[ch];
@@ -221,45 +1214,1212 @@ void process_decimate (struct Polyphase_FIR_State* state,
 
             for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
             {
-                filter_state = ch_state + (state->factor - filter_idx) * state->state_per_filter_padded;
+                filter_state = ch_state + get_decim_input_offset (state, filter_idx);
                 for (int n = 0; n < n_samples_out; ++n)
-                    filter_state[state->taps_per_filter_padded + n] = x_data[n * state->factor + filter_idx];
+                    filter_state[n] = x_data[n * state->factor + filter_idx];
             }
         }
+        timer.end_stage (FIR_Stage_Input_Copy);
 
         // apply filters
-#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
-        if (use_avx)
-            avx::process_fir_decim (state, ch_state, out[ch], n_samples_out, scratch_start);
+        const auto gain = gains != nullptr ? gains[ch] : 1.0f;
+        if (accumulate)
+            apply_fir_decim<true> (kernel, state, ch_state, out[ch], n_samples_out, scratch_start, gain);
+        else
+            apply_fir_decim<false> (kernel, state, ch_state, out[ch], n_samples_out, scratch_start, gain);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        // save channel state for next buffer
+        save_decim_state (state, ch_state, n_samples_out, scratch_start);
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+void process_decimate (Polyphase_FIR_State* state,
+                       const float* const* in,
+                       float* const* out,
+                       int n_channels,
+                       int n_samples_in,
+                       void* scratch_data,
+                       bool use_avx)
+{
+    process_decimate_with_gain (state, in, out, nullptr, false, n_channels, n_samples_in, scratch_data, use_avx);
+}
+
+//=====================================================================
+// Complex samples
+//
+// The state has the same layout as for real samples, but each sample takes 2 floats
+// (see get_floats_per_sample()), so the history kept between blocks is 2 floats per sample.
+
+void process_interpolate_complex (Polyphase_FIR_State* state,
+                                  const float* const* in,
+                                  float* const* out,
+                                  int n_channels,
+                                  int n_samples_in)
+{
+    assert ((state->flags & complex_flags) != 0);
+    const auto complex_coeffs = (state->flags & FIR_Flag_Complex_Coeffs) != 0;
+    const auto history_size = state->taps_per_filter_padded - 2;
+    Stage_Timer timer { state->stats };
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->interp_state + ch * state->state_per_filter_padded;
+        std::memcpy (ch_state + history_size, in[ch], (size_t) (2 * n_samples_in) * sizeof (float));
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        if (complex_coeffs)
+            simd_128::process_fir_interp_complex<true> (state, ch_state, out[ch], n_samples_in);
+        else
+            simd_128::process_fir_interp_complex<false> (state, ch_state, out[ch], n_samples_in);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        std::memmove (ch_state, ch_state + 2 * n_samples_in, (size_t) history_size * sizeof (float));
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+void process_decimate_complex (Polyphase_FIR_State* state,
+                               const float* const* in,
+                               float* const* out,
+                               int n_channels,
+                               int n_samples_in)
+{
+    assert ((state->flags & complex_flags) != 0);
+    const auto complex_coeffs = (state->flags & FIR_Flag_Complex_Coeffs) != 0;
+    const auto n_samples_out = n_samples_in / state->factor;
+    Stage_Timer timer { state->stats };
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->decim_state + ch * (state->state_per_filter_padded * state->factor);
+
+        { // de-interleave the phases into ch_state (see get_decim_input_offset())
+            const auto* x_data = in[ch];
+            for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+            {
+                const auto input_offset = filter_idx == 0
+                                              ? state->taps_per_filter_padded - 2
+                                              : (state->factor - filter_idx) * state->state_per_filter_padded + state->taps_per_filter_padded;
+                auto* filter_state = ch_state + input_offset;
+                for (int n = 0; n < n_samples_out; ++n)
+                {
+                    filter_state[2 * n] = x_data[2 * (n * state->factor + filter_idx)];
+                    filter_state[2 * n + 1] = x_data[2 * (n * state->factor + filter_idx) + 1];
+                }
+            }
+        }
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        if (complex_coeffs)
+            simd_128::process_fir_decim_complex<true> (state, ch_state, out[ch], n_samples_out);
         else
-            sse::process_fir_decim (state, ch_state, out[ch], n_samples_out, scratch_start);
+            simd_128::process_fir_decim_complex<false> (state, ch_state, out[ch], n_samples_out);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            // the filters after the first read one sample further back
+            auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded;
+            const auto history_size = state->taps_per_filter_padded - (filter_idx == 0 ? 2 : 0);
+            std::memmove (filter_state, filter_state + 2 * n_samples_out, (size_t) history_size * sizeof (float));
+        }
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+//=====================================================================
+// Integer PCM input/output
+//
+// The integer samples are converted in vectors, while they're copied into the filter
+// state (for decimation), or straight after the kernel writes each channel's output
+// (for interpolation), so the caller doesn't need separate planar float buffers.
+
+static constexpr int pcm_tile_size = 256; // samples converted per pass, small enough to stay in L1
+static constexpr int pcm_output_alignment = 64; // keeps the kernel scratch aligned, after the output channel
+
+static int get_pcm_bytes_per_sample (int format)
+{
+    return format == FIR_PCM_Int16 ? 2 : (format == FIR_PCM_Int24 ? 3 : 4);
+}
+
+static void convert_pcm_to_float ([[maybe_unused]] int kernel, const std::byte* in, int format, float* out, int n_samples)
+{
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+    if (is_avx_kernel (kernel))
+        avx::convert_pcm_to_float (in, format, out, n_samples);
+    else
+        sse::convert_pcm_to_float (in, format, out, n_samples);
 #else
-        neon::process_fir_decim (state, ch_state, out[ch], n_samples_out, scratch_start);
+    simd_128::convert_pcm_to_float (in, format, out, n_samples);
 #endif
+}
 
-        { // save channel state for next buffer
-            int filter_idx = 0;
-            auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded;
-            auto* scratch = scratch_start;
-            auto samples_to_save = state->taps_per_filter_padded - 1;
-            std::memcpy (scratch,
-                         filter_state + n_samples_out,
-                         samples_to_save * sizeof (float));
-            std::memcpy (filter_state,
-                         scratch,
-                         samples_to_save * sizeof (float));
-            for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+static void convert_float_to_int ([[maybe_unused]] int kernel, const float* in, int32_t* out, int n_samples, int format, unsigned int* dither_state)
+{
+    // the largest float below 2^31 keeps the int32 conversion from overflowing
+    const auto scale = format == FIR_PCM_Int16 ? 32768.0f : (format == FIR_PCM_Int24 ? 8388608.0f : 2147483648.0f);
+    const auto max_value = format == FIR_PCM_Int16 ? 32767.0f : (format == FIR_PCM_Int24 ? 8388607.0f : 2147483520.0f);
+
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+    if (is_avx_kernel (kernel))
+        avx::convert_float_to_int (in, out, n_samples, scale, max_value, dither_state);
+    else
+        sse::convert_float_to_int (in, out, n_samples, scale, max_value, dither_state);
+#else
+    simd_128::convert_float_to_int (in, out, n_samples, scale, max_value, dither_state);
+#endif
+}
+
+/** Writes one channel of (already converted) integer samples into an interleaved PCM buffer */
+static void store_pcm_samples (const int32_t* samples, std::byte* out, int format, int stride, int n_samples)
+{
+    if (format == FIR_PCM_Int16)
+    {
+        auto* y_data = reinterpret_cast<int16_t*> (out);
+        for (int n = 0; n < n_samples; ++n)
+            y_data[n * stride] = (int16_t) samples[n];
+    }
+    else if (format == FIR_PCM_Int24)
+    {
+        auto* y_data = reinterpret_cast<uint8_t*> (out);
+        for (int n = 0; n < n_samples; ++n)
+        {
+            const auto x = (uint32_t) samples[n];
+            y_data[3 * n * stride] = (uint8_t) x;
+            y_data[3 * n * stride + 1] = (uint8_t) (x >> 8);
+            y_data[3 * n * stride + 2] = (uint8_t) (x >> 16);
+        }
+    }
+    else
+    {
+        auto* y_data = reinterpret_cast<int32_t*> (out);
+        for (int n = 0; n < n_samples; ++n)
+            y_data[n * stride] = samples[n];
+    }
+}
+
+size_t pcm_scratch_bytes_required (int n_taps, int factor, int max_samples_in, int alignment)
+{
+    // plus one channel of float output, which is converted in-place before being interleaved
+    return scratch_bytes_required (n_taps, factor, max_samples_in, alignment)
+           + (size_t) round_to_next_multiple (max_samples_in * factor * (int) sizeof (float), max_int (alignment, pcm_output_alignment));
+}
+
+void process_decimate_pcm (Polyphase_FIR_State* state,
+                           const void* in,
+                           Polyphase_FIR_PCM_Format in_format,
+                           float* const* out,
+                           int n_channels,
+                           int n_samples_in,
+                           void* scratch_data,
+                           [[maybe_unused]] bool use_avx)
+{
+    assert ((state->flags & FIR_Flag_Per_Channel_Coeffs) == 0);
+
+    auto* scratch_start = (float*) scratch_data;
+    const auto n_samples_out = n_samples_in / state->factor;
+    const auto kernel = get_kernel (state->decim_kernel, use_avx);
+    const auto channel_state_size = state->state_per_filter_padded * state->factor;
+    Stage_Timer timer { state->stats };
+
+    { // convert the interleaved input in tiles, and scatter each tile into the channel states
+        const auto* x_data = static_cast<const std::byte*> (in);
+        const auto bytes_per_sample = get_pcm_bytes_per_sample (in_format);
+        const auto n_samples_total = n_samples_out * state->factor * n_channels;
+        float tile[pcm_tile_size];
+
+        int ch = 0, filter_idx = 0, n = 0;
+        auto filter_offset = get_decim_input_offset (state, filter_idx);
+        for (int tile_start = 0; tile_start < n_samples_total; tile_start += pcm_tile_size)
+        {
+            const auto tile_samples = min_int (pcm_tile_size, n_samples_total - tile_start);
+            convert_pcm_to_float (kernel, x_data + (size_t) tile_start * (size_t) bytes_per_sample, in_format, tile, tile_samples);
+            for (int i = 0; i < tile_samples; ++i)
             {
-                filter_state = ch_state + filter_idx * state->state_per_filter_padded;
-                samples_to_save = state->taps_per_filter_padded - 1;
-                std::memcpy (scratch,
-                             filter_state + n_samples_out + 1,
-                             samples_to_save * sizeof (float));
-                std::memcpy (filter_state + 1,
-                             scratch,
-                             samples_to_save * sizeof (float));
+                state->decim_state[ch * channel_state_size + filter_offset + n] = tile[i];
+                if (++ch < n_channels)
+                    continue;
+
+                ch = 0;
+                if (++filter_idx == state->factor)
+                {
+                    filter_idx = 0;
+                    ++n;
+                }
+                filter_offset = get_decim_input_offset (state, filter_idx);
             }
         }
     }
+    timer.end_stage (FIR_Stage_Input_Copy);
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->decim_state + ch * channel_state_size;
+        apply_fir_decim<false> (kernel, state, ch_state, out[ch], n_samples_out, scratch_start, 1.0f);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        save_decim_state (state, ch_state, n_samples_out, scratch_start);
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+void process_interpolate_pcm (Polyphase_FIR_State* state,
+                              const float* const* in,
+                              void* out,
+                              Polyphase_FIR_PCM_Format out_format,
+                              bool dither,
+                              int n_channels,
+                              int n_samples_in,
+                              void* scratch_data,
+                              [[maybe_unused]] bool use_avx)
+{
+    assert ((state->flags & FIR_Flag_Per_Channel_Coeffs) == 0);
+
+    const auto n_samples_out = n_samples_in * state->factor;
+    const auto kernel = get_kernel (state->interp_kernel, use_avx);
+    const auto bytes_per_sample = get_pcm_bytes_per_sample (out_format);
+    Stage_Timer timer { state->stats };
+
+    // the channel output goes before the kernel scratch (see `pcm_scratch_bytes_required()`)
+    auto* y_data = (float*) scratch_data;
+    auto* scratch_start = y_data + round_to_next_multiple (n_samples_out, pcm_output_alignment / (int) sizeof (float));
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->interp_state + ch * state->state_per_filter_padded;
+        std::memcpy (ch_state + state->taps_per_filter_padded - 1,
+                     in[ch],
+                     n_samples_in * sizeof (float));
+        timer.end_stage (FIR_Stage_Input_Copy);
+
+        apply_fir_interp<false> (kernel, state, ch_state, y_data, n_samples_in, scratch_start, 1.0f);
+        auto* y_int = reinterpret_cast<int32_t*> (y_data);
+        convert_float_to_int (kernel, y_data, y_int, n_samples_out, out_format, dither ? state->dither_state : nullptr);
+        store_pcm_samples (y_int, static_cast<std::byte*> (out) + ch * bytes_per_sample, out_format, n_channels, n_samples_out);
+        timer.end_stage (FIR_Stage_Kernel);
+
+        save_interp_state (state, ch_state, n_samples_in, scratch_start);
+        timer.end_stage (FIR_Stage_History_Save);
+    }
+    timer.end_call (n_samples_in);
+}
+
+//=====================================================================
+// Asynchronous resampler
+//
+// The coefficient table holds phases [-1, n_phases + 1], so that linear and cubic
+// interpolation never needs to wrap around to a neighbouring input sample. Each
+// phase also has one "look-ahead" tap, so that phase `n_phases` (the first phase
+// of the next input sample) can be evaluated with the same input window.
+
+static constexpr int asrc_guard_phases = 3;
+static constexpr int asrc_scratch_idx_padding = 16; // keeps each scratch array 64-byte aligned
+
+static int get_asrc_taps_per_filter_padded (int n_taps, int n_phases, int alignment)
+{
+    const auto taps_per_filter = ceiling_divide (n_taps, n_phases) + 2;
+    return round_to_next_multiple (taps_per_filter,
+                                   alignment / (int) sizeof (float));
+}
+
+static auto get_asrc_coeffs_state_bytes (int n_channels, int n_taps, int n_phases, int max_samples_in, int alignment)
+{
+    const auto taps_per_filter_padded = get_asrc_taps_per_filter_padded (n_taps, n_phases, alignment);
+    const auto coeffs_bytes = taps_per_filter_padded * (n_phases + asrc_guard_phases) * sizeof (float);
+
+    const auto state_per_filter_padded = get_state_per_filter_padded (taps_per_filter_padded, max_samples_in, alignment);
+    const auto state_bytes = state_per_filter_padded * n_channels * sizeof (float);
+
+    return std::make_tuple (coeffs_bytes, state_bytes);
+}
+
+static int get_asrc_max_samples_out (int max_samples_in, double max_ratio)
+{
+    return (int) std::ceil ((double) max_samples_in * max_ratio) + 1;
+}
+
+static int asrc_count_samples_out (double time, double step, int n_samples_in)
+{
+    // outputs are produced while the window (plus the look-ahead sample) fits in the input block
+    const auto end_time = (double) (n_samples_in - 1);
+    auto n_samples_out = max_int (0, (int) std::ceil ((end_time - time) / step));
+    while (n_samples_out > 0 && time + (n_samples_out - 1) * step >= end_time)
+        --n_samples_out;
+    while (time + n_samples_out * step < end_time)
+        ++n_samples_out;
+    return n_samples_out;
+}
+
+size_t asrc_persistent_bytes_required (int n_channels, int n_taps, int n_phases, int max_samples_in, int alignment)
+{
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_ASRC_State), alignment);
+    const auto [coeffs_bytes, state_bytes] = get_asrc_coeffs_state_bytes (n_channels, n_taps, n_phases, max_samples_in, alignment);
+    return state_object_bytes + coeffs_bytes + state_bytes;
+}
+
+Polyphase_ASRC_State* asrc_init (int n_channels,
+                                 int n_taps,
+                                 int n_phases,
+                                 int max_samples_in,
+                                 double max_ratio,
+                                 Polyphase_ASRC_Interpolation interpolation,
+                                 void* persistent_data,
+                                 int alignment)
+{
+    auto* data = (std::byte*) persistent_data;
+
+    // "allocate" state object
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_ASRC_State), alignment);
+    auto* state = reinterpret_cast<Polyphase_ASRC_State*> (data);
+    data += state_object_bytes;
+
+    // initialize state
+    *state = {};
+    state->n_channels = n_channels;
+    state->n_phases = n_phases;
+    state->taps_per_filter_padded = get_asrc_taps_per_filter_padded (n_taps, n_phases, alignment);
+    state->state_per_filter_padded = get_state_per_filter_padded (state->taps_per_filter_padded, max_samples_in, alignment);
+    state->max_ratio = max_ratio;
+    state->interpolation = interpolation;
+
+    const auto [coeffs_bytes, state_bytes] = get_asrc_coeffs_state_bytes (n_channels, n_taps, n_phases, max_samples_in, alignment);
+    state->coeffs = reinterpret_cast<float*> (data);
+    data += coeffs_bytes;
+    state->state = reinterpret_cast<float*> (data);
+    data += state_bytes;
+
+    // start at unity, unless the converter can only downsample
+    asrc_set_ratio (state, std::min (1.0, max_ratio));
+    asrc_reset (state);
+
+    return state;
+}
+
+void asrc_load_coeffs (Polyphase_ASRC_State* state, const float* coeffs, int n_taps)
+{
+    // row `r` holds phase `r - 1`, and tap `j` of each phase lines up with input sample `n + 1 - j`
+    load_polyphase_coeffs (state->coeffs,
+                           state->taps_per_filter_padded,
+                           state->n_phases + asrc_guard_phases,
+                           state->n_phases,
+                           -1 - state->n_phases,
+                           coeffs,
+                           n_taps);
+}
+
+void asrc_reset (Polyphase_ASRC_State* state)
+{
+    const auto state_bytes = state->state_per_filter_padded * state->n_channels * sizeof (float);
+    std::memset (state->state, 0, state_bytes);
+    state->time = 0.0;
+}
+
+void asrc_set_ratio (Polyphase_ASRC_State* state, double ratio)
+{
+    assert (ratio > 0.0 && ratio <= state->max_ratio);
+    state->step = 1.0 / ratio;
+}
+
+int asrc_samples_out (const Polyphase_ASRC_State* state, int n_samples_in)
+{
+    return asrc_count_samples_out (state->time, state->step, n_samples_in);
+}
+
+size_t asrc_scratch_bytes_required (int, int, int max_samples_in, double max_ratio, int alignment)
+{
+    const auto max_samples_out = get_asrc_max_samples_out (max_samples_in, max_ratio);
+    const auto idx_bytes = round_to_next_multiple (max_samples_out, asrc_scratch_idx_padding) * (int) sizeof (int);
+    const auto weights_bytes = round_to_next_multiple (max_samples_out * 4 * (int) sizeof (float), alignment);
+    return 2 * idx_bytes + weights_bytes;
+}
+
+int asrc_process (Polyphase_ASRC_State* state,
+                  const float* const* in,
+                  float* const* out,
+                  int n_channels,
+                  int n_samples_in,
+                  void* scratch_data,
+                  [[maybe_unused]] bool use_avx)
+{
+    const auto n_samples_out = asrc_count_samples_out (state->time, state->step, n_samples_in);
+    const auto n_points = state->interpolation == ASRC_Interpolation_Cubic ? 4 : 2;
+
+    auto* window_idx = (int*) scratch_data;
+    auto* phase_row = window_idx + round_to_next_multiple (n_samples_out, asrc_scratch_idx_padding);
+    auto* weights = (float*) (phase_row + round_to_next_multiple (n_samples_out, asrc_scratch_idx_padding));
+
+    { // compute the input window, table row, and interpolation weights for each output sample
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto time = state->time + n * state->step;
+            const auto time_floor = std::floor (time);
+            const auto phase_pos = (time - time_floor) * (double) state->n_phases;
+            const auto phase = min_int ((int) phase_pos, state->n_phases - 1);
+            const auto mu = (float) (phase_pos - (double) phase);
+
+            window_idx[n] = (int) time_floor + 1;
+            auto* w = weights + n * n_points;
+            if (n_points == 2)
+            {
+                phase_row[n] = phase + 1;
+                w[0] = 1.0f - mu;
+                w[1] = mu;
+            }
+            else
+            {
+                // Catmull-Rom spline through phases [phase - 1, phase + 2]
+                phase_row[n] = phase;
+                w[0] = 0.5f * ((-mu + 2.0f) * mu - 1.0f) * mu;
+                w[1] = 0.5f * ((3.0f * mu - 5.0f) * mu * mu + 2.0f);
+                w[2] = 0.5f * ((-3.0f * mu + 4.0f) * mu + 1.0f) * mu;
+                w[3] = 0.5f * (mu - 1.0f) * mu * mu;
+            }
+        }
+    }
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->state + ch * state->state_per_filter_padded;
+
+        { // copy x_data into ch_state
+            auto* x_data = in[ch];
+            std::memcpy (ch_state + state->taps_per_filter_padded - 1,
+                         x_data,
+                         n_samples_in * sizeof (float));
+        }
+
+        // apply filters
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        if (use_avx)
+            avx::process_fir_asrc (state, ch_state, out[ch], window_idx, phase_row, weights, n_samples_out);
+        else
+            sse::process_fir_asrc (state, ch_state, out[ch], window_idx, phase_row, weights, n_samples_out);
+#else
+        simd_128::process_fir_asrc (state, ch_state, out[ch], window_idx, phase_row, weights, n_samples_out);
+#endif
+
+        { // save channel state for next buffer
+            const auto samples_to_save = state->taps_per_filter_padded - 1;
+            std::memmove (ch_state,
+                          ch_state + n_samples_in,
+                          samples_to_save * sizeof (float));
+        }
+    }
+
+    state->time += n_samples_out * state->step - (double) n_samples_in;
+    return n_samples_out;
+}
+
+//=====================================================================
+// Uniform DFT filter bank
+//
+// The analysis bank splits the input into `n_bands` polyphase streams (like the
+// decimation state), so that the window for each branch is contiguous, even when
+// the hop size is smaller than the number of bands. The synthesis bank keeps one
+// stream per IFFT bin, and uses the "interpolation" coefficient layout, with one
+// filter per output sample in the hop.
+
+static auto get_filter_bank_sizes (int n_taps, int n_bands, int oversampling, int max_frames, int alignment)
+{
+    const auto hop_size = n_bands / oversampling;
+    const auto analysis_taps_per_filter_padded = get_taps_per_filter_padded (n_taps, n_bands, alignment);
+    const auto analysis_state_per_filter_padded = get_state_per_filter_padded (analysis_taps_per_filter_padded,
+                                                                               ceiling_divide (max_frames, oversampling),
+                                                                               alignment);
+    const auto synthesis_taps_per_filter_padded = get_taps_per_filter_padded (n_taps, hop_size, alignment);
+    const auto synthesis_state_per_filter_padded = get_state_per_filter_padded (synthesis_taps_per_filter_padded, max_frames, alignment);
+    return std::make_tuple (analysis_taps_per_filter_padded,
+                            analysis_state_per_filter_padded,
+                            synthesis_taps_per_filter_padded,
+                            synthesis_state_per_filter_padded);
+}
+
+static auto get_filter_bank_bytes (int n_channels, int n_taps, int n_bands, int oversampling, int max_frames, int alignment)
+{
+    const auto hop_size = n_bands / oversampling;
+    const auto [analysis_taps, analysis_state, synthesis_taps, synthesis_state] = get_filter_bank_sizes (n_taps, n_bands, oversampling, max_frames, alignment);
+    const auto analysis_coeffs_bytes = analysis_taps * n_bands * sizeof (float);
+    const auto synthesis_coeffs_bytes = synthesis_taps * hop_size * sizeof (float);
+    const auto analysis_state_bytes = analysis_state * n_bands * n_channels * sizeof (float);
+    const auto synthesis_state_bytes = synthesis_state * n_bands * n_channels * sizeof (float);
+    const auto twiddle_bytes = (size_t) round_to_next_multiple (n_bands * (int) sizeof (float), alignment);
+    const auto bit_reverse_bytes = (size_t) round_to_next_multiple (n_bands * (int) sizeof (int), alignment);
+    return std::make_tuple (analysis_coeffs_bytes,
+                            synthesis_coeffs_bytes,
+                            analysis_state_bytes,
+                            synthesis_state_bytes,
+                            twiddle_bytes,
+                            bit_reverse_bytes);
+}
+
+/** Fills in the twiddle factors (`n / 2` complex values) and bit-reversal table for an FFT of size `n`. */
+template <typename T>
+static void init_fft_tables (T* twiddles, int* bit_reverse, int n)
+{
+    for (int k = 0; k < n / 2; ++k)
+    {
+        const auto angle = 2.0 * M_PI * (double) k / (double) n;
+        twiddles[2 * k] = (T) std::cos (angle);
+        twiddles[2 * k + 1] = (T) std::sin (angle);
+    }
+
+    int n_bits = 0;
+    while ((1 << n_bits) < n)
+        ++n_bits;
+    for (int i = 0; i < n; ++i)
+    {
+        int reversed = 0;
+        for (int b = 0; b < n_bits; ++b)
+            reversed |= ((i >> b) & 1) << (n_bits - 1 - b);
+        bit_reverse[i] = reversed;
+    }
+}
+
+/** In-place, un-normalized inverse FFT (i.e. with positive exponents) of `n` interleaved complex values. */
+template <typename T>
+static void fft_inverse (T* data, int n, const T* twiddles, const int* bit_reverse)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        const auto j = bit_reverse[i];
+        if (i < j)
+        {
+            std::swap (data[2 * i], data[2 * j]);
+            std::swap (data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+
+    for (int size = 2; size <= n; size *= 2)
+    {
+        const auto half_size = size / 2;
+        const auto twiddle_stride = n / size;
+        for (int start = 0; start < n; start += size)
+        {
+            for (int k = 0; k < half_size; ++k)
+            {
+                const auto w_re = twiddles[2 * k * twiddle_stride];
+                const auto w_im = twiddles[2 * k * twiddle_stride + 1];
+                auto* a = data + 2 * (start + k);
+                auto* b = data + 2 * (start + k + half_size);
+                const auto b_re = b[0] * w_re - b[1] * w_im;
+                const auto b_im = b[0] * w_im + b[1] * w_re;
+                b[0] = a[0] - b_re;
+                b[1] = a[1] - b_im;
+                a[0] += b_re;
+                a[1] += b_im;
+            }
+        }
+    }
+}
+
+size_t filter_bank_persistent_bytes_required (int n_channels, int n_taps, int n_bands, int oversampling, int max_frames, int alignment)
+{
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_Filter_Bank_State), alignment);
+    const auto [analysis_coeffs_bytes, synthesis_coeffs_bytes, analysis_state_bytes, synthesis_state_bytes, twiddle_bytes, bit_reverse_bytes] =
+        get_filter_bank_bytes (n_channels, n_taps, n_bands, oversampling, max_frames, alignment);
+    return state_object_bytes
+           + analysis_coeffs_bytes
+           + synthesis_coeffs_bytes
+           + analysis_state_bytes
+           + synthesis_state_bytes
+           + twiddle_bytes
+           + bit_reverse_bytes;
+}
+
+Polyphase_Filter_Bank_State* filter_bank_init (int n_channels,
+                                               int n_taps,
+                                               int n_bands,
+                                               int oversampling,
+                                               int max_frames,
+                                               void* persistent_data,
+                                               int alignment)
+{
+    assert (n_bands >= 2 && (n_bands & (n_bands - 1)) == 0);
+    assert (oversampling >= 1 && n_bands % oversampling == 0);
+
+    auto* data = (std::byte*) persistent_data;
+
+    // "allocate" state object
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_Filter_Bank_State), alignment);
+    auto* state = reinterpret_cast<Polyphase_Filter_Bank_State*> (data);
+    data += state_object_bytes;
+
+    // initialize state
+    *state = {};
+    state->n_channels = n_channels;
+    state->n_bands = n_bands;
+    state->hop_size = n_bands / oversampling;
+    std::tie (state->analysis_taps_per_filter_padded,
+              state->analysis_state_per_filter_padded,
+              state->synthesis_taps_per_filter_padded,
+              state->synthesis_state_per_filter_padded) = get_filter_bank_sizes (n_taps, n_bands, oversampling, max_frames, alignment);
+
+    const auto [analysis_coeffs_bytes, synthesis_coeffs_bytes, analysis_state_bytes, synthesis_state_bytes, twiddle_bytes, bit_reverse_bytes] =
+        get_filter_bank_bytes (n_channels, n_taps, n_bands, oversampling, max_frames, alignment);
+    state->analysis_coeffs = reinterpret_cast<float*> (data);
+    data += analysis_coeffs_bytes;
+    state->synthesis_coeffs = reinterpret_cast<float*> (data);
+    data += synthesis_coeffs_bytes;
+    state->analysis_state = reinterpret_cast<float*> (data);
+    data += analysis_state_bytes;
+    state->synthesis_state = reinterpret_cast<float*> (data);
+    data += synthesis_state_bytes;
+    state->fft_twiddles = reinterpret_cast<float*> (data);
+    data += twiddle_bytes;
+    state->fft_bit_reverse = reinterpret_cast<int*> (data);
+    data += bit_reverse_bytes;
+
+    init_fft_tables (state->fft_twiddles, state->fft_bit_reverse, n_bands);
+
+    filter_bank_reset (state);
+
+    return state;
+}
+
+void filter_bank_load_coeffs (Polyphase_Filter_Bank_State* state, const float* coeffs, int n_taps)
+{
+    load_polyphase_coeffs (state->analysis_coeffs,
+                           state->analysis_taps_per_filter_padded,
+                           state->n_bands,
+                           state->n_bands,
+                           0,
+                           coeffs,
+                           n_taps);
+    load_polyphase_coeffs (state->synthesis_coeffs,
+                           state->synthesis_taps_per_filter_padded,
+                           state->hop_size,
+                           state->hop_size,
+                           0,
+                           coeffs,
+                           n_taps);
+
+    // the synthesis bank re-inserts the energy lost by upsampling
+    const auto synthesis_gain = (float) state->hop_size;
+    for (int i = 0; i < state->synthesis_taps_per_filter_padded * state->hop_size; ++i)
+        state->synthesis_coeffs[i] *= synthesis_gain;
+}
+
+void filter_bank_reset (Polyphase_Filter_Bank_State* state)
+{
+    const auto analysis_state_bytes = state->analysis_state_per_filter_padded * state->n_bands * state->n_channels * sizeof (float);
+    std::memset (state->analysis_state, 0, analysis_state_bytes);
+
+    const auto synthesis_state_bytes = state->synthesis_state_per_filter_padded * state->n_bands * state->n_channels * sizeof (float);
+    std::memset (state->synthesis_state, 0, synthesis_state_bytes);
+
+    state->synthesis_frame = 0;
+}
+
+size_t filter_bank_scratch_bytes_required (int, int n_bands, int, int, int alignment)
+{
+    // window indices, branch outputs, and the FFT buffer
+    return round_to_next_multiple (4 * n_bands * (int) sizeof (float), alignment);
+}
+
+void filter_bank_process_analysis (Polyphase_Filter_Bank_State* state,
+                                   const float* const* in,
+                                   float* const* out,
+                                   int n_channels,
+                                   int n_samples_in,
+                                   void* scratch_data,
+                                   [[maybe_unused]] bool use_avx)
+{
+    assert (n_samples_in % state->n_bands == 0);
+
+    const auto n_bands = state->n_bands;
+    const auto hop_size = state->hop_size;
+    const auto oversampling = n_bands / hop_size;
+    const auto taps_per_filter_padded = state->analysis_taps_per_filter_padded;
+    const auto state_per_filter_padded = state->analysis_state_per_filter_padded;
+    const auto n_samples_per_stream = n_samples_in / n_bands;
+    const auto n_frames = n_samples_in / hop_size;
+
+    auto* window_idx = (int*) scratch_data;
+    auto* branch_data = (float*) (window_idx + n_bands);
+    auto* fft_data = branch_data + n_bands;
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->analysis_state + ch * (state_per_filter_padded * n_bands);
+
+        { // copy x_data into the polyphase streams
+            auto* x_data = in[ch];
+            for (int stream_idx = 0; stream_idx < n_bands; ++stream_idx)
+            {
+                auto* stream_state = ch_state + stream_idx * state_per_filter_padded;
+                for (int n = 0; n < n_samples_per_stream; ++n)
+                    stream_state[taps_per_filter_padded + n] = x_data[n * n_bands + stream_idx];
+            }
+        }
+
+        for (int frame = 0; frame < n_frames; ++frame)
+        {
+            // branch `p` filters the samples at `frame * hop_size - p - j * n_bands`
+            for (int p = 0; p < n_bands; ++p)
+            {
+                const auto sample_idx = frame * hop_size - p;
+                const auto stream_idx = (sample_idx + n_bands) % n_bands;
+                const auto stream_pos = (sample_idx - stream_idx) / n_bands;
+                window_idx[p] = stream_idx * state_per_filter_padded + stream_pos + 1;
+            }
+
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+            if (use_avx)
+                avx::process_fir_branches (state->analysis_coeffs, taps_per_filter_padded, ch_state, window_idx, branch_data, n_bands);
+            else
+                sse::process_fir_branches (state->analysis_coeffs, taps_per_filter_padded, ch_state, window_idx, branch_data, n_bands);
+#else
+            simd_128::process_fir_branches (state->analysis_coeffs, taps_per_filter_padded, ch_state, window_idx, branch_data, n_bands);
+#endif
+
+            // rotate the branches so that each band is mixed down to baseband, then transform
+            const auto shift = (frame % oversampling) * hop_size;
+            for (int q = 0; q < n_bands; ++q)
+            {
+                fft_data[2 * q] = branch_data[(q + shift) & (n_bands - 1)];
+                fft_data[2 * q + 1] = 0.0f;
+            }
+            fft_inverse (fft_data, state->n_bands, state->fft_twiddles, state->fft_bit_reverse);
+            std::memcpy (out[ch] + 2 * frame * n_bands, fft_data, 2 * n_bands * sizeof (float));
+        }
+
+        { // save channel state for next buffer
+            for (int stream_idx = 0; stream_idx < n_bands; ++stream_idx)
+            {
+                auto* stream_state = ch_state + stream_idx * state_per_filter_padded;
+                std::memmove (stream_state,
+                              stream_state + n_samples_per_stream,
+                              taps_per_filter_padded * sizeof (float));
+            }
+        }
+    }
+}
+
+void filter_bank_process_synthesis (Polyphase_Filter_Bank_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    int n_channels,
+                                    int n_frames,
+                                    void* scratch_data,
+                                    [[maybe_unused]] bool use_avx)
+{
+    const auto n_bands = state->n_bands;
+    const auto hop_size = state->hop_size;
+    const auto oversampling = n_bands / hop_size;
+    const auto taps_per_filter_padded = state->synthesis_taps_per_filter_padded;
+    const auto state_per_filter_padded = state->synthesis_state_per_filter_padded;
+
+    auto* window_idx = (int*) scratch_data;
+    auto* fft_data = (float*) (window_idx + 2 * n_bands);
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        auto* ch_state = state->synthesis_state + ch * (state_per_filter_padded * n_bands);
+
+        // transform each frame, and copy the real part of each bin into its stream
+        for (int frame = 0; frame < n_frames; ++frame)
+        {
+            std::memcpy (fft_data, in[ch] + 2 * frame * n_bands, 2 * n_bands * sizeof (float));
+            fft_inverse (fft_data, state->n_bands, state->fft_twiddles, state->fft_bit_reverse);
+            for (int q = 0; q < n_bands; ++q)
+                ch_state[q * state_per_filter_padded + taps_per_filter_padded - 1 + frame] = fft_data[2 * q];
+        }
+
+        for (int frame = 0; frame < n_frames; ++frame)
+        {
+            // output sample `n` of the hop only ever sees bin `(frame * hop_size + n) % n_bands` of each frame
+            const auto shift = ((state->synthesis_frame + frame) % oversampling) * hop_size;
+            for (int n = 0; n < hop_size; ++n)
+                window_idx[n] = (shift + n) * state_per_filter_padded + frame;
+
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+            if (use_avx)
+                avx::process_fir_branches (state->synthesis_coeffs, taps_per_filter_padded, ch_state, window_idx, out[ch] + frame * hop_size, hop_size);
+            else
+                sse::process_fir_branches (state->synthesis_coeffs, taps_per_filter_padded, ch_state, window_idx, out[ch] + frame * hop_size, hop_size);
+#else
+            simd_128::process_fir_branches (state->synthesis_coeffs, taps_per_filter_padded, ch_state, window_idx, out[ch] + frame * hop_size, hop_size);
+#endif
+        }
+
+        { // save channel state for next buffer
+            const auto samples_to_save = taps_per_filter_padded - 1;
+            for (int q = 0; q < n_bands; ++q)
+            {
+                auto* stream_state = ch_state + q * state_per_filter_padded;
+                std::memmove (stream_state,
+                              stream_state + n_frames,
+                              samples_to_save * sizeof (float));
+            }
+        }
+    }
+
+    state->synthesis_frame = (state->synthesis_frame + n_frames) % oversampling;
+}
+
+//=====================================================================
+// Latency and minimum-phase conversion
+
+/**
+ * Reads tap `index` of the prototype filter back out of the filter's polyphase coefficient layout.
+ * For complex coefficients, this is the real part (see load_polyphase_coeffs_complex()).
+ */
+static float get_prototype_coeff (const Polyphase_FIR_State* state, int channel, int index)
+{
+    const auto phase = index % state->factor;
+    if ((state->flags & complex_flags) != 0)
+    {
+        const auto complex_taps_per_filter = state->taps_per_filter_padded / 2;
+        return state->coeffs[state->taps_per_filter_padded * phase + 2 * (complex_taps_per_filter - index / state->factor - 1)];
+    }
+
+    const auto dest_idx = state->taps_per_filter_padded - index / state->factor - 1;
+    if ((state->flags & FIR_Flag_Per_Channel_Coeffs) != 0)
+    {
+        const auto filter_stride = state->taps_per_filter_padded * channel_group_size;
+        const auto* group_coeffs = state->coeffs + (channel / channel_group_size) * filter_stride * state->factor;
+        return group_coeffs[filter_stride * phase + dest_idx * channel_group_size + channel % channel_group_size];
+    }
+
+    const auto coeff_idx = state->taps_per_filter_padded * phase + dest_idx;
+    if ((state->flags & half_coeffs_flags) != 0)
+        return half_to_float (reinterpret_cast<const uint16_t*> (state->coeffs)[coeff_idx], (state->flags & FIR_Flag_Coeffs_BF16) != 0);
+    return state->coeffs[coeff_idx];
+}
+
+void get_latency (const Polyphase_FIR_State* state, int channel, bool decimate, Polyphase_FIR_Latency* latency)
+{
+    assert (channel >= 0 && channel < state->n_channels);
+
+    const auto taps_per_filter = state->taps_per_filter_padded / get_floats_per_sample (state->flags);
+    double sum = 0.0, abs_sum = 0.0, moment = 0.0, energy = 0.0, energy_moment = 0.0;
+    for (int n = 0; n < taps_per_filter * state->factor; ++n)
+    {
+        const auto h = (double) get_prototype_coeff (state, channel, n);
+        sum += h;
+        abs_sum += std::abs (h);
+        moment += (double) n * h;
+        energy += h * h;
+        energy_moment += (double) n * h * h;
+    }
+
+    // The group delay at DC, unless the filter doesn't pass DC, in which case
+    // the "centre of mass" of the impulse response is the next best thing.
+    auto group_delay = 0.0;
+    if (std::abs (sum) > 1.0e-6 * abs_sum)
+        group_delay = moment / sum;
+    else if (energy > 0.0)
+        group_delay = energy_moment / energy;
+
+    const auto low_rate_delay = group_delay / (double) state->factor;
+    latency->input_samples = decimate ? group_delay : low_rate_delay;
+    latency->output_samples = decimate ? low_rate_delay : group_delay;
+}
+
+// The real cepstrum is aliased in time, so the FFT needs to be much longer than the filter.
+static constexpr int minimum_phase_fft_oversampling = 16;
+
+// Floor for the magnitude response (relative to its peak), so that zeros on the unit circle don't go to -inf.
+static constexpr double minimum_phase_magnitude_floor = 1.0e-10;
+
+static int get_minimum_phase_fft_size (int n_taps)
+{
+    int fft_size = 2;
+    while (fft_size < minimum_phase_fft_oversampling * n_taps)
+        fft_size *= 2;
+    return fft_size;
+}
+
+size_t minimum_phase_scratch_bytes_required (int n_taps)
+{
+    const auto fft_size = (size_t) get_minimum_phase_fft_size (n_taps);
+    return 2 * fft_size * sizeof (double) // data
+           + fft_size * sizeof (double) // twiddles
+           + fft_size * sizeof (int); // bit-reversal table
+}
+
+void make_minimum_phase (const float* coeffs, float* min_phase_coeffs, int n_taps, void* scratch_data)
+{
+    const auto fft_size = get_minimum_phase_fft_size (n_taps);
+    auto* data = (double*) scratch_data;
+    auto* twiddles = data + 2 * fft_size;
+    auto* bit_reverse = (int*) (twiddles + fft_size);
+    init_fft_tables (twiddles, bit_reverse, fft_size);
+
+    // Only the magnitude response is needed, so the sign of the exponent doesn't matter here.
+    for (int k = 0; k < fft_size; ++k)
+    {
+        data[2 * k] = k < n_taps ? (double) coeffs[k] : 0.0;
+        data[2 * k + 1] = 0.0;
+    }
+    fft_inverse (data, fft_size, twiddles, bit_reverse);
+
+    auto max_magnitude_squared = 0.0;
+    for (int k = 0; k < fft_size; ++k)
+        max_magnitude_squared = std::max (max_magnitude_squared, data[2 * k] * data[2 * k] + data[2 * k + 1] * data[2 * k + 1]);
+    const auto floor_squared = max_magnitude_squared * minimum_phase_magnitude_floor * minimum_phase_magnitude_floor;
+
+    // real cepstrum = IFFT (log |H|)
+    for (int k = 0; k < fft_size; ++k)
+    {
+        const auto magnitude_squared = data[2 * k] * data[2 * k] + data[2 * k + 1] * data[2 * k + 1];
+        data[2 * k] = 0.5 * std::log (std::max (magnitude_squared, floor_squared));
+        data[2 * k + 1] = 0.0;
+    }
+    fft_inverse (data, fft_size, twiddles, bit_reverse);
+
+    // Fold the (even) cepstrum onto positive times, which gives the cepstrum of the minimum-phase filter.
+    const auto scale = 1.0 / (double) fft_size;
+    for (int k = 0; k < fft_size; ++k)
+    {
+        const auto fold = (k == 0 || k == fft_size / 2) ? 1.0 : (k < fft_size / 2 ? 2.0 : 0.0);
+        data[2 * k] *= fold * scale;
+        data[2 * k + 1] = 0.0;
+    }
+
+    // H_min = exp (FFT (folded cepstrum)), where the forward FFT of real data is the conjugate of the inverse FFT.
+    fft_inverse (data, fft_size, twiddles, bit_reverse);
+    for (int k = 0; k < fft_size; ++k)
+    {
+        const auto magnitude = std::exp (data[2 * k]);
+        const auto phase = -data[2 * k + 1];
+        data[2 * k] = magnitude * std::cos (phase);
+        data[2 * k + 1] = magnitude * std::sin (phase);
+    }
+
+    // h_min = IFFT (H_min)
+    fft_inverse (data, fft_size, twiddles, bit_reverse);
+    for (int n = 0; n < n_taps; ++n)
+        min_phase_coeffs[n] = (float) (data[2 * n] * scale);
+}
+
+//=====================================================================
+// Polyphase IIR half-band
+//
+// H(z) = (A_0(z^2) + z^-1 A_1(z^2)) / 2, where A_0 and A_1 are chains of first-order
+// allpass sections, holding the even and odd coefficients respectively. Each chain runs
+// at the lower sample rate. The coefficients and state are interleaved across groups of
+// 8 channels, so that the kernels can vectorize across channels rather than time.
+
+static constexpr int iir_channel_group_size = 8;
+
+static int get_iir_group_state_size (int n_coeffs)
+{
+    // each chain keeps one more value than it has sections (the previous output of the last section)
+    return (n_coeffs + 2) * iir_channel_group_size;
+}
+
+static auto get_iir_halfband_bytes (int n_channels, int n_coeffs, int alignment)
+{
+    const auto n_groups = ceiling_divide (n_channels, iir_channel_group_size);
+    const auto coeffs_bytes = (size_t) round_to_next_multiple (n_coeffs * iir_channel_group_size * (int) sizeof (float), alignment);
+    const auto state_bytes = (size_t) round_to_next_multiple (n_groups * get_iir_group_state_size (n_coeffs) * (int) sizeof (float), alignment);
+    return std::make_tuple (coeffs_bytes, state_bytes);
+}
+
+size_t iir_halfband_persistent_bytes_required (int n_channels, int n_coeffs, int alignment)
+{
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_IIR_State), alignment);
+    const auto [coeffs_bytes, state_bytes] = get_iir_halfband_bytes (n_channels, n_coeffs, alignment);
+    return state_object_bytes + coeffs_bytes + 2 * state_bytes;
+}
+
+Polyphase_IIR_State* iir_halfband_init (int n_channels, int n_coeffs, void* persistent_data, int alignment)
+{
+    assert (n_coeffs >= 1);
+
+    auto* data = (std::byte*) persistent_data;
+
+    // "allocate" state object
+    const auto state_object_bytes = round_to_next_multiple ((int) sizeof (Polyphase_IIR_State), alignment);
+    auto* state = reinterpret_cast<Polyphase_IIR_State*> (data);
+    data += state_object_bytes;
+
+    // initialize state
+    *state = {};
+    state->n_channels = n_channels;
+    state->n_coeffs = n_coeffs;
+
+    const auto [coeffs_bytes, state_bytes] = get_iir_halfband_bytes (n_channels, n_coeffs, alignment);
+    state->coeffs = reinterpret_cast<float*> (data);
+    data += coeffs_bytes;
+    state->interp_state = reinterpret_cast<float*> (data);
+    data += state_bytes;
+    state->decim_state = reinterpret_cast<float*> (data);
+    data += state_bytes;
+
+    std::memset (state->coeffs, 0, coeffs_bytes);
+    iir_halfband_reset (state);
+
+    return state;
+}
+
+/**
+ * The half-band filter is derived from an elliptic lowpass, with the selectivity set by
+ * the passband edge (the stopband edge mirrors it about the low-rate Nyquist frequency),
+ * and `q` being its nome.
+ */
+static void get_iir_halfband_transition_params (double passband, double& k, double& q)
+{
+    k = std::tan (passband * M_PI / 4.0);
+    k *= k;
+    const auto kk_root = std::pow (1.0 - k * k, 0.25);
+    const auto e = 0.5 * (1.0 - kk_root) / (1.0 + kk_root);
+    const auto e4 = (e * e) * (e * e);
+    q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+}
+
+int iir_halfband_coeffs_required (double passband, double attenuation_db)
+{
+    double k, q;
+    get_iir_halfband_transition_params (passband, k, q);
+
+    const auto attenuation_power = std::pow (10.0, -attenuation_db / 10.0);
+    const auto a = attenuation_power / (1.0 - attenuation_power);
+    auto order = (int) std::ceil (std::log (a * a / 16.0) / std::log (q));
+    order = order % 2 == 0 ? order + 1 : order;
+    return max_int ((order - 1) / 2, 1);
+}
+
+void iir_halfband_design (float* coeffs, int n_coeffs, double passband)
+{
+    double k, q;
+    get_iir_halfband_transition_params (passband, k, q);
+
+    const auto order = 2 * n_coeffs + 1;
+    for (int c = 1; c <= n_coeffs; ++c)
+    {
+        // series for the elliptic function, which converge very quickly since q is small
+        double numerator = 0.0, denominator = 0.5;
+        for (int i = 0; i < 64; ++i)
+        {
+            const auto sign = i % 2 == 0 ? 1.0 : -1.0;
+            numerator += sign * std::pow (q, (double) (i * (i + 1))) * std::sin ((double) ((2 * i + 1) * c) * M_PI / (double) order);
+            if (i > 0)
+                denominator += sign * std::pow (q, (double) (i * i)) * std::cos ((double) (2 * i * c) * M_PI / (double) order);
+        }
+
+        const auto w = numerator * std::pow (q, 0.25) / denominator;
+        const auto w2 = w * w;
+        const auto x = std::sqrt ((1.0 - w2 * k) * (1.0 - w2 / k)) / (1.0 + w2);
+        coeffs[c - 1] = (float) ((1.0 - x) / (1.0 + x));
+    }
+}
+
+void iir_halfband_load_coeffs (Polyphase_IIR_State* state, const float* coeffs, int n_coeffs)
+{
+    assert (n_coeffs == state->n_coeffs);
+
+    // the even coefficients go to the first chain, and the odd coefficients to the second
+    const auto n_stages_0 = (n_coeffs + 1) / 2;
+    for (int i = 0; i < n_coeffs; ++i)
+    {
+        const auto stage = i % 2 == 0 ? i / 2 : n_stages_0 + i / 2;
+        for (int lane = 0; lane < iir_channel_group_size; ++lane)
+            state->coeffs[stage * iir_channel_group_size + lane] = coeffs[i];
+    }
+}
+
+void iir_halfband_reset (Polyphase_IIR_State* state)
+{
+    const auto n_groups = ceiling_divide (state->n_channels, iir_channel_group_size);
+    const auto state_bytes = (size_t) (n_groups * get_iir_group_state_size (state->n_coeffs)) * sizeof (float);
+    std::memset (state->interp_state, 0, state_bytes);
+    std::memset (state->decim_state, 0, state_bytes);
+}
+
+size_t iir_halfband_scratch_bytes_required (int max_samples_in, int alignment)
+{
+    // interleaved input and output for one group of channels
+    return (size_t) round_to_next_multiple (3 * max_samples_in * iir_channel_group_size * (int) sizeof (float), alignment);
+}
+
+/** Interleaves a group of channels, with silence in the unused lanes. */
+static void interleave_iir_group (const float* const* in, float* x_data, int n_lanes, int n_samples)
+{
+    if (n_lanes < iir_channel_group_size)
+        std::memset (x_data, 0, (size_t) (n_samples * iir_channel_group_size) * sizeof (float));
+    for (int lane = 0; lane < n_lanes; ++lane)
+    {
+        const auto* x = in[lane];
+        for (int n = 0; n < n_samples; ++n)
+            x_data[n * iir_channel_group_size + lane] = x[n];
+    }
+}
+
+static void deinterleave_iir_group (const float* y_data, float* const* out, int n_lanes, int n_samples)
+{
+    for (int lane = 0; lane < n_lanes; ++lane)
+    {
+        auto* y = out[lane];
+        for (int n = 0; n < n_samples; ++n)
+            y[n] = y_data[n * iir_channel_group_size + lane];
+    }
+}
+
+void iir_halfband_process_interpolate (Polyphase_IIR_State* state,
+                                       const float* const* in,
+                                       float* const* out,
+                                       int n_channels,
+                                       int n_samples_in,
+                                       void* scratch_data,
+                                       [[maybe_unused]] bool use_avx)
+{
+    auto* x_data = (float*) scratch_data;
+    auto* y_data = x_data + n_samples_in * iir_channel_group_size;
+    for (int group_start = 0; group_start < n_channels; group_start += iir_channel_group_size)
+    {
+        const auto n_lanes = min_int (iir_channel_group_size, n_channels - group_start);
+        auto* group_state = state->interp_state + (group_start / iir_channel_group_size) * get_iir_group_state_size (state->n_coeffs);
+        interleave_iir_group (in + group_start, x_data, n_lanes, n_samples_in);
+
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        if (use_avx)
+            avx::process_iir_interp_channels (state, group_state, x_data, y_data, n_lanes, n_samples_in);
+        else
+            sse::process_iir_interp_channels (state, group_state, x_data, y_data, n_lanes, n_samples_in);
+#else
+        simd_128::process_iir_interp_channels (state, group_state, x_data, y_data, n_lanes, n_samples_in);
+#endif
+
+        deinterleave_iir_group (y_data, out + group_start, n_lanes, 2 * n_samples_in);
+    }
+}
+
+void iir_halfband_process_decimate (Polyphase_IIR_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    int n_channels,
+                                    int n_samples_in,
+                                    void* scratch_data,
+                                    [[maybe_unused]] bool use_avx)
+{
+    assert (n_samples_in % 2 == 0);
+    const auto n_samples_out = n_samples_in / 2;
+    auto* x_data = (float*) scratch_data;
+    auto* y_data = x_data + n_samples_in * iir_channel_group_size;
+    for (int group_start = 0; group_start < n_channels; group_start += iir_channel_group_size)
+    {
+        const auto n_lanes = min_int (iir_channel_group_size, n_channels - group_start);
+        auto* group_state = state->decim_state + (group_start / iir_channel_group_size) * get_iir_group_state_size (state->n_coeffs);
+        interleave_iir_group (in + group_start, x_data, n_lanes, n_samples_in);
+
+#if CHOWDSP_POLYPHASE_FIR_X86_KERNELS
+        if (use_avx)
+            avx::process_iir_decim_channels (state, group_state, x_data, y_data, n_lanes, n_samples_out);
+        else
+            sse::process_iir_decim_channels (state, group_state, x_data, y_data, n_lanes, n_samples_out);
+#else
+        simd_128::process_iir_decim_channels (state, group_state, x_data, y_data, n_lanes, n_samples_out);
+#endif
+
+        deinterleave_iir_group (y_data, out + group_start, n_lanes, n_samples_out);
+    }
 }
 } // namespace chowdsp::polyphase_fir
@@ -10,6 +10,30 @@ namespace chowdsp::polyphase_fir
 #include <stddef.h>
 #endif
 
+/**
+ * The stages of `process_interpolate()` and `process_decimate()` that are timed by the instrumentation build.
+ * The kernels write their results directly into the output buffers, so the output scatter is included in `FIR_Stage_Kernel`.
+ */
+enum Polyphase_FIR_Stage
+{
+    FIR_Stage_Input_Copy = 0,
+    FIR_Stage_Kernel = 1,
+    FIR_Stage_History_Save = 2,
+    FIR_Num_Stages = 3,
+};
+
+/**
+ * Counters recorded by the instrumentation build (see `get_stats()`).
+ * The cycle counts are in units of the CPU's timestamp counter (`rdtsc` on x86, `cntvct_el0` on ARM64),
+ * or nanoseconds on other platforms.
+ */
+struct Polyphase_FIR_Stats
+{
+    unsigned long long calls;
+    unsigned long long samples_in;
+    unsigned long long cycles[FIR_Num_Stages];
+};
+
 /**
  * Object to hold the filter's persistent state.
  *
@@ -25,11 +49,66 @@ struct Polyphase_FIR_State
     int taps_per_filter_padded {};
     int state_per_filter_padded {};
     int factor {};
+    int flags {};
+    int max_samples_in {};
+    int alignment {};
+    int max_factor {}; // only set by `init_max_factor()`
+    int max_n_taps {}; // only set by `init_max_factor()`
+    int interp_kernel {}; // Polyphase_FIR_Kernel
+    int decim_kernel {}; // Polyphase_FIR_Kernel
+    struct Polyphase_FIR_Stats* stats {}; // only used by the instrumentation build
+    unsigned int dither_state[8] {}; // used by `process_interpolate_pcm()`
+};
+
+/** Options that can be passed to `init_with_flags()`. */
+enum Polyphase_FIR_Flags
+{
+    FIR_Flags_None = 0,
+
+    /**
+     * Each channel gets its own set of filter coefficients (see `load_coeffs_channel()`).
+     * The coefficients and state are interleaved across groups of 4 channels,
+     * so that the filters of 4 channels are evaluated in a single vector pass.
+     */
+    FIR_Flag_Per_Channel_Coeffs = 1 << 0,
+
+    /**
+     * Stores the coefficients as IEEE half-precision (fp16) values, which the kernels widen
+     * to float as they're loaded. This halves the coefficient memory and bandwidth, at the cost of
+     * rounding each coefficient to 11 significant bits (normal values must fit within +/-65504).
+     * The blocked kernels are not used in this mode, and it can't be combined with `FIR_Flag_Per_Channel_Coeffs`.
+     */
+    FIR_Flag_Coeffs_F16 = 1 << 1,
+
+    /** Same as `FIR_Flag_Coeffs_F16`, but using bfloat16 (8 significant bits, with the same range as float). */
+    FIR_Flag_Coeffs_BF16 = 1 << 2,
+
+    /**
+     * The filter doesn't get any coefficient storage of its own, and instead reads its coefficients
+     * from a table attached with `coeff_bank_attach()`. `load_coeffs()` can't be used in this mode.
+     */
+    FIR_Flag_External_Coeffs = 1 << 3,
+
+    /**
+     * Each channel is a stream of complex samples, stored as interleaved (I, Q) pairs, which is processed
+     * with `process_interpolate_complex()` and `process_decimate_complex()`. The coefficients are real,
+     * unless `FIR_Flag_Complex_Coeffs` is also set. This can't be combined with the other flags, or with `init_max_factor()`.
+     */
+    FIR_Flag_Complex_Samples = 1 << 4,
+
+    /**
+     * Same as `FIR_Flag_Complex_Samples`, but with complex coefficients (see `load_coeffs_complex()`),
+     * e.g. a frequency-shifted lowpass, which selects (and shifts down) one band of the input.
+     */
+    FIR_Flag_Complex_Coeffs = 1 << 5,
 };
 
 /** Returns the number of bytes needed to construct the filter state. */
 size_t persistent_bytes_required (int n_channels, int n_taps, int factor, int max_samples_in, int alignment);
 
+/** Returns the number of bytes needed to construct the filter state with a set of `Polyphase_FIR_Flags`. */
+size_t persistent_bytes_required_with_flags (int n_channels, int n_taps, int factor, int max_samples_in, int flags, int alignment);
+
 /*
  * Initializes the filter and returns a state object.
  *
@@ -44,15 +123,137 @@ size_t persistent_bytes_required (int n_channels, int n_taps, int factor, int ma
  */
 struct Polyphase_FIR_State* init (int n_channels, int n_taps, int factor, int max_samples_in, void* persistent_data, int alignment);
 
-/** Loads a set of filter coefficients into the filter */
+/** Same as `init()`, but with a set of `Polyphase_FIR_Flags`. */
+struct Polyphase_FIR_State* init_with_flags (int n_channels, int n_taps, int factor, int max_samples_in, int flags, void* persistent_data, int alignment);
+
+/**
+ * Returns the number of bytes needed to construct a filter that can be switched between
+ * every factor up to `max_factor`, with up to `max_n_taps` taps at each factor (see `set_factor()`).
+ */
+size_t persistent_bytes_required_max_factor (int n_channels, int max_n_taps, int max_factor, int max_samples_in, int flags, int alignment);
+
+/**
+ * Same as `init_with_flags()`, but the persistent data is laid out so that `set_factor()` can switch the
+ * filter to any factor up to `max_factor` without reallocating. The filter starts out at `max_factor`,
+ * with `max_n_taps` taps. `max_samples_in` stays relative to the "interpolation" mode at every factor,
+ * and `scratch_bytes_required (max_n_taps, 1, max_samples_in, alignment)` is enough scratch for every factor.
+ */
+struct Polyphase_FIR_State* init_max_factor (int n_channels, int max_n_taps, int max_factor, int max_samples_in, int flags, void* persistent_data, int alignment);
+
+/**
+ * Re-lays out a filter from `init_max_factor()` for a new factor and number of taps, in place.
+ * This doesn't allocate, so it can be called on the audio thread. It should be followed by `load_coeffs()`
+ * (which will output silence until then), or by `coeff_bank_attach()` with `FIR_Flag_External_Coeffs`.
+ *
+ * Each channel keeps as much of its interpolator history as fits the new filter length, since
+ * that history is at the lower sample rate. The decimator history is at the old higher sample rate, so it's cleared.
+ */
+void set_factor (struct Polyphase_FIR_State* state, int factor, int n_taps);
+
+/** Loads a set of filter coefficients into the filter (for every channel, if the filter has per-channel coefficients) */
 void load_coeffs (struct Polyphase_FIR_State* state, const float* coeffs, int n_taps);
 
+/**
+ * Loads a set of filter coefficients for a single channel.
+ * The filter must have been initialized with `FIR_Flag_Per_Channel_Coeffs`,
+ * and `n_taps` must be no larger than the number of taps passed to `init_with_flags()`.
+ */
+void load_coeffs_channel (struct Polyphase_FIR_State* state, int channel, const float* coeffs, int n_taps);
+
+/**
+ * Same as `load_coeffs()`, but with the coefficients scaled by `gain`. This folds a static
+ * gain into the filter, so it doesn't cost anything while processing.
+ */
+void load_coeffs_with_gain (struct Polyphase_FIR_State* state, const float* coeffs, int n_taps, float gain);
+
+/** Same as `load_coeffs_channel()`, but with the coefficients scaled by `gain`. */
+void load_coeffs_channel_with_gain (struct Polyphase_FIR_State* state, int channel, const float* coeffs, int n_taps, float gain);
+
+/**
+ * Loads a set of complex filter coefficients, as `n_taps` interleaved (real, imaginary) pairs.
+ * The filter must have been initialized with `FIR_Flag_Complex_Coeffs`.
+ */
+void load_coeffs_complex (struct Polyphase_FIR_State* state, const float* coeffs, int n_taps);
+
+/** Returns the scratch memory required by `make_minimum_phase()` */
+size_t minimum_phase_scratch_bytes_required (int n_taps);
+
+/**
+ * Converts a filter to minimum-phase (via the real cepstrum), keeping its magnitude response.
+ *
+ * A linear-phase filter delays everything by `(n_taps - 1) / 2` samples, whereas the minimum-phase
+ * version has the least delay possible for the same magnitude response (at the cost of phase distortion),
+ * so it's useful for low-latency resampling. The result can be passed straight to `load_coeffs()`,
+ * and `min_phase_coeffs` may point to the same buffer as `coeffs`.
+ * This doesn't allocate, but is much slower than `load_coeffs()`, so it shouldn't be called on the audio thread.
+ */
+void make_minimum_phase (const float* coeffs, float* min_phase_coeffs, int n_taps, void* scratch_data);
+
+/** The delay added by a filter. */
+struct Polyphase_FIR_Latency
+{
+    double input_samples;
+    double output_samples;
+};
+
+/**
+ * Returns the latency of the filter's loaded coefficients (for a given channel), in both
+ * input and output samples for the "interpolation" or "decimation" mode of the filter.
+ *
+ * This is the group delay at DC, e.g. `(n_taps - 1) / 2` samples at the higher sample rate for a linear-phase filter.
+ * Filters that don't pass DC report the "centre of mass" of their impulse response instead.
+ */
+void get_latency (const struct Polyphase_FIR_State* state, int channel, bool decimate, struct Polyphase_FIR_Latency* latency);
+
 /** Resets the filter state */
 void reset (struct Polyphase_FIR_State* state);
 
 /** Returns the scratch memory required by the filter */
 size_t scratch_bytes_required (int n_taps, int factor, int max_samples_in, int alignment);
 
+/**
+ * The kernel variants that the filter can use for processing.
+ *
+ * The "blocked" variants compute 4 consecutive outputs per pass, re-using each coefficient load.
+ * Whether that pays off depends on the number of taps, the block size, and the CPU, so
+ * it's usually best to let `autotune()` choose.
+ */
+enum Polyphase_FIR_Kernel
+{
+    FIR_Kernel_Auto = 0, // chosen by the `use_avx` argument of the process methods
+    FIR_Kernel_SSE = 1,
+    FIR_Kernel_SSE_Blocked = 2,
+    FIR_Kernel_AVX = 3,
+    FIR_Kernel_AVX_Blocked = 4,
+    FIR_Kernel_NEON = 5,
+    FIR_Kernel_NEON_Blocked = 6,
+    FIR_Kernel_Generic = 7, // GCC/Clang vector extensions, for targets without SSE or NEON (see CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD)
+    FIR_Kernel_Generic_Blocked = 8,
+};
+
+/** Returns true if the kernel variant was compiled into the library, and is supported by this CPU. */
+bool kernel_available (enum Polyphase_FIR_Kernel kernel);
+
+/**
+ * Sets the kernels used by the filter, overriding the `use_avx` argument of the process methods.
+ * Pass `FIR_Kernel_Auto` to go back to using the `use_avx` argument.
+ */
+void set_kernels (struct Polyphase_FIR_State* state, enum Polyphase_FIR_Kernel interp_kernel, enum Polyphase_FIR_Kernel decim_kernel);
+
+/**
+ * Measures the kernel variants available on this CPU for the filter's configuration,
+ * with blocks of `n_samples_in` samples (relative to the "interpolation" mode, like `max_samples_in`),
+ * and stores the fastest interpolation and decimation kernels in the state.
+ *
+ * If `wisdom_path` is not null, any previous measurements of the same configuration are loaded from
+ * that file instead of being repeated, and new measurements are appended to it.
+ *
+ * This method allocates memory, takes a few milliseconds per kernel variant, and resets the filter state,
+ * so it should be called alongside `init()` rather than on the audio thread. The scratch data must be
+ * large enough for `n_samples_in`.
+ */
+void autotune (struct Polyphase_FIR_State* state, int n_samples_in, void* scratch_data, const char* wisdom_path);
+
 /** Process data through the "interpolation" mode of the filter */
 void process_interpolate (struct Polyphase_FIR_State* state,
                           const float* const* in,
@@ -71,7 +272,558 @@ void process_decimate (struct Polyphase_FIR_State* state,
                        void* scratch_data,
                        bool use_avx);
 
+/**
+ * Same as `process_interpolate()`, but each channel's output is scaled by `gains[ch]` (or left as-is,
+ * if `gains` is null), and either overwrites `out` or, if `accumulate` is true, is added into it.
+ * The gain and accumulation are fused into the kernels' final stores, so mixing a resampled signal
+ * into a bus doesn't need a temporary buffer, or an extra pass over the output.
+ */
+void process_interpolate_with_gain (struct Polyphase_FIR_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    const float* gains,
+                                    bool accumulate,
+                                    int n_channels,
+                                    int n_samples_in,
+                                    void* scratch_data,
+                                    bool use_avx);
+
+/** Same as `process_decimate()`, but with per-channel gains and accumulation (see `process_interpolate_with_gain()`). */
+void process_decimate_with_gain (struct Polyphase_FIR_State* state,
+                                 const float* const* in,
+                                 float* const* out,
+                                 const float* gains,
+                                 bool accumulate,
+                                 int n_channels,
+                                 int n_samples_in,
+                                 void* scratch_data,
+                                 bool use_avx);
+
+/**
+ * Same as `process_interpolate()`, for a filter with `FIR_Flag_Complex_Samples`. Each channel's input and output
+ * buffers hold interleaved (I, Q) pairs, and `n_samples_in` counts complex samples. The complex kernels process
+ * the I and Q samples together in each vector, so they don't need scratch memory, and use 128-bit vectors on every CPU.
+ */
+void process_interpolate_complex (struct Polyphase_FIR_State* state,
+                                  const float* const* in,
+                                  float* const* out,
+                                  int n_channels,
+                                  int n_samples_in);
+
+/** Same as `process_decimate()`, for a filter with `FIR_Flag_Complex_Samples` (see `process_interpolate_complex()`). */
+void process_decimate_complex (struct Polyphase_FIR_State* state,
+                               const float* const* in,
+                               float* const* out,
+                               int n_channels,
+                               int n_samples_in);
+
+/** Integer PCM sample formats, for `process_decimate_pcm()` and `process_interpolate_pcm()`. Samples are signed and little-endian. */
+enum Polyphase_FIR_PCM_Format
+{
+    FIR_PCM_Int16 = 0,
+    FIR_PCM_Int24 = 1, // packed, 3 bytes per sample
+    FIR_PCM_Int32 = 2,
+};
+
+/** Returns the scratch memory required by `process_decimate_pcm()` and `process_interpolate_pcm()` */
+size_t pcm_scratch_bytes_required (int n_taps, int factor, int max_samples_in, int alignment);
+
+/**
+ * Same as `process_decimate()`, but reading interleaved integer PCM (e.g. straight from a capture buffer),
+ * which is converted to float (scaled to [-1, 1)) as it's copied into the filter state.
+ * This can't be used with `FIR_Flag_Per_Channel_Coeffs`.
+ */
+void process_decimate_pcm (struct Polyphase_FIR_State* state,
+                           const void* in,
+                           enum Polyphase_FIR_PCM_Format in_format,
+                           float* const* out,
+                           int n_channels,
+                           int n_samples_in,
+                           void* scratch_data,
+                           bool use_avx);
+
+/**
+ * Same as `process_interpolate()`, but writing interleaved integer PCM (e.g. straight into a playback buffer).
+ * The output is scaled from [-1, 1), and clipped to the range of the format. If `dither` is true,
+ * triangular (TPDF) dither of +/-1 LSB is added before rounding (which has no effect for `FIR_PCM_Int32`,
+ * since float samples don't have 32 bits of precision).
+ * This can't be used with `FIR_Flag_Per_Channel_Coeffs`.
+ */
+void process_interpolate_pcm (struct Polyphase_FIR_State* state,
+                              const float* const* in,
+                              void* out,
+                              enum Polyphase_FIR_PCM_Format out_format,
+                              bool dither,
+                              int n_channels,
+                              int n_samples_in,
+                              void* scratch_data,
+                              bool use_avx);
+
+/**
+ * Copies the filter's instrumentation counters into `stats`, and returns true.
+ *
+ * This is safe to call from any thread while the filter is processing on another thread:
+ * each counter is read atomically, but the counters are not a consistent snapshot of each other.
+ *
+ * If the library was built without `CHOWDSP_POLYPHASE_FIR_INSTRUMENTATION`, the counters
+ * are all zero, and this method returns false.
+ */
+bool get_stats (const struct Polyphase_FIR_State* state, struct Polyphase_FIR_Stats* stats);
+
+/** Zeros the filter's instrumentation counters. This should not be called while the filter is processing. */
+void reset_stats (struct Polyphase_FIR_State* state);
+
+/**
+ * A coefficient bank file, memory-mapped by `coeff_bank_open()`.
+ *
+ * The file holds the coefficient tables of any number of filters, already reversed, padded,
+ * and laid out the way `load_coeffs()` would lay them out, so that filters can use the tables
+ * directly from the (read-only, shareable) mapping. Users should not modify the fields.
+ */
+struct Polyphase_FIR_Coeff_Bank
+{
+    const void* data {};
+    size_t size {};
+    int n_entries {};
+};
+
+/** Describes one of the coefficient tables in a `Polyphase_FIR_Coeff_Bank`. */
+struct Polyphase_FIR_Coeff_Bank_Entry
+{
+    unsigned int id {};
+    int n_taps {}; // the padded filter length, which can be passed to `init_with_flags()`
+    int factor {};
+    int flags {}; // the `Polyphase_FIR_Flags` that affect the table layout (per-channel, fp16, bf16)
+    int n_channels {}; // only relevant with `FIR_Flag_Per_Channel_Coeffs`
+    int taps_per_filter_padded {};
+    const float* coeffs {}; // points into the mapped file
+};
+
+/**
+ * Writes the coefficient tables of `n_states` filters (with their coefficients already loaded)
+ * to a coefficient bank file, tagging each table with the corresponding entry of `ids`.
+ * Returns false if the file could not be written.
+ */
+bool coeff_bank_write (const char* path, const struct Polyphase_FIR_State* const* states, const unsigned int* ids, int n_states);
+
+/** Memory-maps a coefficient bank file, and returns false if the file can't be opened or isn't a valid bank. */
+bool coeff_bank_open (struct Polyphase_FIR_Coeff_Bank* bank, const char* path);
+
+/** Unmaps a coefficient bank. Any filters attached to the bank must not be used afterwards. */
+void coeff_bank_close (struct Polyphase_FIR_Coeff_Bank* bank);
+
+/** Returns the index of the first entry in the bank with the given id, or -1 if there isn't one. */
+int coeff_bank_find (const struct Polyphase_FIR_Coeff_Bank* bank, unsigned int id);
+
+/** Fills in the description of an entry in the bank. */
+void coeff_bank_get_entry (const struct Polyphase_FIR_Coeff_Bank* bank, int index, struct Polyphase_FIR_Coeff_Bank_Entry* entry);
+
+/**
+ * Points the filter's coefficients at a table in the bank, without copying them.
+ *
+ * The filter must have been initialized with `FIR_Flag_External_Coeffs` plus the entry's layout flags,
+ * and with the same factor and padded length as the entry (e.g. by passing the entry's `n_taps` to
+ * `init_with_flags()`), with any alignment. Returns false if the table isn't compatible with the filter.
+ */
+bool coeff_bank_attach (struct Polyphase_FIR_State* state, const struct Polyphase_FIR_Coeff_Bank* bank, int index);
+
+/** Methods for interpolating between adjacent phases of the asynchronous resampler's coefficient table. */
+enum Polyphase_ASRC_Interpolation
+{
+    ASRC_Interpolation_Linear = 0,
+    ASRC_Interpolation_Cubic = 1,
+};
+
+/**
+ * Object to hold the asynchronous resampler's persistent state.
+ *
+ * Users should not instantiate this object directly,
+ * it will be provided by the `asrc_init()` method.
+ */
+struct Polyphase_ASRC_State
+{
+    float* coeffs {};
+    float* state {};
+    double time {}; // position of the next output sample, relative to the start of the next input block
+    double step {}; // input samples per output sample
+    double max_ratio {};
+    int n_channels {};
+    int n_phases {};
+    int taps_per_filter_padded {};
+    int state_per_filter_padded {};
+    int interpolation {};
+};
+
+/** Returns the number of bytes needed to construct the asynchronous resampler state. */
+size_t asrc_persistent_bytes_required (int n_channels, int n_taps, int n_phases, int max_samples_in, int alignment);
+
+/*
+ * Initializes an asynchronous (continuous-ratio) resampler, and returns a state object.
+ *
+ * The resampler evaluates a polyphase table with `n_phases` phases (i.e. a prototype filter
+ * designed at `n_phases` times the input sample rate), interpolating between adjacent phases
+ * to reach any fractional position. The resampling ratio (output rate / input rate) may be
+ * changed between blocks with `asrc_set_ratio()`, but must never exceed `max_ratio`. Until it's
+ * first set, the ratio is 1, or `max_ratio` if that's smaller.
+ *
+ * As with `init()`, the returned pointer lives inside the provided block of persistent data.
+ */
+struct Polyphase_ASRC_State* asrc_init (int n_channels,
+                                        int n_taps,
+                                        int n_phases,
+                                        int max_samples_in,
+                                        double max_ratio,
+                                        enum Polyphase_ASRC_Interpolation interpolation,
+                                        void* persistent_data,
+                                        int alignment);
+
+/**
+ * Loads a set of prototype filter coefficients into the resampler.
+ *
+ * Like the interpolation mode of the polyphase filter, each phase of the table has a DC gain of
+ * roughly `sum (coeffs) / n_phases`, so the prototype should be scaled by `n_phases` for unity gain.
+ */
+void asrc_load_coeffs (struct Polyphase_ASRC_State* state, const float* coeffs, int n_taps);
+
+/** Resets the resampler state */
+void asrc_reset (struct Polyphase_ASRC_State* state);
+
+/** Sets the resampling ratio (output sample rate / input sample rate). This may be called between any two blocks. */
+void asrc_set_ratio (struct Polyphase_ASRC_State* state, double ratio);
+
+/** Returns the number of samples that the next call to `asrc_process()` will output for a given input size. */
+int asrc_samples_out (const struct Polyphase_ASRC_State* state, int n_samples_in);
+
+/** Returns the scratch memory required by the asynchronous resampler */
+size_t asrc_scratch_bytes_required (int n_taps, int n_phases, int max_samples_in, double max_ratio, int alignment);
+
+/**
+ * Process data through the asynchronous resampler, and returns the number of samples written to each output channel.
+ *
+ * The output buffers must have room for at least `asrc_samples_out (state, n_samples_in)` samples.
+ */
+int asrc_process (struct Polyphase_ASRC_State* state,
+                  const float* const* in,
+                  float* const* out,
+                  int n_channels,
+                  int n_samples_in,
+                  void* scratch_data,
+                  bool use_avx);
+
+/**
+ * Object to hold the persistent state of a uniform polyphase DFT filter bank.
+ *
+ * Users should not instantiate this object directly,
+ * it will be provided by the `filter_bank_init()` method.
+ */
+struct Polyphase_Filter_Bank_State
+{
+    float* analysis_coeffs {};
+    float* synthesis_coeffs {};
+    float* analysis_state {};
+    float* synthesis_state {};
+    float* fft_twiddles {};
+    int* fft_bit_reverse {};
+    int n_channels {};
+    int n_bands {};
+    int hop_size {};
+    int analysis_taps_per_filter_padded {};
+    int analysis_state_per_filter_padded {};
+    int synthesis_taps_per_filter_padded {};
+    int synthesis_state_per_filter_padded {};
+    int synthesis_frame {};
+};
+
+/** Returns the number of bytes needed to construct the filter bank state. */
+size_t filter_bank_persistent_bytes_required (int n_channels, int n_taps, int n_bands, int oversampling, int max_frames, int alignment);
+
+/*
+ * Initializes a uniform DFT filter bank with `n_bands` complex subbands, and returns a state object.
+ *
+ * The number of bands must be a power of two, and `oversampling` must divide the number of bands.
+ * Each subband frame covers `n_bands / oversampling` samples (the "hop size") of the time-domain signal,
+ * so with an oversampling of 1 the filter bank is critically sampled.
+ *
+ * As with `init()`, the returned pointer lives inside the provided block of persistent data.
+ */
+struct Polyphase_Filter_Bank_State* filter_bank_init (int n_channels,
+                                                      int n_taps,
+                                                      int n_bands,
+                                                      int oversampling,
+                                                      int max_frames,
+                                                      void* persistent_data,
+                                                      int alignment);
+
+/**
+ * Loads the prototype lowpass filter, which is used for both the analysis and synthesis filter banks.
+ * With a unity-gain prototype cutting off at `pi / n_bands`, synthesis(analysis(x)) is roughly x (delayed).
+ */
+void filter_bank_load_coeffs (struct Polyphase_Filter_Bank_State* state, const float* coeffs, int n_taps);
+
+/** Resets the filter bank state */
+void filter_bank_reset (struct Polyphase_Filter_Bank_State* state);
+
+/** Returns the scratch memory required by the filter bank */
+size_t filter_bank_scratch_bytes_required (int n_taps, int n_bands, int oversampling, int max_frames, int alignment);
+
+/**
+ * Splits each channel into `n_bands` baseband subband signals (the "channelizer").
+ *
+ * `n_samples_in` must be a multiple of the number of bands, and produces `n_samples_in / hop_size` frames.
+ * Each output frame holds `n_bands` interleaved complex (real, imaginary) samples, so frame `f` of
+ * band `k` lives at `out[ch][2 * (f * n_bands + k)]`.
+ */
+void filter_bank_process_analysis (struct Polyphase_Filter_Bank_State* state,
+                                   const float* const* in,
+                                   float* const* out,
+                                   int n_channels,
+                                   int n_samples_in,
+                                   void* scratch_data,
+                                   bool use_avx);
+
+/**
+ * Recombines `n_frames` frames of subband signals (in the same layout as the analysis output),
+ * into `n_frames * hop_size` samples of each channel.
+ */
+void filter_bank_process_synthesis (struct Polyphase_Filter_Bank_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    int n_channels,
+                                    int n_frames,
+                                    void* scratch_data,
+                                    bool use_avx);
+
+/**
+ * Object to hold the persistent state of a polyphase IIR half-band filter (factor 2).
+ *
+ * Users should not instantiate this object directly,
+ * it will be provided by the `iir_halfband_init()` method.
+ */
+struct Polyphase_IIR_State
+{
+    float* coeffs {};
+    float* interp_state {};
+    float* decim_state {};
+    int n_channels {};
+    int n_coeffs {};
+};
+
+/** Returns the number of bytes needed to construct the IIR half-band filter state. */
+size_t iir_halfband_persistent_bytes_required (int n_channels, int n_coeffs, int alignment);
+
+/*
+ * Initializes a polyphase IIR half-band filter, and returns a state object.
+ *
+ * The filter is made of two parallel chains of first-order allpass sections (one per polyphase branch),
+ * with `n_coeffs` allpass coefficients in total. This reaches a similar stopband attenuation to an FIR
+ * half-band with far fewer multiplies, but the phase response isn't linear. Since the allpass recursions
+ * can't be vectorized across time, the kernels process 8 channels at once instead.
+ *
+ * As with `init()`, the returned pointer lives inside the provided block of persistent data.
+ */
+struct Polyphase_IIR_State* iir_halfband_init (int n_channels, int n_coeffs, void* persistent_data, int alignment);
+
+/**
+ * Returns the number of allpass coefficients needed for the given stopband attenuation, with the
+ * passband edge given relative to the Nyquist frequency of the lower sample rate (e.g. 0.9).
+ * The transition band of a half-band filter is symmetric about the low-rate Nyquist frequency.
+ */
+int iir_halfband_coeffs_required (double passband, double attenuation_db);
+
+/** Designs the allpass coefficients for a half-band filter with the given passband edge (as in `iir_halfband_coeffs_required()`). */
+void iir_halfband_design (float* coeffs, int n_coeffs, double passband);
+
+/** Loads a set of allpass coefficients (e.g. from `iir_halfband_design()`) into the filter. */
+void iir_halfband_load_coeffs (struct Polyphase_IIR_State* state, const float* coeffs, int n_coeffs);
+
+/** Resets the filter state */
+void iir_halfband_reset (struct Polyphase_IIR_State* state);
+
+/**
+ * Returns the scratch memory required by the IIR half-band filter, where `max_samples_in` is the
+ * largest block passed to the interpolator (the decimator may be given up to twice as many samples).
+ */
+size_t iir_halfband_scratch_bytes_required (int max_samples_in, int alignment);
+
+/**
+ * Process data through the "interpolation" mode of the filter, writing `2 * n_samples_in` samples to each output channel.
+ *
+ * As with any recursive filter, the state can decay into denormals, so the caller should
+ * enable flush-to-zero (as most audio hosts already do).
+ */
+void iir_halfband_process_interpolate (struct Polyphase_IIR_State* state,
+                                       const float* const* in,
+                                       float* const* out,
+                                       int n_channels,
+                                       int n_samples_in,
+                                       void* scratch_data,
+                                       bool use_avx);
+
+/** Process data through the "decimation" mode of the filter. `n_samples_in` must be even. */
+void iir_halfband_process_decimate (struct Polyphase_IIR_State* state,
+                                    const float* const* in,
+                                    float* const* out,
+                                    int n_channels,
+                                    int n_samples_in,
+                                    void* scratch_data,
+                                    bool use_avx);
+
+/** The direction of a `Polyphase_FIR_Worker`. */
+enum Polyphase_FIR_Worker_Mode
+{
+    FIR_Worker_Interpolate = 0,
+    FIR_Worker_Decimate = 1,
+};
+
+/**
+ * A single-producer/single-consumer ring of interleaved frames, used by `Polyphase_FIR_Worker`.
+ * The positions count frames since the worker was initialized, and each one is only ever written by
+ * one thread. They're padded out to separate cache lines, so the two threads don't contend for them.
+ */
+struct Polyphase_FIR_Ring
+{
+    float* data {};
+    int capacity_frames {};
+    unsigned long long write_pos {};
+    char write_pos_padding[56] {};
+    unsigned long long read_pos {};
+    char read_pos_padding[56] {};
+};
+
+/**
+ * Statistics reported by `worker_get_stats()`.
+ * "Overruns" are input frames that were dropped because the input ring was full,
+ * and "underruns" are output frames that were zero-filled because the output ring was empty.
+ */
+struct Polyphase_FIR_Worker_Stats
+{
+    int input_frames_queued;
+    int output_frames_queued;
+    unsigned long long overrun_frames;
+    unsigned long long underrun_frames;
+    unsigned long long batches;
+};
+
+/**
+ * Object to hold the persistent state of a threaded resampling stage,
+ * which moves a filter's processing off of the I/O thread.
+ *
+ * Users should not instantiate this object directly,
+ * it will be provided by the `worker_init()` method.
+ */
+struct Polyphase_FIR_Worker
+{
+    struct Polyphase_FIR_State* filter {};
+    void* scratch_data {};
+    float** batch_in {}; // planar buffers for the filter's input and output
+    float** batch_out {};
+    int n_channels {};
+    int mode {}; // Polyphase_FIR_Worker_Mode
+    bool use_avx {};
+    int stop_requested {};
+    unsigned long long overrun_frames {}; // only written by the producer
+    unsigned long long underrun_frames {}; // only written by the consumer
+    unsigned long long batches {}; // only written by the worker thread
+    struct Polyphase_FIR_Ring input {};
+    struct Polyphase_FIR_Ring output {};
+};
+
+/** Returns the number of bytes needed to construct the worker (including its filter, scratch, and rings). */
+size_t worker_persistent_bytes_required (int n_channels,
+                                         int n_taps,
+                                         int factor,
+                                         int max_samples_in,
+                                         int flags,
+                                         enum Polyphase_FIR_Worker_Mode mode,
+                                         int queue_frames,
+                                         int alignment);
+
+/*
+ * Initializes a threaded resampling stage, and returns a state object.
+ *
+ * The worker owns a filter (`worker->filter`, initialized as with `init_with_flags()`), which
+ * should have its coefficients loaded before processing starts. The input ring holds `queue_frames`
+ * frames (at least one batch), and the output ring holds the same duration at the output rate.
+ * Each batch is at most `max_samples_in` frames at the lower sample rate.
+ *
+ * As with `init()`, the returned pointer lives inside the provided block of persistent data.
+ */
+struct Polyphase_FIR_Worker* worker_init (int n_channels,
+                                          int n_taps,
+                                          int factor,
+                                          int max_samples_in,
+                                          int flags,
+                                          enum Polyphase_FIR_Worker_Mode mode,
+                                          int queue_frames,
+                                          bool use_avx,
+                                          void* persistent_data,
+                                          int alignment);
+
+/**
+ * Pushes up to `n_frames` frames of planar input into the input ring, and returns the number of frames
+ * that fit. The rest are dropped and counted as overruns. This is wait-free, and should only be called
+ * from a single (producer) thread.
+ */
+int worker_push (struct Polyphase_FIR_Worker* worker, const float* const* in, int n_frames);
+
+/** Same as `worker_push()`, but for interleaved input. */
+int worker_push_interleaved (struct Polyphase_FIR_Worker* worker, const float* in, int n_frames);
+
+/**
+ * Pops up to `n_frames` frames of planar output from the output ring, and returns the number of frames
+ * that were available. The rest of the output is zero-filled and counted as underruns. This is wait-free,
+ * and should only be called from a single (consumer) thread, which may be the same as the producer.
+ */
+int worker_pop (struct Polyphase_FIR_Worker* worker, float* const* out, int n_frames);
+
+/** Same as `worker_pop()`, but for interleaved output. */
+int worker_pop_interleaved (struct Polyphase_FIR_Worker* worker, float* out, int n_frames);
+
+/**
+ * Processes as many batches as the queued input and the free space in the output ring allow,
+ * and returns the number of input frames that were consumed. Batches are only ever cut short
+ * when the rings run out of input or space, so a busy worker runs `max_samples_in` batches.
+ *
+ * This is what the worker thread runs in `worker_run()`, but it can also be called directly
+ * (e.g. to process synchronously in tests, or to drain the input after `worker_stop()`).
+ */
+int worker_process (struct Polyphase_FIR_Worker* worker);
+
+/**
+ * Runs `worker_process()` in a loop (yielding whenever there's nothing to do) until `worker_stop()`
+ * is called. This should be called from the thread that should do the processing, e.g.
+ * `std::thread { worker_run, worker }`, so that users can control its priority and affinity.
+ */
+void worker_run (struct Polyphase_FIR_Worker* worker);
+
+/** Asks `worker_run()` to return. This can be called from any thread. */
+void worker_stop (struct Polyphase_FIR_Worker* worker);
+
+/** Copies the worker's queue depths and counters into `stats`. This can be called from any thread. */
+void worker_get_stats (const struct Polyphase_FIR_Worker* worker, struct Polyphase_FIR_Worker_Stats* stats);
+
 #ifdef __cplusplus
 } // namespace chowdsp::polyphase_fir
 } // extern "C"
 #endif
+
+/*
+ * Single-header mode: defining `CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION` before including this header
+ * (in exactly one translation unit, instead of linking the library) compiles the implementation into
+ * that translation unit, so that the compiler can inline calls from that translation unit, and specialize
+ * them for its constant arguments (e.g. the number of channels, or the block size), without LTO.
+ * The AVX kernels are compiled with per-function target attributes, and are still chosen at run-time.
+ */
+#if defined(__cplusplus) && defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION)
+#if ! defined(CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX)
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+#define CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX 1
+#else
+#define CHOWDSP_POLYPHASE_FIR_COMPILER_SUPPORTS_AVX 0
+#endif
+#endif
+#include "chowdsp_polyphase_fir.cpp"
+#include "chowdsp_polyphase_fir_autotune.cpp"
+#include "chowdsp_polyphase_fir_coeff_bank.cpp"
+#include "chowdsp_polyphase_fir_worker.cpp"
+#endif
@@ -0,0 +1,213 @@
+#include "chowdsp_polyphase_fir.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace chowdsp::polyphase_fir
+{
+static constexpr Polyphase_FIR_Kernel autotune_kernels[] {
+    FIR_Kernel_SSE,
+    FIR_Kernel_SSE_Blocked,
+    FIR_Kernel_AVX,
+    FIR_Kernel_AVX_Blocked,
+    FIR_Kernel_NEON,
+    FIR_Kernel_NEON_Blocked,
+    FIR_Kernel_Generic,
+    FIR_Kernel_Generic_Blocked,
+};
+
+static constexpr int autotune_warm_up_runs = 2;
+static constexpr int autotune_trials = 5;
+static constexpr double autotune_trial_seconds = 0.5e-3;
+
+static const char* get_kernel_name (int kernel)
+{
+    switch (kernel)
+    {
+        case FIR_Kernel_SSE:
+            return "sse";
+        case FIR_Kernel_SSE_Blocked:
+            return "sse_blocked";
+        case FIR_Kernel_AVX:
+            return "avx";
+        case FIR_Kernel_AVX_Blocked:
+            return "avx_blocked";
+        case FIR_Kernel_NEON:
+            return "neon";
+        case FIR_Kernel_NEON_Blocked:
+            return "neon_blocked";
+        case FIR_Kernel_Generic:
+            return "generic";
+        case FIR_Kernel_Generic_Blocked:
+            return "generic_blocked";
+        default:
+            return "auto";
+    }
+}
+
+static bool is_blocked_kernel (int kernel)
+{
+    return kernel == FIR_Kernel_SSE_Blocked || kernel == FIR_Kernel_AVX_Blocked || kernel == FIR_Kernel_NEON_Blocked || kernel == FIR_Kernel_Generic_Blocked;
+}
+
+/**
+ * Wisdom files are plain text, with one line per measured configuration:
+ * <mode> <n_channels> <factor> <taps_per_filter_padded> <n_samples_in> <flags> <kernel>
+ */
+static int load_wisdom (const char* wisdom_path, const char* mode, const Polyphase_FIR_State* state, int n_samples_in)
+{
+    auto* file = std::fopen (wisdom_path, "r");
+    if (file == nullptr)
+        return FIR_Kernel_Auto;
+
+    int kernel = FIR_Kernel_Auto;
+    char line_mode[16] {};
+    char line_kernel[32] {};
+    int n_channels, factor, taps_per_filter_padded, line_samples_in, flags;
+    while (std::fscanf (file, "%15s %d %d %d %d %d %31s", line_mode, &n_channels, &factor, &taps_per_filter_padded, &line_samples_in, &flags, line_kernel) == 7)
+    {
+        if (std::strcmp (line_mode, mode) != 0
+            || n_channels != state->n_channels
+            || factor != state->factor
+            || taps_per_filter_padded != state->taps_per_filter_padded
+            || line_samples_in != n_samples_in
+            || flags != state->flags)
+            continue;
+
+        // later lines take precedence, and kernels that aren't available here are ignored
+        for (auto candidate : autotune_kernels)
+        {
+            if (std::strcmp (line_kernel, get_kernel_name (candidate)) == 0 && kernel_available (candidate))
+                kernel = candidate;
+        }
+    }
+
+    std::fclose (file);
+    return kernel;
+}
+
+static void save_wisdom (const char* wisdom_path, const char* mode, const Polyphase_FIR_State* state, int n_samples_in, int kernel)
+{
+    auto* file = std::fopen (wisdom_path, "a");
+    if (file == nullptr)
+        return;
+
+    std::fprintf (file,
+                  "%s %d %d %d %d %d %s\n",
+                  mode,
+                  state->n_channels,
+                  state->factor,
+                  state->taps_per_filter_padded,
+                  n_samples_in,
+                  state->flags,
+                  get_kernel_name (kernel));
+    std::fclose (file);
+}
+
+static int measure_fastest_kernel (Polyphase_FIR_State* state,
+                                   bool decimate,
+                                   int n_samples_in,
+                                   const float* const* in,
+                                   float* const* out,
+                                   void* scratch_data)
+{
+    using clock = std::chrono::steady_clock;
+    const auto process = [&]
+    {
+        if (decimate)
+            process_decimate (state, in, out, state->n_channels, n_samples_in * state->factor, scratch_data, false);
+        else
+            process_interpolate (state, in, out, state->n_channels, n_samples_in, scratch_data, false);
+    };
+
+    int best_kernel = FIR_Kernel_Auto;
+    auto best_seconds = HUGE_VAL;
+    for (auto kernel : autotune_kernels)
+    {
+        // the per-channel and half-precision kernels don't have blocked variants
+        static constexpr int unblocked_flags = FIR_Flag_Per_Channel_Coeffs | FIR_Flag_Coeffs_F16 | FIR_Flag_Coeffs_BF16;
+        if (! kernel_available (kernel) || (is_blocked_kernel (kernel) && (state->flags & unblocked_flags) != 0))
+            continue;
+
+        if (decimate)
+            state->decim_kernel = kernel;
+        else
+            state->interp_kernel = kernel;
+
+        for (int i = 0; i < autotune_warm_up_runs; ++i)
+            process();
+
+        // choose the number of repetitions so that each trial is long enough for the clock
+        auto start = clock::now();
+        process();
+        const auto first_run_seconds = std::chrono::duration<double> (clock::now() - start).count();
+        const auto n_repetitions = (int) std::clamp (autotune_trial_seconds / std::max (first_run_seconds, 1.0e-9), 1.0, 1000.0);
+
+        auto kernel_seconds = HUGE_VAL;
+        for (int trial = 0; trial < autotune_trials; ++trial)
+        {
+            start = clock::now();
+            for (int i = 0; i < n_repetitions; ++i)
+                process();
+            const auto seconds = std::chrono::duration<double> (clock::now() - start).count() / (double) n_repetitions;
+            kernel_seconds = std::min (kernel_seconds, seconds);
+        }
+
+        if (kernel_seconds < best_seconds)
+        {
+            best_seconds = kernel_seconds;
+            best_kernel = kernel;
+        }
+    }
+
+    return best_kernel;
+}
+
+void autotune (Polyphase_FIR_State* state, int n_samples_in, void* scratch_data, const char* wisdom_path)
+{
+    static constexpr const char* modes[] { "interp", "decim" };
+    int kernels[2] {};
+
+    if (wisdom_path != nullptr)
+    {
+        for (int i = 0; i < 2; ++i)
+            kernels[i] = load_wisdom (wisdom_path, modes[i], state, n_samples_in);
+    }
+
+    if (kernels[0] == FIR_Kernel_Auto || kernels[1] == FIR_Kernel_Auto)
+    {
+        // both modes read and write at most `n_samples_in * factor` samples per channel
+        const auto buffer_size = (size_t) n_samples_in * (size_t) state->factor;
+        std::vector<float> in_data (buffer_size * (size_t) state->n_channels);
+        std::vector<float> out_data (buffer_size * (size_t) state->n_channels);
+        std::vector<const float*> in (state->n_channels);
+        std::vector<float*> out (state->n_channels);
+        for (int ch = 0; ch < state->n_channels; ++ch)
+        {
+            in[(size_t) ch] = in_data.data() + (size_t) ch * buffer_size;
+            out[(size_t) ch] = out_data.data() + (size_t) ch * buffer_size;
+        }
+        for (size_t n = 0; n < in_data.size(); ++n)
+            in_data[n] = std::sin (0.01f * (float) n);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            if (kernels[i] != FIR_Kernel_Auto)
+                continue;
+
+            kernels[i] = measure_fastest_kernel (state, i == 1, n_samples_in, in.data(), out.data(), scratch_data);
+            if (wisdom_path != nullptr)
+                save_wisdom (wisdom_path, modes[i], state, n_samples_in, kernels[i]);
+        }
+    }
+
+    state->interp_kernel = kernels[0];
+    state->decim_kernel = kernels[1];
+    reset (state);
+    reset_stats (state);
+}
+} // namespace chowdsp::polyphase_fir
@@ -0,0 +1,270 @@
+#include "chowdsp_polyphase_fir.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chowdsp::polyphase_fir
+{
+/**
+ * Coefficient bank files (little-endian, version 2):
+ *
+ * Header (32 bytes):
+ *   char magic[8] = "CPFIRBNK"
+ *   u32 version
+ *   u32 byte_order_mark = 0x01020304
+ *   u32 n_entries
+ *   u32 entry_bytes = 48
+ *   u64 reserved
+ *
+ * Entries (48 bytes each, immediately after the header):
+ *   u32 id, n_taps, factor, flags, n_channels, reserved, taps_per_filter_padded, reserved
+ *   u64 coeffs_offset (from the start of the file, a multiple of 64 bytes)
+ *   u64 coeffs_bytes
+ *
+ * Followed by the coefficient tables, in the same layout as the filter's own coefficient storage.
+ *
+ * Version 1 tables padded each filter to the alignment (stored in the first reserved field), rather than to a multiple of 4 taps.
+ */
+static constexpr char bank_magic[8] { 'C', 'P', 'F', 'I', 'R', 'B', 'N', 'K' };
+static constexpr uint32_t bank_version = 2;
+static constexpr uint32_t bank_byte_order_mark = 0x01020304;
+static constexpr size_t bank_header_bytes = 32;
+static constexpr size_t bank_entry_bytes = 48;
+static constexpr size_t bank_table_alignment = 64;
+static constexpr int bank_layout_flags = FIR_Flag_Per_Channel_Coeffs | FIR_Flag_Coeffs_F16 | FIR_Flag_Coeffs_BF16;
+static constexpr int bank_channel_group_size = 4; // same as the per-channel layout in chowdsp_polyphase_fir.cpp
+
+static uint32_t read_u32 (const std::byte* p)
+{
+    uint32_t x;
+    std::memcpy (&x, p, sizeof (x));
+    return x;
+}
+
+static uint64_t read_u64 (const std::byte* p)
+{
+    uint64_t x;
+    std::memcpy (&x, p, sizeof (x));
+    return x;
+}
+
+static void write_u32 (std::byte* p, uint32_t x)
+{
+    std::memcpy (p, &x, sizeof (x));
+}
+
+static void write_u64 (std::byte* p, uint64_t x)
+{
+    std::memcpy (p, &x, sizeof (x));
+}
+
+static size_t get_table_bytes (const Polyphase_FIR_State* state)
+{
+    const auto layout_flags = state->flags & bank_layout_flags;
+    const auto n_lanes = (layout_flags & FIR_Flag_Per_Channel_Coeffs) != 0
+                             ? (state->n_channels + bank_channel_group_size - 1) / bank_channel_group_size * bank_channel_group_size
+                             : 1;
+    const auto coeff_size = (layout_flags & (FIR_Flag_Coeffs_F16 | FIR_Flag_Coeffs_BF16)) != 0 ? sizeof (uint16_t) : sizeof (float);
+    return (size_t) state->taps_per_filter_padded * (size_t) state->factor * (size_t) n_lanes * coeff_size;
+}
+
+static size_t round_to_table_alignment (size_t bytes)
+{
+    return (bytes + bank_table_alignment - 1) / bank_table_alignment * bank_table_alignment;
+}
+
+static const std::byte* get_entry_data (const Polyphase_FIR_Coeff_Bank* bank, int index)
+{
+    return (const std::byte*) bank->data + bank_header_bytes + (size_t) index * bank_entry_bytes;
+}
+
+bool coeff_bank_write (const char* path, const Polyphase_FIR_State* const* states, const unsigned int* ids, int n_states)
+{
+    auto* file = std::fopen (path, "wb");
+    if (file == nullptr)
+        return false;
+
+    std::byte header[bank_header_bytes] {};
+    std::memcpy (header, bank_magic, sizeof (bank_magic));
+    write_u32 (header + 8, bank_version);
+    write_u32 (header + 12, bank_byte_order_mark);
+    write_u32 (header + 16, (uint32_t) n_states);
+    write_u32 (header + 20, (uint32_t) bank_entry_bytes);
+    auto ok = std::fwrite (header, 1, sizeof (header), file) == sizeof (header);
+
+    auto table_offset = round_to_table_alignment (bank_header_bytes + (size_t) n_states * bank_entry_bytes);
+    for (int i = 0; i < n_states && ok; ++i)
+    {
+        const auto* state = states[i];
+        const auto table_bytes = get_table_bytes (state);
+
+        std::byte entry[bank_entry_bytes] {};
+        write_u32 (entry + 0, ids[i]);
+        write_u32 (entry + 4, (uint32_t) (state->taps_per_filter_padded * state->factor));
+        write_u32 (entry + 8, (uint32_t) state->factor);
+        write_u32 (entry + 12, (uint32_t) (state->flags & bank_layout_flags));
+        write_u32 (entry + 16, (uint32_t) state->n_channels);
+        write_u32 (entry + 24, (uint32_t) state->taps_per_filter_padded);
+        write_u64 (entry + 32, (uint64_t) table_offset);
+        write_u64 (entry + 40, (uint64_t) table_bytes);
+        ok = std::fwrite (entry, 1, sizeof (entry), file) == sizeof (entry);
+        table_offset = round_to_table_alignment (table_offset + table_bytes);
+    }
+
+    static constexpr std::byte padding[bank_table_alignment] {};
+    auto position = bank_header_bytes + (size_t) n_states * bank_entry_bytes;
+    for (int i = 0; i < n_states && ok; ++i)
+    {
+        const auto table_bytes = get_table_bytes (states[i]);
+        const auto padding_bytes = round_to_table_alignment (position) - position;
+        ok = std::fwrite (padding, 1, padding_bytes, file) == padding_bytes
+             && std::fwrite (states[i]->coeffs, 1, table_bytes, file) == table_bytes;
+        position += padding_bytes + table_bytes;
+    }
+
+    return std::fclose (file) == 0 && ok;
+}
+
+static bool validate_bank (const Polyphase_FIR_Coeff_Bank* bank)
+{
+    const auto* data = (const std::byte*) bank->data;
+    if (bank->size < bank_header_bytes
+        || std::memcmp (data, bank_magic, sizeof (bank_magic)) != 0
+        || read_u32 (data + 8) != bank_version
+        || read_u32 (data + 12) != bank_byte_order_mark
+        || read_u32 (data + 20) != bank_entry_bytes)
+        return false;
+
+    const auto n_entries = (uint64_t) read_u32 (data + 16);
+    if (n_entries > (bank->size - bank_header_bytes) / bank_entry_bytes)
+        return false;
+
+    for (uint64_t i = 0; i < n_entries; ++i)
+    {
+        const auto* entry = data + bank_header_bytes + i * bank_entry_bytes;
+        const auto offset = read_u64 (entry + 32);
+        const auto bytes = read_u64 (entry + 40);
+        if (offset % bank_table_alignment != 0 || offset > bank->size || bytes > bank->size - offset)
+            return false;
+    }
+
+    return true;
+}
+
+bool coeff_bank_open (Polyphase_FIR_Coeff_Bank* bank, const char* path)
+{
+    *bank = {};
+
+    // the mapping stays valid after the file handles are closed
+#if defined(_WIN32)
+    auto file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER file_size {};
+    GetFileSizeEx (file, &file_size);
+    auto mapping = file_size.QuadPart > 0 ? CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle (file);
+    if (mapping == nullptr)
+        return false;
+    bank->data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+    bank->size = (size_t) file_size.QuadPart;
+    CloseHandle (mapping);
+#else
+    const auto fd = ::open (path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st {};
+    const auto has_size = fstat (fd, &st) == 0 && st.st_size > 0;
+    auto* ptr = has_size ? mmap (nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close (fd);
+    if (ptr != MAP_FAILED)
+    {
+        bank->data = ptr;
+        bank->size = (size_t) st.st_size;
+    }
+#endif
+
+    if (bank->data == nullptr)
+        return false;
+
+    if (! validate_bank (bank))
+    {
+        coeff_bank_close (bank);
+        return false;
+    }
+
+    bank->n_entries = (int) read_u32 ((const std::byte*) bank->data + 16);
+    return true;
+}
+
+void coeff_bank_close (Polyphase_FIR_Coeff_Bank* bank)
+{
+    if (bank->data != nullptr)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile (bank->data);
+#else
+        munmap (const_cast<void*> (bank->data), bank->size);
+#endif
+    }
+    *bank = {};
+}
+
+int coeff_bank_find (const Polyphase_FIR_Coeff_Bank* bank, unsigned int id)
+{
+    for (int i = 0; i < bank->n_entries; ++i)
+    {
+        if (read_u32 (get_entry_data (bank, i)) == id)
+            return i;
+    }
+    return -1;
+}
+
+void coeff_bank_get_entry (const Polyphase_FIR_Coeff_Bank* bank, int index, Polyphase_FIR_Coeff_Bank_Entry* entry)
+{
+    const auto* data = get_entry_data (bank, index);
+    entry->id = read_u32 (data + 0);
+    entry->n_taps = (int) read_u32 (data + 4);
+    entry->factor = (int) read_u32 (data + 8);
+    entry->flags = (int) read_u32 (data + 12);
+    entry->n_channels = (int) read_u32 (data + 16);
+    entry->taps_per_filter_padded = (int) read_u32 (data + 24);
+    entry->coeffs = reinterpret_cast<const float*> ((const std::byte*) bank->data + read_u64 (data + 32));
+}
+
+bool coeff_bank_attach (Polyphase_FIR_State* state, const Polyphase_FIR_Coeff_Bank* bank, int index)
+{
+    if (index < 0 || index >= bank->n_entries || (state->flags & FIR_Flag_External_Coeffs) == 0)
+        return false;
+
+    Polyphase_FIR_Coeff_Bank_Entry entry {};
+    coeff_bank_get_entry (bank, index, &entry);
+    if (entry.factor != state->factor
+        || entry.taps_per_filter_padded != state->taps_per_filter_padded
+        || entry.flags != (state->flags & bank_layout_flags))
+        return false;
+
+    // with per-channel coefficients, the table must cover all of the filter's channel groups
+    if ((entry.flags & FIR_Flag_Per_Channel_Coeffs) != 0
+        && (entry.n_channels + bank_channel_group_size - 1) / bank_channel_group_size < (state->n_channels + bank_channel_group_size - 1) / bank_channel_group_size)
+        return false;
+
+    if (read_u64 (get_entry_data (bank, index) + 40) < get_table_bytes (state))
+        return false;
+
+    // the kernels only ever read the coefficients, so they can point straight into the read-only mapping
+    state->coeffs = const_cast<float*> (entry.coeffs);
+    return true;
+}
+} // namespace chowdsp::polyphase_fir
@@ -0,0 +1,80 @@
+#include "chowdsp_polyphase_fir_design.h"
+
+namespace chowdsp::polyphase_fir
+{
+static size_t round_to_cache_alignment (size_t bytes)
+{
+    static constexpr size_t cache_alignment = alignof (std::max_align_t);
+    return (bytes + cache_alignment - 1) / cache_alignment * cache_alignment;
+}
+
+static bool designs_match (const Polyphase_FIR_Design& a, const Polyphase_FIR_Design& b)
+{
+    return a.n_taps == b.n_taps
+           && a.factor == b.factor
+           && a.half_band == b.half_band
+           && a.gain == b.gain
+           && a.stopband_attenuation_db == b.stopband_attenuation_db
+           && (a.half_band || a.passband == b.passband);
+}
+
+size_t design_cache_bytes_required (int n_entries, int max_taps)
+{
+    return round_to_cache_alignment (sizeof (Polyphase_FIR_Design_Cache))
+           + round_to_cache_alignment ((size_t) n_entries * sizeof (Polyphase_FIR_Design))
+           + round_to_cache_alignment ((size_t) n_entries * sizeof (unsigned long long))
+           + (size_t) n_entries * (size_t) max_taps * sizeof (float);
+}
+
+Polyphase_FIR_Design_Cache* design_cache_init (int n_entries, int max_taps, void* data)
+{
+    assert (n_entries > 0 && max_taps > 0);
+
+    auto* bytes = static_cast<std::byte*> (data);
+    auto* cache = reinterpret_cast<Polyphase_FIR_Design_Cache*> (bytes);
+    bytes += round_to_cache_alignment (sizeof (Polyphase_FIR_Design_Cache));
+
+    *cache = {};
+    cache->n_entries = n_entries;
+    cache->max_taps = max_taps;
+    cache->designs = reinterpret_cast<Polyphase_FIR_Design*> (bytes);
+    bytes += round_to_cache_alignment ((size_t) n_entries * sizeof (Polyphase_FIR_Design));
+    cache->last_used = reinterpret_cast<unsigned long long*> (bytes);
+    bytes += round_to_cache_alignment ((size_t) n_entries * sizeof (unsigned long long));
+    cache->coeffs = reinterpret_cast<float*> (bytes);
+
+    // empty entries have zero taps, and are the first to be used
+    for (int i = 0; i < n_entries; ++i)
+    {
+        cache->designs[i] = {};
+        cache->last_used[i] = 0;
+    }
+
+    return cache;
+}
+
+const float* design_cache_get (Polyphase_FIR_Design_Cache* cache, const Polyphase_FIR_Design& design)
+{
+    assert (design.n_taps <= cache->max_taps);
+
+    const auto lookup = ++cache->n_lookups;
+    auto lru_index = 0;
+    for (int i = 0; i < cache->n_entries; ++i)
+    {
+        if (cache->designs[i].n_taps > 0 && designs_match (cache->designs[i], design))
+        {
+            cache->last_used[i] = lookup;
+            return cache->coeffs + (size_t) i * (size_t) cache->max_taps;
+        }
+
+        if (cache->last_used[i] < cache->last_used[lru_index])
+            lru_index = i;
+    }
+
+    auto* coeffs = cache->coeffs + (size_t) lru_index * (size_t) cache->max_taps;
+    design_kaiser_lowpass (design, coeffs);
+    cache->designs[lru_index] = design;
+    cache->last_used[lru_index] = lookup;
+    return coeffs;
+}
+} // namespace chowdsp::polyphase_fir
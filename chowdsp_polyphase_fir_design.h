@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+namespace chowdsp::polyphase_fir
+{
+/**
+ * Parameters for a Kaiser-windowed sinc lowpass, used as the anti-imaging (interpolation)
+ * or anti-aliasing (decimation) filter of a polyphase filter with the given factor.
+ *
+ * Frequencies are relative to the Nyquist frequency of the lower sample rate, so a passband
+ * of 0.9 keeps everything up to 90% of the low-rate Nyquist frequency.
+ */
+struct Polyphase_FIR_Design
+{
+    int n_taps {};
+    int factor {};
+    double passband = 0.9;
+    double stopband_attenuation_db = 100.0;
+
+    /** DC gain of the whole filter. For unity-gain interpolation, this should be the factor. */
+    double gain = 1.0;
+
+    /**
+     * Designs a half-band filter (factor 2, odd number of taps), cutting off at exactly half of the
+     * high-rate Nyquist frequency, so that every other coefficient (except the centre) is exactly zero.
+     * The passband is then set by the number of taps and the attenuation, and the `passband` field is ignored.
+     */
+    bool half_band {};
+};
+
+namespace design_detail
+{
+    inline constexpr double pi = 3.14159265358979323846;
+
+    // The standard library maths functions aren't constexpr, so the designer uses its own.
+
+    constexpr double sqrt (double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+
+        // Newton's method, converging from above
+        auto y = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 200; ++i)
+        {
+            const auto next = 0.5 * (y + x / y);
+            if (next >= y)
+                break;
+            y = next;
+        }
+        return y;
+    }
+
+    /** x^0.4, i.e. the root of y^5 = x^2 */
+    constexpr double pow_0_4 (double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+
+        auto y = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 200; ++i)
+        {
+            const auto y4 = (y * y) * (y * y);
+            const auto next = 0.2 * (4.0 * y + x * x / y4);
+            if (next >= y)
+                break;
+            y = next;
+        }
+        return y;
+    }
+
+    constexpr double sin (double x)
+    {
+        // reduce to [-pi/2, pi/2]
+        const auto n_periods = x / (2.0 * pi);
+        x -= 2.0 * pi * (double) (long long) (n_periods + (n_periods >= 0.0 ? 0.5 : -0.5));
+        if (x > 0.5 * pi)
+            x = pi - x;
+        else if (x < -0.5 * pi)
+            x = -pi - x;
+
+        // Taylor series up to x^25, which is accurate to well below double precision in this range
+        const auto x2 = x * x;
+        auto sum = 1.0;
+        for (int k = 25; k > 1; k -= 2)
+            sum = 1.0 - x2 / (double) (k * (k - 1)) * sum;
+        return x * sum;
+    }
+
+    /** Zeroth-order modified Bessel function of the first kind */
+    constexpr double bessel_i0 (double x)
+    {
+        const auto half_x_squared = 0.25 * x * x;
+        auto term = 1.0;
+        auto sum = 1.0;
+        for (int k = 1; k < 500 && term > 1.0e-17 * sum; ++k)
+        {
+            term *= half_x_squared / (double) (k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    /** Transition width of a Kaiser-windowed filter (in radians, relative to the high sample rate) */
+    constexpr double kaiser_transition_width (int n_taps, double attenuation_db)
+    {
+        return ((attenuation_db > 21.0 ? attenuation_db : 21.0) - 7.95) / (2.285 * (double) (n_taps - 1));
+    }
+} // namespace design_detail
+
+/** Returns the Kaiser window shape parameter needed for a given stopband attenuation. */
+constexpr double kaiser_beta (double attenuation_db)
+{
+    if (attenuation_db > 50.0)
+        return 0.1102 * (attenuation_db - 8.7);
+    if (attenuation_db >= 21.0)
+        return 0.5842 * design_detail::pow_0_4 (attenuation_db - 21.0) + 0.07886 * (attenuation_db - 21.0);
+    return 0.0;
+}
+
+/**
+ * Estimates the number of taps needed for the stopband to start at the Nyquist frequency
+ * of the lower sample rate, i.e. for images/aliases to be attenuated by at least `attenuation_db`.
+ */
+constexpr int kaiser_taps_required (int factor, double passband, double attenuation_db)
+{
+    const auto transition_width = (1.0 - passband) * design_detail::pi / (double) factor;
+    const auto n_taps_exact = ((attenuation_db > 21.0 ? attenuation_db : 21.0) - 7.95) / (2.285 * transition_width) + 1.0;
+    const auto n_taps = (int) n_taps_exact + ((double) (int) n_taps_exact < n_taps_exact ? 1 : 0);
+    return n_taps > 16 ? n_taps : 16;
+}
+
+/**
+ * Designs a Kaiser-windowed sinc lowpass into `coeffs`, which must hold `design.n_taps` values.
+ *
+ * The cutoff is placed in the middle of the transition band, which starts at the passband edge,
+ * and has a width set by the number of taps and the attenuation. This doesn't allocate, and can be
+ * evaluated at compile-time.
+ */
+constexpr void design_kaiser_lowpass (const Polyphase_FIR_Design& design, float* coeffs)
+{
+    assert (design.n_taps > 0 && design.factor > 0);
+    assert (! design.half_band || (design.factor == 2 && design.n_taps % 2 == 1));
+
+    using namespace design_detail;
+    const auto n_taps = design.n_taps;
+    auto cutoff = design.half_band
+                      ? 0.5 * pi
+                      : design.passband * pi / (double) design.factor + 0.5 * kaiser_transition_width (n_taps, design.stopband_attenuation_db);
+    cutoff = cutoff < pi ? cutoff : pi;
+
+    const auto beta = kaiser_beta (design.stopband_attenuation_db);
+    const auto window_scale = 1.0 / bessel_i0 (beta);
+    const auto centre = 0.5 * (double) (n_taps - 1);
+
+    // the filter is symmetric, so only the first half needs to be computed
+    auto sum = 0.0;
+    for (int i = 0; i < (n_taps + 1) / 2; ++i)
+    {
+        const auto t = (double) i - centre;
+        const auto sinc = t == 0.0 ? cutoff / pi : sin (cutoff * t) / (pi * t);
+        const auto r = n_taps > 1 ? 2.0 * (double) i / (double) (n_taps - 1) - 1.0 : 0.0;
+        const auto window = bessel_i0 (beta * sqrt (1.0 - r * r)) * window_scale;
+
+        const auto is_half_band_zero = design.half_band && t != 0.0 && (n_taps / 2 - i) % 2 == 0;
+        const auto h = is_half_band_zero ? 0.0 : sinc * window;
+        coeffs[i] = (float) h;
+        sum += i == n_taps - 1 - i ? h : 2.0 * h;
+    }
+
+    const auto scale = design.gain / sum;
+    for (int i = 0; i < (n_taps + 1) / 2; ++i)
+    {
+        coeffs[i] = (float) ((double) coeffs[i] * scale);
+        coeffs[n_taps - 1 - i] = coeffs[i];
+    }
+}
+
+/** Designs a Kaiser-windowed sinc lowpass with a fixed number of taps, e.g. `constexpr auto coeffs = design_kaiser_lowpass<127> (design);` */
+template <int n_taps>
+constexpr std::array<float, n_taps> design_kaiser_lowpass (Polyphase_FIR_Design design)
+{
+    design.n_taps = n_taps;
+    std::array<float, n_taps> coeffs {};
+    design_kaiser_lowpass (design, coeffs.data());
+    return coeffs;
+}
+
+/**
+ * A fixed-size cache of filter designs, keyed by their parameters, so that switching between
+ * configurations (e.g. changing the factor or quality at runtime) doesn't need to re-design the filters.
+ *
+ * Users should not instantiate this object directly,
+ * it will be provided by the `design_cache_init()` method.
+ */
+struct Polyphase_FIR_Design_Cache
+{
+    Polyphase_FIR_Design* designs {};
+    unsigned long long* last_used {};
+    float* coeffs {};
+    unsigned long long n_lookups {};
+    int n_entries {};
+    int max_taps {};
+};
+
+/** Returns the number of bytes needed for a cache holding `n_entries` designs with up to `max_taps` taps each. */
+size_t design_cache_bytes_required (int n_entries, int max_taps);
+
+/**
+ * Initializes a design cache, and returns the cache object.
+ * As with `init()`, the returned pointer lives inside the provided block of data.
+ */
+Polyphase_FIR_Design_Cache* design_cache_init (int n_entries, int max_taps, void* data);
+
+/**
+ * Returns the coefficients for a design, designing them (into the least-recently used entry) if they
+ * aren't already cached. This never allocates, but the cache is not thread-safe, and the returned pointer
+ * is only valid until the entry is re-used, after at least `n_entries` other designs have been requested.
+ */
+const float* design_cache_get (Polyphase_FIR_Design_Cache* cache, const Polyphase_FIR_Design& design);
+} // namespace chowdsp::polyphase_fir
+
+#if defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION) // see chowdsp_polyphase_fir.h
+#include "chowdsp_polyphase_fir_design.cpp"
+#endif
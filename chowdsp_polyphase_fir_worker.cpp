@@ -0,0 +1,323 @@
+#include "chowdsp_polyphase_fir.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+namespace chowdsp::polyphase_fir
+{
+static size_t round_to_alignment (size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/** Returns the (input, output) frames of a full batch */
+static auto get_batch_frames (int factor, int max_samples_in, Polyphase_FIR_Worker_Mode mode)
+{
+    struct Batch_Frames
+    {
+        int in;
+        int out;
+    };
+    if (mode == FIR_Worker_Interpolate)
+        return Batch_Frames { max_samples_in, max_samples_in * factor };
+    return Batch_Frames { max_samples_in * factor, max_samples_in };
+}
+
+/** Returns the (input, output) ring capacities, so that each ring holds the same duration and at least one batch */
+static auto get_ring_frames (int factor, int max_samples_in, Polyphase_FIR_Worker_Mode mode, int queue_frames)
+{
+    struct Ring_Frames
+    {
+        int in;
+        int out;
+    };
+    const auto [batch_in, batch_out] = get_batch_frames (factor, max_samples_in, mode);
+    const auto in_frames = std::max (queue_frames, batch_in);
+    const auto out_frames = mode == FIR_Worker_Interpolate ? in_frames * factor : in_frames / factor;
+    return Ring_Frames { in_frames, std::max (out_frames, batch_out) };
+}
+
+static size_t get_worker_bytes (int n_channels, int n_taps, int factor, int max_samples_in, int flags, Polyphase_FIR_Worker_Mode mode, int queue_frames, int alignment)
+{
+    const auto [batch_in, batch_out] = get_batch_frames (factor, max_samples_in, mode);
+    const auto [ring_in, ring_out] = get_ring_frames (factor, max_samples_in, mode, queue_frames);
+    const auto float_bytes = [n_channels, alignment] (int n_frames)
+    { return round_to_alignment ((size_t) n_frames * (size_t) n_channels * sizeof (float), (size_t) alignment); };
+    const auto pointer_bytes = round_to_alignment ((size_t) n_channels * sizeof (float*), (size_t) alignment);
+
+    return round_to_alignment (sizeof (Polyphase_FIR_Worker), (size_t) alignment)
+           + 2 * pointer_bytes
+           + persistent_bytes_required_with_flags (n_channels, n_taps, factor, max_samples_in, flags, alignment)
+           + scratch_bytes_required (n_taps, factor, max_samples_in, alignment)
+           + float_bytes (batch_in)
+           + float_bytes (batch_out)
+           + float_bytes (ring_in)
+           + float_bytes (ring_out);
+}
+
+size_t worker_persistent_bytes_required (int n_channels,
+                                         int n_taps,
+                                         int factor,
+                                         int max_samples_in,
+                                         int flags,
+                                         Polyphase_FIR_Worker_Mode mode,
+                                         int queue_frames,
+                                         int alignment)
+{
+    return get_worker_bytes (n_channels, n_taps, factor, max_samples_in, flags, mode, queue_frames, alignment);
+}
+
+Polyphase_FIR_Worker* worker_init (int n_channels,
+                                   int n_taps,
+                                   int factor,
+                                   int max_samples_in,
+                                   int flags,
+                                   Polyphase_FIR_Worker_Mode mode,
+                                   int queue_frames,
+                                   bool use_avx,
+                                   void* persistent_data,
+                                   int alignment)
+{
+    auto* data = (std::byte*) persistent_data;
+
+    // "allocate" worker object
+    auto* worker = reinterpret_cast<Polyphase_FIR_Worker*> (data);
+    data += round_to_alignment (sizeof (Polyphase_FIR_Worker), (size_t) alignment);
+
+    *worker = {};
+    worker->n_channels = n_channels;
+    worker->mode = mode;
+    worker->use_avx = use_avx;
+
+    const auto filter_bytes = persistent_bytes_required_with_flags (n_channels, n_taps, factor, max_samples_in, flags, alignment);
+    worker->filter = init_with_flags (n_channels, n_taps, factor, max_samples_in, flags, data, alignment);
+    data += filter_bytes;
+    worker->scratch_data = data;
+    data += scratch_bytes_required (n_taps, factor, max_samples_in, alignment);
+
+    const auto [batch_in, batch_out] = get_batch_frames (factor, max_samples_in, mode);
+    const auto [ring_in, ring_out] = get_ring_frames (factor, max_samples_in, mode, queue_frames);
+    const auto allocate_floats = [&data, n_channels, alignment] (int n_frames)
+    {
+        auto* floats = reinterpret_cast<float*> (data);
+        const auto n_bytes = round_to_alignment ((size_t) n_frames * (size_t) n_channels * sizeof (float), (size_t) alignment);
+        std::memset (floats, 0, n_bytes);
+        data += n_bytes;
+        return floats;
+    };
+    const auto allocate_channels = [&data, &allocate_floats, n_channels, alignment] (int n_frames)
+    {
+        auto* channels = reinterpret_cast<float**> (data);
+        data += round_to_alignment ((size_t) n_channels * sizeof (float*), (size_t) alignment);
+        auto* samples = allocate_floats (n_frames);
+        for (int ch = 0; ch < n_channels; ++ch)
+            channels[ch] = samples + (size_t) ch * (size_t) n_frames;
+        return channels;
+    };
+    worker->batch_in = allocate_channels (batch_in);
+    worker->batch_out = allocate_channels (batch_out);
+    worker->input.data = allocate_floats (ring_in);
+    worker->input.capacity_frames = ring_in;
+    worker->output.data = allocate_floats (ring_out);
+    worker->output.capacity_frames = ring_out;
+
+    return worker;
+}
+
+/**
+ * The ring positions are published with release stores, and read with acquire loads,
+ * so that the frames written before a position is published are visible to the other thread.
+ * Each thread can read its own position without any ordering.
+ */
+static unsigned long long load_position (const unsigned long long& position, std::memory_order order)
+{
+    return std::atomic_ref { const_cast<unsigned long long&> (position) }.load (order);
+}
+
+static void publish_position (unsigned long long& position, unsigned long long value)
+{
+    std::atomic_ref { position }.store (value, std::memory_order_release);
+}
+
+static void increment_counter (unsigned long long& counter, unsigned long long value)
+{
+    // only one thread writes each counter, so this doesn't need a locked read-modify-write
+    std::atomic_ref<unsigned long long> counter_ref { counter };
+    counter_ref.store (counter_ref.load (std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/** Copies frames into the ring, wrapping around the end of the ring. `get_sample (n, ch)` returns each input sample. */
+template <typename Get_Sample>
+static void write_frames (Polyphase_FIR_Ring& ring, int n_channels, unsigned long long start_pos, int n_frames, Get_Sample&& get_sample)
+{
+    auto frame_idx = (int) (start_pos % (unsigned long long) ring.capacity_frames);
+    for (int n = 0; n < n_frames; ++n)
+    {
+        auto* frame = ring.data + (size_t) frame_idx * (size_t) n_channels;
+        for (int ch = 0; ch < n_channels; ++ch)
+            frame[ch] = get_sample (n, ch);
+        frame_idx = frame_idx + 1 == ring.capacity_frames ? 0 : frame_idx + 1;
+    }
+}
+
+/** Copies frames out of the ring, wrapping around the end of the ring. `set_sample (n, ch, x)` stores each output sample. */
+template <typename Set_Sample>
+static void read_frames (const Polyphase_FIR_Ring& ring, int n_channels, unsigned long long start_pos, int n_frames, Set_Sample&& set_sample)
+{
+    auto frame_idx = (int) (start_pos % (unsigned long long) ring.capacity_frames);
+    for (int n = 0; n < n_frames; ++n)
+    {
+        const auto* frame = ring.data + (size_t) frame_idx * (size_t) n_channels;
+        for (int ch = 0; ch < n_channels; ++ch)
+            set_sample (n, ch, frame[ch]);
+        frame_idx = frame_idx + 1 == ring.capacity_frames ? 0 : frame_idx + 1;
+    }
+}
+
+template <typename Get_Sample>
+static int push_frames (Polyphase_FIR_Worker* worker, int n_frames, Get_Sample&& get_sample)
+{
+    auto& ring = worker->input;
+    const auto write_pos = load_position (ring.write_pos, std::memory_order_relaxed);
+    const auto read_pos = load_position (ring.read_pos, std::memory_order_acquire);
+    const auto n_free = ring.capacity_frames - (int) (write_pos - read_pos);
+    const auto n_pushed = std::min (n_frames, n_free);
+
+    write_frames (ring, worker->n_channels, write_pos, n_pushed, get_sample);
+    publish_position (ring.write_pos, write_pos + (unsigned long long) n_pushed);
+
+    if (n_pushed < n_frames)
+        increment_counter (worker->overrun_frames, (unsigned long long) (n_frames - n_pushed));
+    return n_pushed;
+}
+
+template <typename Set_Sample>
+static int pop_frames (Polyphase_FIR_Worker* worker, int n_frames, Set_Sample&& set_sample)
+{
+    auto& ring = worker->output;
+    const auto read_pos = load_position (ring.read_pos, std::memory_order_relaxed);
+    const auto write_pos = load_position (ring.write_pos, std::memory_order_acquire);
+    const auto n_popped = std::min (n_frames, (int) (write_pos - read_pos));
+
+    read_frames (ring, worker->n_channels, read_pos, n_popped, set_sample);
+    publish_position (ring.read_pos, read_pos + (unsigned long long) n_popped);
+
+    if (n_popped < n_frames)
+    {
+        for (int n = n_popped; n < n_frames; ++n)
+            for (int ch = 0; ch < worker->n_channels; ++ch)
+                set_sample (n, ch, 0.0f);
+        increment_counter (worker->underrun_frames, (unsigned long long) (n_frames - n_popped));
+    }
+    return n_popped;
+}
+
+int worker_push (Polyphase_FIR_Worker* worker, const float* const* in, int n_frames)
+{
+    return push_frames (worker, n_frames, [in] (int n, int ch)
+                        { return in[ch][n]; });
+}
+
+int worker_push_interleaved (Polyphase_FIR_Worker* worker, const float* in, int n_frames)
+{
+    const auto n_channels = worker->n_channels;
+    return push_frames (worker, n_frames, [in, n_channels] (int n, int ch)
+                        { return in[n * n_channels + ch]; });
+}
+
+int worker_pop (Polyphase_FIR_Worker* worker, float* const* out, int n_frames)
+{
+    return pop_frames (worker, n_frames, [out] (int n, int ch, float x)
+                       { out[ch][n] = x; });
+}
+
+int worker_pop_interleaved (Polyphase_FIR_Worker* worker, float* out, int n_frames)
+{
+    const auto n_channels = worker->n_channels;
+    return pop_frames (worker, n_frames, [out, n_channels] (int n, int ch, float x)
+                       { out[n * n_channels + ch] = x; });
+}
+
+int worker_process (Polyphase_FIR_Worker* worker)
+{
+    auto& input = worker->input;
+    auto& output = worker->output;
+    const auto n_channels = worker->n_channels;
+    const auto factor = worker->filter->factor;
+    const auto max_samples_in = worker->filter->max_samples_in;
+    auto* batch_in = worker->batch_in;
+    auto* batch_out = worker->batch_out;
+
+    int n_consumed = 0;
+    while (true)
+    {
+        const auto in_read_pos = load_position (input.read_pos, std::memory_order_relaxed);
+        const auto n_queued = (int) (load_position (input.write_pos, std::memory_order_acquire) - in_read_pos);
+        const auto out_write_pos = load_position (output.write_pos, std::memory_order_relaxed);
+        const auto n_free = output.capacity_frames - (int) (out_write_pos - load_position (output.read_pos, std::memory_order_acquire));
+
+        // the number of frames at the lower sample rate, which decimation can only consume in whole multiples of the factor
+        const auto n_low_rate = worker->mode == FIR_Worker_Interpolate
+                                    ? std::min (std::min (n_queued, n_free / factor), max_samples_in)
+                                    : std::min (std::min (n_queued / factor, n_free), max_samples_in);
+        if (n_low_rate == 0)
+            break;
+
+        const auto n_in = worker->mode == FIR_Worker_Interpolate ? n_low_rate : n_low_rate * factor;
+        const auto n_out = worker->mode == FIR_Worker_Interpolate ? n_low_rate * factor : n_low_rate;
+
+        read_frames (input, n_channels, in_read_pos, n_in, [batch_in] (int n, int ch, float x)
+                     { batch_in[ch][n] = x; });
+        publish_position (input.read_pos, in_read_pos + (unsigned long long) n_in);
+
+        if (worker->mode == FIR_Worker_Interpolate)
+            process_interpolate (worker->filter, batch_in, batch_out, n_channels, n_in, worker->scratch_data, worker->use_avx);
+        else
+            process_decimate (worker->filter, batch_in, batch_out, n_channels, n_in, worker->scratch_data, worker->use_avx);
+
+        write_frames (output, n_channels, out_write_pos, n_out, [batch_out] (int n, int ch)
+                      { return batch_out[ch][n]; });
+        publish_position (output.write_pos, out_write_pos + (unsigned long long) n_out);
+
+        increment_counter (worker->batches, 1);
+        n_consumed += n_in;
+    }
+
+    return n_consumed;
+}
+
+void worker_run (Polyphase_FIR_Worker* worker)
+{
+    std::atomic_ref<int> stop_requested { worker->stop_requested };
+    while (! stop_requested.load (std::memory_order_acquire))
+    {
+        if (worker_process (worker) == 0)
+            std::this_thread::yield();
+    }
+
+    // so that the worker can be run again
+    stop_requested.store (0, std::memory_order_relaxed);
+}
+
+void worker_stop (Polyphase_FIR_Worker* worker)
+{
+    std::atomic_ref { worker->stop_requested }.store (1, std::memory_order_release);
+}
+
+void worker_get_stats (const Polyphase_FIR_Worker* worker, Polyphase_FIR_Worker_Stats* stats)
+{
+    const auto get_depth = [] (const Polyphase_FIR_Ring& ring)
+    {
+        const auto read_pos = load_position (ring.read_pos, std::memory_order_acquire);
+        return (int) (load_position (ring.write_pos, std::memory_order_acquire) - read_pos);
+    };
+    stats->input_frames_queued = get_depth (worker->input);
+    stats->output_frames_queued = get_depth (worker->output);
+    stats->overrun_frames = load_position (worker->overrun_frames, std::memory_order_relaxed);
+    stats->underrun_frames = load_position (worker->underrun_frames, std::memory_order_relaxed);
+    stats->batches = load_position (worker->batches, std::memory_order_relaxed);
+}
+} // namespace chowdsp::polyphase_fir
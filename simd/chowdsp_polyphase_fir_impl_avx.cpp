@@ -1,32 +1,104 @@
 #include "../chowdsp_polyphase_fir.h"
 
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
 #if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
 #include <immintrin.h>
 
+// In single-header mode, this file is compiled as part of the host's translation unit, without -mavx2,
+// so every function here needs the AVX2/FMA/F16C target attribute instead.
+#if defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION) && defined(__clang__)
+#pragma clang attribute push (__attribute__ ((target ("avx2,fma,f16c"))), apply_to = function)
+#elif defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION) && defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma,f16c")
+#endif
+
 namespace chowdsp::polyphase_fir::avx
 {
+/** Stores one output sample, scaled by the channel's gain, and optionally added into the existing output. */
+template <bool accumulate>
+static void store_output (float* y, float x, float gain)
+{
+    if constexpr (accumulate)
+        *y += gain * x;
+    else
+        *y = gain * x;
+}
+
+/** Same as above, for 4 consecutive output samples. */
+template <bool accumulate>
+static void store_output (float* y, __m128 x, float gain)
+{
+    x = _mm_mul_ps (x, _mm_set1_ps (gain));
+    if constexpr (accumulate)
+        x = _mm_add_ps (_mm_loadu_ps (y), x);
+    _mm_storeu_ps (y, x);
+}
+
+/*
+ * The filter taps are only padded to a multiple of 4, so when a filter's length isn't a
+ * multiple of 8 the kernels finish it with a 128-bit "tail", zero-extended to 256 bits.
+ */
+static __m256 zero_extend (__m128 x)
+{
+    return _mm256_insertf128_ps (_mm256_setzero_ps(), x, 0);
+}
+
+template <bool is_bf16 = false, typename Coeff_Type>
+static __m128 load_tail_coeffs (const Coeff_Type* coeffs)
+{
+    if constexpr (std::is_same_v<Coeff_Type, float>)
+    {
+        return _mm_loadu_ps (coeffs);
+    }
+    else
+    {
+        const auto h = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (coeffs));
+        if constexpr (is_bf16)
+            return _mm_castsi128_ps (_mm_slli_epi32 (_mm_cvtepu16_epi32 (h), 16));
+        else
+            return _mm_cvtph_ps (h);
+    }
+}
+
+/** Accumulates the last 4 taps of one filter. */
+template <bool is_bf16 = false, typename Coeff_Type>
+static __m256 accumulate_tail (const Coeff_Type* coeffs, const float* x_data, __m256 accum)
+{
+    return _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data)), zero_extend (load_tail_coeffs<is_bf16> (coeffs)), accum);
+}
+
+template <bool accumulate>
 void process_fir_interp (const Polyphase_FIR_State* state,
                          const float* ch_state,
                          float* y_data,
                          int n_samples_in,
-                         float* scratch)
+                         float* scratch,
+                         float gain)
 {
     static constexpr int v_size = 8;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
-    const auto* coeffs_v = reinterpret_cast<const __m256*> (state->coeffs);
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
     const auto one_avx = _mm256_set1_ps (1.0f);
 
     for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
     {
-        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        const auto* filter_coeffs = state->coeffs + filter_idx * state->taps_per_filter_padded;
         for (int n = 0; n < n_samples_in; ++n)
         {
             auto accum = _mm256_setzero_ps();
             for (int k = 0; k < n_taps_v; ++k)
             {
                 const auto z = _mm256_loadu_ps (ch_state + n + k * v_size);
-                accum = _mm256_fmadd_ps (z, filter_coeffs[k], accum);
+                accum = _mm256_fmadd_ps (z, _mm256_loadu_ps (filter_coeffs + k * v_size), accum);
             }
+            if (has_tail)
+                accum = accumulate_tail (filter_coeffs + tail_offset, ch_state + n + tail_offset, accum);
+
             __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
             __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
             rr = _mm256_add_ps (rr, tmp);
@@ -34,59 +106,715 @@ void process_fir_interp (const Polyphase_FIR_State* state,
         }
 
         for (int n = 0; n < n_samples_in; ++n)
-            y_data[n * state->factor + filter_idx] = scratch[n];
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
     }
 }
 
+template <bool accumulate>
 void process_fir_decim (const Polyphase_FIR_State* state,
                         const float* ch_state,
                         float* y_data,
                         int n_samples_out,
-                        float* scratch)
+                        float*,
+                        float gain)
+{
+    static constexpr int v_size = 8;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
+    const auto one_avx = _mm256_set1_ps (1.0f);
+
+    // every polyphase filter accumulates into the same register, which is reduced once per output
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        auto accum = _mm256_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = state->coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (filter_state + k * v_size);
+                accum = _mm256_fmadd_ps (z, _mm256_loadu_ps (filter_coeffs + k * v_size), accum);
+            }
+            if (has_tail)
+                accum = accumulate_tail (filter_coeffs + tail_offset, filter_state + tail_offset, accum);
+        }
+
+        __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+        __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+        rr = _mm256_add_ps (rr, tmp);
+        store_output<accumulate> (y_data + n, _mm256_cvtss_f32 (rr), gain);
+    }
+}
+
+template <bool accumulate>
+void process_fir_interp_blocked (const Polyphase_FIR_State* state,
+                                 const float* ch_state,
+                                 float* y_data,
+                                 int n_samples_in,
+                                 float* scratch,
+                                 float gain)
+{
+    static constexpr int v_size = 8;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
+    const auto one_avx = _mm256_set1_ps (1.0f);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = state->coeffs + filter_idx * state->taps_per_filter_padded;
+        int n = 0;
+        for (; n + block_size <= n_samples_in; n += block_size)
+        {
+            auto accum_0 = _mm256_setzero_ps();
+            auto accum_1 = _mm256_setzero_ps();
+            auto accum_2 = _mm256_setzero_ps();
+            auto accum_3 = _mm256_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = _mm256_loadu_ps (filter_coeffs + k * v_size);
+                const auto* x_data = ch_state + n + k * v_size;
+                accum_0 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data), coeffs, accum_0);
+                accum_1 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 1), coeffs, accum_1);
+                accum_2 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 2), coeffs, accum_2);
+                accum_3 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 3), coeffs, accum_3);
+            }
+            if (has_tail)
+            {
+                const auto coeffs = zero_extend (_mm_loadu_ps (filter_coeffs + tail_offset));
+                const auto* x_data = ch_state + n + tail_offset;
+                accum_0 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data)), coeffs, accum_0);
+                accum_1 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 1)), coeffs, accum_1);
+                accum_2 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 2)), coeffs, accum_2);
+                accum_3 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 3)), coeffs, accum_3);
+            }
+
+            // reduce the 4 accumulators into one vector of 4 outputs
+            const auto rr = _mm256_hadd_ps (_mm256_hadd_ps (accum_0, accum_1), _mm256_hadd_ps (accum_2, accum_3));
+            _mm_storeu_ps (scratch + n, _mm_add_ps (_mm256_castps256_ps128 (rr), _mm256_extractf128_ps (rr, 1)));
+        }
+
+        for (; n < n_samples_in; ++n)
+        {
+            auto accum = _mm256_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (ch_state + n + k * v_size);
+                accum = _mm256_fmadd_ps (z, _mm256_loadu_ps (filter_coeffs + k * v_size), accum);
+            }
+            if (has_tail)
+                accum = accumulate_tail (filter_coeffs + tail_offset, ch_state + n + tail_offset, accum);
+
+            __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+            __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+            rr = _mm256_add_ps (rr, tmp);
+            scratch[n] = _mm256_cvtss_f32 (rr);
+        }
+
+        for (n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool accumulate>
+void process_fir_decim_blocked (const Polyphase_FIR_State* state,
+                                const float* ch_state,
+                                float* y_data,
+                                int n_samples_out,
+                                float* scratch,
+                                float gain)
+{
+    static constexpr int v_size = 8;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
+
+    int n = 0;
+    for (; n + block_size <= n_samples_out; n += block_size)
+    {
+        auto accum_0 = _mm256_setzero_ps();
+        auto accum_1 = _mm256_setzero_ps();
+        auto accum_2 = _mm256_setzero_ps();
+        auto accum_3 = _mm256_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = state->coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = _mm256_loadu_ps (filter_coeffs + k * v_size);
+                const auto* x_data = filter_state + k * v_size;
+                accum_0 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data), coeffs, accum_0);
+                accum_1 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 1), coeffs, accum_1);
+                accum_2 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 2), coeffs, accum_2);
+                accum_3 = _mm256_fmadd_ps (_mm256_loadu_ps (x_data + 3), coeffs, accum_3);
+            }
+            if (has_tail)
+            {
+                const auto coeffs = zero_extend (_mm_loadu_ps (filter_coeffs + tail_offset));
+                const auto* x_data = filter_state + tail_offset;
+                accum_0 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data)), coeffs, accum_0);
+                accum_1 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 1)), coeffs, accum_1);
+                accum_2 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 2)), coeffs, accum_2);
+                accum_3 = _mm256_fmadd_ps (zero_extend (_mm_loadu_ps (x_data + 3)), coeffs, accum_3);
+            }
+        }
+
+        const auto rr = _mm256_hadd_ps (_mm256_hadd_ps (accum_0, accum_1), _mm256_hadd_ps (accum_2, accum_3));
+        store_output<accumulate> (y_data + n, _mm_add_ps (_mm256_castps256_ps128 (rr), _mm256_extractf128_ps (rr, 1)), gain);
+    }
+
+    if (n < n_samples_out)
+        process_fir_decim<accumulate> (state, ch_state + n, y_data + n, n_samples_out - n, scratch, gain);
+}
+
+template <bool accumulate>
+void process_fir_interp_channels (const Polyphase_FIR_State* state,
+                                  const float* group_coeffs,
+                                  const float* group_state,
+                                  float* const* y_data,
+                                  int n_lanes,
+                                  int n_samples_in,
+                                  const float* gains)
+{
+    // each register holds two consecutive taps of a group of 4 channels
+    static constexpr int group_size = 4;
+    static constexpr int v_size = 8;
+    const auto n_taps_v = state->taps_per_filter_padded / 2;
+    const auto* coeffs_v = reinterpret_cast<const __m256*> (group_coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            auto accum = _mm256_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (group_state + n * group_size + k * v_size);
+                accum = _mm256_fmadd_ps (z, filter_coeffs[k], accum);
+            }
+
+            alignas (16) float lanes[group_size];
+            _mm_store_ps (lanes, _mm_add_ps (_mm256_castps256_ps128 (accum), _mm256_extractf128_ps (accum, 1)));
+            for (int lane = 0; lane < n_lanes; ++lane)
+                store_output<accumulate> (y_data[lane] + n * state->factor + filter_idx, lanes[lane], gains[lane]);
+        }
+    }
+}
+
+template <bool accumulate>
+void process_fir_decim_channels (const Polyphase_FIR_State* state,
+                                 const float* group_coeffs,
+                                 const float* group_state,
+                                 float* const* y_data,
+                                 int n_lanes,
+                                 int n_samples_out,
+                                 const float* gains)
+{
+    static constexpr int group_size = 4;
+    static constexpr int v_size = 8;
+    const auto n_taps_v = state->taps_per_filter_padded / 2;
+    const auto* coeffs_v = reinterpret_cast<const __m256*> (group_coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        auto accum = _mm256_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = group_state + (filter_idx * state->state_per_filter_padded + n) * group_size;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (filter_state + k * v_size);
+                accum = _mm256_fmadd_ps (z, filter_coeffs[k], accum);
+            }
+        }
+
+        alignas (16) float lanes[group_size];
+        _mm_store_ps (lanes, _mm_add_ps (_mm256_castps256_ps128 (accum), _mm256_extractf128_ps (accum, 1)));
+        for (int lane = 0; lane < n_lanes; ++lane)
+            store_output<accumulate> (y_data[lane] + n, lanes[lane], gains[lane]);
+    }
+}
+
+void process_fir_asrc (const Polyphase_ASRC_State* state,
+                       const float* ch_state,
+                       float* y_data,
+                       const int* window_idx,
+                       const int* phase_row,
+                       const float* weights,
+                       int n_samples_out)
 {
     static constexpr int v_size = 8;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
     const auto* coeffs_v = reinterpret_cast<const __m256*> (state->coeffs);
-    auto* scratch_v = reinterpret_cast<__m256*> (scratch);
     const auto one_avx = _mm256_set1_ps (1.0f);
 
-    int filter_idx = 0;
-    const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-    const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded;
+    if (state->interpolation == ASRC_Interpolation_Cubic)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto* x_data = ch_state + window_idx[n];
+            const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+            const auto* coeffs_1 = coeffs_0 + n_taps_v;
+            const auto* coeffs_2 = coeffs_1 + n_taps_v;
+            const auto* coeffs_3 = coeffs_2 + n_taps_v;
+
+            auto accum_0 = _mm256_setzero_ps();
+            auto accum_1 = _mm256_setzero_ps();
+            auto accum_2 = _mm256_setzero_ps();
+            auto accum_3 = _mm256_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (x_data + k * v_size);
+                accum_0 = _mm256_fmadd_ps (z, coeffs_0[k], accum_0);
+                accum_1 = _mm256_fmadd_ps (z, coeffs_1[k], accum_1);
+                accum_2 = _mm256_fmadd_ps (z, coeffs_2[k], accum_2);
+                accum_3 = _mm256_fmadd_ps (z, coeffs_3[k], accum_3);
+            }
+
+            const auto* w = weights + 4 * n;
+            auto accum = _mm256_mul_ps (accum_0, _mm256_set1_ps (w[0]));
+            accum = _mm256_fmadd_ps (accum_1, _mm256_set1_ps (w[1]), accum);
+            accum = _mm256_fmadd_ps (accum_2, _mm256_set1_ps (w[2]), accum);
+            accum = _mm256_fmadd_ps (accum_3, _mm256_set1_ps (w[3]), accum);
+
+            __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+            __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+            rr = _mm256_add_ps (rr, tmp);
+            y_data[n] = _mm256_cvtss_f32 (rr);
+        }
+        return;
+    }
+
     for (int n = 0; n < n_samples_out; ++n)
     {
+        const auto* x_data = ch_state + window_idx[n];
+        const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+        const auto* coeffs_1 = coeffs_0 + n_taps_v;
+
+        auto accum_0 = _mm256_setzero_ps();
+        auto accum_1 = _mm256_setzero_ps();
+        for (int k = 0; k < n_taps_v; ++k)
+        {
+            const auto z = _mm256_loadu_ps (x_data + k * v_size);
+            accum_0 = _mm256_fmadd_ps (z, coeffs_0[k], accum_0);
+            accum_1 = _mm256_fmadd_ps (z, coeffs_1[k], accum_1);
+        }
+
+        const auto* w = weights + 2 * n;
+        auto accum = _mm256_mul_ps (accum_0, _mm256_set1_ps (w[0]));
+        accum = _mm256_fmadd_ps (accum_1, _mm256_set1_ps (w[1]), accum);
+
+        __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+        __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+        rr = _mm256_add_ps (rr, tmp);
+        y_data[n] = _mm256_cvtss_f32 (rr);
+    }
+}
+
+void process_fir_branches (const float* coeffs,
+                           int taps_per_filter_padded,
+                           const float* ch_state,
+                           const int* window_idx,
+                           float* y_data,
+                           int n_branches)
+{
+    static constexpr int v_size = 8;
+    const auto n_taps_v = taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m256*> (coeffs);
+    const auto one_avx = _mm256_set1_ps (1.0f);
+
+    for (int branch_idx = 0; branch_idx < n_branches; ++branch_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + branch_idx * n_taps_v;
+        const auto* x_data = ch_state + window_idx[branch_idx];
         auto accum = _mm256_setzero_ps();
         for (int k = 0; k < n_taps_v; ++k)
         {
-            const auto z = _mm256_loadu_ps (filter_state + n + k * v_size);
+            const auto z = _mm256_loadu_ps (x_data + k * v_size);
             accum = _mm256_fmadd_ps (z, filter_coeffs[k], accum);
         }
-        scratch_v[n] = accum;
+
+        __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+        __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+        rr = _mm256_add_ps (rr, tmp);
+        y_data[branch_idx] = _mm256_cvtss_f32 (rr);
     }
+}
+
+/** Widens 8 fp16 (with F16C) or bf16 coefficients to float. */
+template <bool is_bf16>
+static __m256 load_half_coeffs (const uint16_t* coeffs)
+{
+    const auto h = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (coeffs));
+    if constexpr (is_bf16)
+        return _mm256_castsi256_ps (_mm256_slli_epi32 (_mm256_cvtepu16_epi32 (h), 16));
+    else
+        return _mm256_cvtph_ps (h);
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    static constexpr int v_size = 8;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+    const auto one_avx = _mm256_set1_ps (1.0f);
 
-    for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
     {
-        filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-        filter_state = ch_state + filter_idx * state->state_per_filter_padded;
-        for (int n = 0; n < n_samples_out; ++n)
+        const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+        for (int n = 0; n < n_samples_in; ++n)
         {
             auto accum = _mm256_setzero_ps();
             for (int k = 0; k < n_taps_v; ++k)
             {
-                const auto z = _mm256_loadu_ps (filter_state + n + k * v_size);
-                accum = _mm256_fmadd_ps (z, filter_coeffs[k], accum);
+                const auto z = _mm256_loadu_ps (ch_state + n + k * v_size);
+                accum = _mm256_fmadd_ps (z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size), accum);
             }
-            scratch_v[n] = _mm256_add_ps (scratch_v[n], accum);
+            if (has_tail)
+                accum = accumulate_tail<is_bf16> (filter_coeffs + tail_offset, ch_state + n + tail_offset, accum);
+
+            __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
+            __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
+            rr = _mm256_add_ps (rr, tmp);
+            scratch[n] = _mm256_cvtss_f32 (rr);
         }
+
+        for (int n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
     }
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* ch_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float gain)
+{
+    static constexpr int v_size = 8;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto tail_offset = n_taps_v * v_size;
+    const auto has_tail = tail_offset < state->taps_per_filter_padded;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+    const auto one_avx = _mm256_set1_ps (1.0f);
 
     for (int n = 0; n < n_samples_out; ++n)
     {
-        __m256 rr = _mm256_dp_ps (scratch_v[n], one_avx, 0xff);
+        auto accum = _mm256_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm256_loadu_ps (filter_state + k * v_size);
+                accum = _mm256_fmadd_ps (z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size), accum);
+            }
+            if (has_tail)
+                accum = accumulate_tail<is_bf16> (filter_coeffs + tail_offset, filter_state + tail_offset, accum);
+        }
+
+        __m256 rr = _mm256_dp_ps (accum, one_avx, 0xff);
         __m256 tmp = _mm256_permute2f128_ps (rr, rr, 1);
         rr = _mm256_add_ps (rr, tmp);
-        y_data[n] = _mm256_cvtss_f32 (rr);
+        store_output<accumulate> (y_data + n, _mm256_cvtss_f32 (rr), gain);
+    }
+}
+
+template <bool accumulate>
+void process_fir_interp_half (const Polyphase_FIR_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              int n_samples_in,
+                              float* scratch,
+                              float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_interp_half<true, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else
+        process_fir_interp_half<false, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+}
+
+template <bool accumulate>
+void process_fir_decim_half (const Polyphase_FIR_State* state,
+                             const float* ch_state,
+                             float* y_data,
+                             int n_samples_out,
+                             float*,
+                             float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_decim_half<true, accumulate> (state, ch_state, y_data, n_samples_out, gain);
+    else
+        process_fir_decim_half<false, accumulate> (state, ch_state, y_data, n_samples_out, gain);
+}
+
+/**
+ * Runs a chain of first-order allpass sections, (a + z^-1) / (1 + a z^-1), over one sample of 8 channels.
+ * `mem[k]` holds the previous input of section `k` (which is also the previous output of section `k - 1`).
+ */
+static __m256 process_allpass_chain (__m256 x, float* mem, const float* coeffs, int n_stages)
+{
+    static constexpr int group_size = 8; // same as `iir_channel_group_size`
+    for (int k = 0; k < n_stages; ++k)
+    {
+        const auto y = _mm256_fmadd_ps (_mm256_sub_ps (x, _mm256_loadu_ps (mem + (k + 1) * group_size)),
+                                        _mm256_loadu_ps (coeffs + k * group_size),
+                                        _mm256_loadu_ps (mem + k * group_size));
+        _mm256_storeu_ps (mem + k * group_size, x);
+        x = y;
+    }
+    _mm256_storeu_ps (mem + n_stages * group_size, x);
+    return x;
+}
+
+void process_iir_interp_channels (const Polyphase_IIR_State* state,
+                                  float* group_state,
+                                  const float* x_data,
+                                  float* y_data,
+                                  [[maybe_unused]] int n_lanes,
+                                  int n_samples_in)
+{
+    // the whole group is one vector, so the unused lanes are processed too
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+
+    for (int n = 0; n < n_samples_in; ++n)
+    {
+        const auto x = _mm256_loadu_ps (x_data + n * group_size);
+        _mm256_storeu_ps (y_data + (2 * n) * group_size, process_allpass_chain (x, group_state, state->coeffs, n_stages_0));
+        _mm256_storeu_ps (y_data + (2 * n + 1) * group_size, process_allpass_chain (x, mem_1, coeffs_1, n_stages_1));
     }
 }
+
+void process_iir_decim_channels (const Polyphase_IIR_State* state,
+                                 float* group_state,
+                                 const float* x_data,
+                                 float* y_data,
+                                 [[maybe_unused]] int n_lanes,
+                                 int n_samples_out)
+{
+    // the whole group is one vector, so the unused lanes are processed too
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+    const auto half_gain = _mm256_set1_ps (0.5f);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        const auto y_0 = process_allpass_chain (_mm256_loadu_ps (x_data + (2 * n + 1) * group_size), group_state, state->coeffs, n_stages_0);
+        const auto y_1 = process_allpass_chain (_mm256_loadu_ps (x_data + (2 * n) * group_size), mem_1, coeffs_1, n_stages_1);
+        _mm256_storeu_ps (y_data + n * group_size, _mm256_mul_ps (_mm256_add_ps (y_0, y_1), half_gain));
+    }
+}
+
+/** Loads 8 PCM samples, as integers scaled to the full 32-bit range */
+static __m256i load_pcm_samples (const std::byte* in, int format)
+{
+    if (format == FIR_PCM_Int16)
+        return _mm256_slli_epi32 (_mm256_cvtepi16_epi32 (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (in))), 16);
+    if (format == FIR_PCM_Int32)
+        return _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (in));
+
+    // each 128-bit lane unpacks 4 of the packed 24-bit samples (reading 4 bytes past the last sample)
+    const auto shuffle = _mm256_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const auto packed = _mm256_setr_m128i (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (in)),
+                                           _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in + 12)));
+    return _mm256_shuffle_epi8 (packed, shuffle);
+}
+
+void convert_pcm_to_float (const std::byte* in, int format, float* out, int n_samples)
+{
+    static constexpr int v_size = 8;
+    const auto bytes_per_sample = format == FIR_PCM_Int16 ? 2 : (format == FIR_PCM_Int24 ? 3 : 4);
+    const auto n_samples_vector = format == FIR_PCM_Int24 ? n_samples - 2 : n_samples; // keeps the over-read in bounds
+    const auto scale = _mm256_set1_ps (1.0f / 2147483648.0f);
+
+    int n = 0;
+    for (; n + v_size <= n_samples_vector; n += v_size)
+        _mm256_storeu_ps (out + n, _mm256_mul_ps (_mm256_cvtepi32_ps (load_pcm_samples (in + n * bytes_per_sample, format)), scale));
+
+    for (; n < n_samples; n += v_size)
+    {
+        const auto n_tail = n_samples - n < v_size ? n_samples - n : v_size;
+        std::byte in_tail[v_size * 4 + 4] {};
+        float out_tail[v_size];
+        std::memcpy (in_tail, in + n * bytes_per_sample, (size_t) (n_tail * bytes_per_sample));
+        _mm256_storeu_ps (out_tail, _mm256_mul_ps (_mm256_cvtepi32_ps (load_pcm_samples (in_tail, format)), scale));
+        std::memcpy (out + n, out_tail, (size_t) n_tail * sizeof (float));
+    }
+}
+
+static __m256 get_dither (__m256i& rng_state)
+{
+    rng_state = _mm256_xor_si256 (rng_state, _mm256_slli_epi32 (rng_state, 13));
+    rng_state = _mm256_xor_si256 (rng_state, _mm256_srli_epi32 (rng_state, 17));
+    rng_state = _mm256_xor_si256 (rng_state, _mm256_slli_epi32 (rng_state, 5));
+
+    const auto sum = _mm256_add_epi32 (_mm256_srli_epi32 (rng_state, 16), _mm256_and_si256 (rng_state, _mm256_set1_epi32 (0xffff)));
+    return _mm256_fmsub_ps (_mm256_cvtepi32_ps (sum), _mm256_set1_ps (1.0f / 65536.0f), _mm256_set1_ps (1.0f));
+}
+
+void convert_float_to_int (const float* in, int32_t* out, int n_samples, float scale, float max_value, unsigned int* dither_state)
+{
+    static constexpr int v_size = 8;
+    const auto scale_v = _mm256_set1_ps (scale);
+    const auto min_v = _mm256_set1_ps (-scale);
+    const auto max_v = _mm256_set1_ps (max_value);
+    auto rng_state = dither_state != nullptr ? _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (dither_state)) : _mm256_setzero_si256();
+
+    const auto convert = [&] (const float* x, int32_t* y)
+    {
+        auto v = _mm256_mul_ps (_mm256_loadu_ps (x), scale_v);
+        if (dither_state != nullptr)
+            v = _mm256_add_ps (v, get_dither (rng_state));
+        v = _mm256_min_ps (_mm256_max_ps (v, min_v), max_v);
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (y), _mm256_cvtps_epi32 (v));
+    };
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        convert (in + n, out + n);
+
+    if (n < n_samples)
+    {
+        float in_tail[v_size] {};
+        int32_t out_tail[v_size];
+        std::memcpy (in_tail, in + n, (size_t) (n_samples - n) * sizeof (float));
+        convert (in_tail, out_tail);
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (int32_t));
+    }
+
+    if (dither_state != nullptr)
+        _mm256_storeu_si256 (reinterpret_cast<__m256i*> (dither_state), rng_state);
+}
+
+// the kernels are declared (as templates) in chowdsp_polyphase_fir.cpp, so they need to be instantiated here
+template void process_fir_interp<false> (const Polyphase_FIR_State* state,
+                                         const float* ch_state,
+                                         float* y_data,
+                                         int n_samples_in,
+                                         float* scratch,
+                                         float gain);
+template void process_fir_interp<true> (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in,
+                                        float* scratch,
+                                        float gain);
+template void process_fir_decim<false> (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_out,
+                                        float*,
+                                        float gain);
+template void process_fir_decim<true> (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out,
+                                       float*,
+                                       float gain);
+template void process_fir_interp_blocked<false> (const Polyphase_FIR_State* state,
+                                                 const float* ch_state,
+                                                 float* y_data,
+                                                 int n_samples_in,
+                                                 float* scratch,
+                                                 float gain);
+template void process_fir_interp_blocked<true> (const Polyphase_FIR_State* state,
+                                                const float* ch_state,
+                                                float* y_data,
+                                                int n_samples_in,
+                                                float* scratch,
+                                                float gain);
+template void process_fir_decim_blocked<false> (const Polyphase_FIR_State* state,
+                                                const float* ch_state,
+                                                float* y_data,
+                                                int n_samples_out,
+                                                float* scratch,
+                                                float gain);
+template void process_fir_decim_blocked<true> (const Polyphase_FIR_State* state,
+                                               const float* ch_state,
+                                               float* y_data,
+                                               int n_samples_out,
+                                               float* scratch,
+                                               float gain);
+template void process_fir_interp_channels<false> (const Polyphase_FIR_State* state,
+                                                  const float* group_coeffs,
+                                                  const float* group_state,
+                                                  float* const* y_data,
+                                                  int n_lanes,
+                                                  int n_samples_in,
+                                                  const float* gains);
+template void process_fir_interp_channels<true> (const Polyphase_FIR_State* state,
+                                                 const float* group_coeffs,
+                                                 const float* group_state,
+                                                 float* const* y_data,
+                                                 int n_lanes,
+                                                 int n_samples_in,
+                                                 const float* gains);
+template void process_fir_decim_channels<false> (const Polyphase_FIR_State* state,
+                                                 const float* group_coeffs,
+                                                 const float* group_state,
+                                                 float* const* y_data,
+                                                 int n_lanes,
+                                                 int n_samples_out,
+                                                 const float* gains);
+template void process_fir_decim_channels<true> (const Polyphase_FIR_State* state,
+                                                const float* group_coeffs,
+                                                const float* group_state,
+                                                float* const* y_data,
+                                                int n_lanes,
+                                                int n_samples_out,
+                                                const float* gains);
+template void process_fir_interp_half<false> (const Polyphase_FIR_State* state,
+                                              const float* ch_state,
+                                              float* y_data,
+                                              int n_samples_in,
+                                              float* scratch,
+                                              float gain);
+template void process_fir_interp_half<true> (const Polyphase_FIR_State* state,
+                                             const float* ch_state,
+                                             float* y_data,
+                                             int n_samples_in,
+                                             float* scratch,
+                                             float gain);
+template void process_fir_decim_half<false> (const Polyphase_FIR_State* state,
+                                             const float* ch_state,
+                                             float* y_data,
+                                             int n_samples_out,
+                                             float*,
+                                             float gain);
+template void process_fir_decim_half<true> (const Polyphase_FIR_State* state,
+                                            const float* ch_state,
+                                            float* y_data,
+                                            int n_samples_out,
+                                            float*,
+                                            float gain);
 } // namespace chowdsp::polyphase_fir::avx
+
+#if defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION) && defined(__clang__)
+#pragma clang attribute pop
+#elif defined(CHOWDSP_POLYPHASE_FIR_IMPLEMENTATION) && defined(__GNUC__)
+#pragma GCC pop_options
+#endif
 #endif
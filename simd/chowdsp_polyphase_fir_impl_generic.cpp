@@ -0,0 +1,708 @@
+/*
+ * Portable kernels, written with the GCC/Clang vector extensions, for targets without SSE or NEON
+ * (e.g. RISC-V, POWER, or s390x), or when CHOWDSP_POLYPHASE_FIR_GENERIC_SIMD is defined. The compiler
+ * lowers each 4-float vector to whatever the target has (RVV, VSX, VX, ...), or to scalar code.
+ */
+namespace chowdsp::polyphase_fir::generic
+{
+typedef float float32x4 __attribute__ ((vector_size (16)));
+typedef int32_t int32x4 __attribute__ ((vector_size (16)));
+typedef uint32_t uint32x4 __attribute__ ((vector_size (16)));
+typedef int16_t int16x4 __attribute__ ((vector_size (8)));
+typedef uint16_t uint16x4 __attribute__ ((vector_size (8)));
+
+/** Loads a vector from memory, with no alignment requirements. */
+template <typename Vec>
+static Vec load_unaligned (const void* data)
+{
+    Vec v;
+    std::memcpy (&v, data, sizeof (v));
+    return v;
+}
+
+/** Stores a vector to memory, with no alignment requirements. */
+template <typename Vec>
+static void store_unaligned (void* data, Vec v)
+{
+    std::memcpy (data, &v, sizeof (v));
+}
+
+static float32x4 broadcast (float x)
+{
+    return float32x4 { x, x, x, x };
+}
+
+/** Sums the lanes in the same order as the SSE kernels. */
+static float horizontal_add (float32x4 x)
+{
+    return (x[0] + x[2]) + (x[1] + x[3]);
+}
+
+/** Stores one output sample, scaled by the channel's gain, and optionally added into the existing output. */
+template <bool accumulate>
+static void store_output (float* y, float x, float gain)
+{
+    if constexpr (accumulate)
+        *y += gain * x;
+    else
+        *y = gain * x;
+}
+
+/** Same as above, for 4 consecutive output samples. */
+template <bool accumulate>
+static void store_output (float* y, float32x4 x, float gain)
+{
+    x *= broadcast (gain);
+    if constexpr (accumulate)
+        x += load_unaligned<float32x4> (y);
+    store_unaligned (y, x);
+}
+
+template <bool accumulate>
+static void process_fir_interp (const Polyphase_FIR_State* state,
+                                const float* ch_state,
+                                float* y_data,
+                                int n_samples_in,
+                                float* scratch,
+                                float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            float32x4 accum_0 {};
+            float32x4 accum_1 {};
+            int k = 0;
+            for (; k + 1 < n_taps_v; k += 2)
+            {
+                accum_0 += load_unaligned<float32x4> (ch_state + n + k * v_size) * filter_coeffs[k];
+                accum_1 += load_unaligned<float32x4> (ch_state + n + (k + 1) * v_size) * filter_coeffs[k + 1];
+            }
+            for (; k < n_taps_v; ++k)
+                accum_0 += load_unaligned<float32x4> (ch_state + n + k * v_size) * filter_coeffs[k];
+
+            scratch[n] = horizontal_add (accum_0 + accum_1);
+        }
+
+        for (int n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim (const Polyphase_FIR_State* state,
+                               const float* channel_state,
+                               float* y_data,
+                               int n_samples_out,
+                               float*,
+                               float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+
+    // every polyphase filter accumulates into the same registers, which are reduced once per output
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4 accum_0 {};
+        float32x4 accum_1 {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = channel_state + filter_idx * state->state_per_filter_padded + n;
+            int k = 0;
+            for (; k + 1 < n_taps_v; k += 2)
+            {
+                accum_0 += load_unaligned<float32x4> (filter_state + k * v_size) * filter_coeffs[k];
+                accum_1 += load_unaligned<float32x4> (filter_state + (k + 1) * v_size) * filter_coeffs[k + 1];
+            }
+            for (; k < n_taps_v; ++k)
+                accum_0 += load_unaligned<float32x4> (filter_state + k * v_size) * filter_coeffs[k];
+        }
+
+        store_output<accumulate> (y_data + n, horizontal_add (accum_0 + accum_1), gain);
+    }
+}
+
+static float32x4 horizontal_add_4 (float32x4 accum_0, float32x4 accum_1, float32x4 accum_2, float32x4 accum_3)
+{
+    return float32x4 { horizontal_add (accum_0), horizontal_add (accum_1), horizontal_add (accum_2), horizontal_add (accum_3) };
+}
+
+template <bool accumulate>
+static void process_fir_interp_blocked (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in,
+                                        float* scratch,
+                                        float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        int n = 0;
+        for (; n + block_size <= n_samples_in; n += block_size)
+        {
+            float32x4 accum_0 {};
+            float32x4 accum_1 {};
+            float32x4 accum_2 {};
+            float32x4 accum_3 {};
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = ch_state + n + k * v_size;
+                accum_0 += load_unaligned<float32x4> (x_data) * coeffs;
+                accum_1 += load_unaligned<float32x4> (x_data + 1) * coeffs;
+                accum_2 += load_unaligned<float32x4> (x_data + 2) * coeffs;
+                accum_3 += load_unaligned<float32x4> (x_data + 3) * coeffs;
+            }
+            store_unaligned (scratch + n, horizontal_add_4 (accum_0, accum_1, accum_2, accum_3));
+        }
+
+        for (; n < n_samples_in; ++n)
+        {
+            float32x4 accum {};
+            for (int k = 0; k < n_taps_v; ++k)
+                accum += load_unaligned<float32x4> (ch_state + n + k * v_size) * filter_coeffs[k];
+            scratch[n] = horizontal_add (accum);
+        }
+
+        for (n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_blocked (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out,
+                                       float* scratch,
+                                       float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+
+    int n = 0;
+    for (; n + block_size <= n_samples_out; n += block_size)
+    {
+        float32x4 accum_0 {};
+        float32x4 accum_1 {};
+        float32x4 accum_2 {};
+        float32x4 accum_3 {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = filter_state + k * v_size;
+                accum_0 += load_unaligned<float32x4> (x_data) * coeffs;
+                accum_1 += load_unaligned<float32x4> (x_data + 1) * coeffs;
+                accum_2 += load_unaligned<float32x4> (x_data + 2) * coeffs;
+                accum_3 += load_unaligned<float32x4> (x_data + 3) * coeffs;
+            }
+        }
+
+        store_output<accumulate> (y_data + n, horizontal_add_4 (accum_0, accum_1, accum_2, accum_3), gain);
+    }
+
+    if (n < n_samples_out)
+        process_fir_decim<accumulate> (state, ch_state + n, y_data + n, n_samples_out - n, scratch, gain);
+}
+
+template <bool accumulate>
+static void process_fir_interp_channels (const Polyphase_FIR_State* state,
+                                         const float* group_coeffs,
+                                         const float* group_state,
+                                         float* const* y_data,
+                                         int n_lanes,
+                                         int n_samples_in,
+                                         const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (group_coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            float32x4 accum {};
+            for (int k = 0; k < n_taps; ++k)
+                accum += load_unaligned<float32x4> (group_state + (n + k) * v_size) * filter_coeffs[k];
+
+            for (int lane = 0; lane < n_lanes; ++lane)
+                store_output<accumulate> (y_data[lane] + n * state->factor + filter_idx, accum[lane], gains[lane]);
+        }
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_channels (const Polyphase_FIR_State* state,
+                                        const float* group_coeffs,
+                                        const float* group_state,
+                                        float* const* y_data,
+                                        int n_lanes,
+                                        int n_samples_out,
+                                        const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (group_coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4 accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+            const auto* filter_state = group_state + (filter_idx * state->state_per_filter_padded + n) * v_size;
+            for (int k = 0; k < n_taps; ++k)
+                accum += load_unaligned<float32x4> (filter_state + k * v_size) * filter_coeffs[k];
+        }
+
+        for (int lane = 0; lane < n_lanes; ++lane)
+            store_output<accumulate> (y_data[lane] + n, accum[lane], gains[lane]);
+    }
+}
+
+static void process_fir_asrc (const Polyphase_ASRC_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              const int* window_idx,
+                              const int* phase_row,
+                              const float* weights,
+                              int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+
+    if (state->interpolation == ASRC_Interpolation_Cubic)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto* x_data = ch_state + window_idx[n];
+            const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+            const auto* coeffs_1 = coeffs_0 + n_taps_v;
+            const auto* coeffs_2 = coeffs_1 + n_taps_v;
+            const auto* coeffs_3 = coeffs_2 + n_taps_v;
+
+            float32x4 accum_0 {};
+            float32x4 accum_1 {};
+            float32x4 accum_2 {};
+            float32x4 accum_3 {};
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = load_unaligned<float32x4> (x_data + k * v_size);
+                accum_0 += z * coeffs_0[k];
+                accum_1 += z * coeffs_1[k];
+                accum_2 += z * coeffs_2[k];
+                accum_3 += z * coeffs_3[k];
+            }
+
+            const auto* w = weights + 4 * n;
+            const auto accum = accum_0 * broadcast (w[0]) + accum_1 * broadcast (w[1]) + accum_2 * broadcast (w[2]) + accum_3 * broadcast (w[3]);
+            y_data[n] = horizontal_add (accum);
+        }
+        return;
+    }
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        const auto* x_data = ch_state + window_idx[n];
+        const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+        const auto* coeffs_1 = coeffs_0 + n_taps_v;
+
+        float32x4 accum_0 {};
+        float32x4 accum_1 {};
+        for (int k = 0; k < n_taps_v; ++k)
+        {
+            const auto z = load_unaligned<float32x4> (x_data + k * v_size);
+            accum_0 += z * coeffs_0[k];
+            accum_1 += z * coeffs_1[k];
+        }
+
+        const auto* w = weights + 2 * n;
+        y_data[n] = horizontal_add (accum_0 * broadcast (w[0]) + accum_1 * broadcast (w[1]));
+    }
+}
+
+static void process_fir_branches (const float* coeffs,
+                                  int taps_per_filter_padded,
+                                  const float* ch_state,
+                                  const int* window_idx,
+                                  float* y_data,
+                                  int n_branches)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (coeffs);
+
+    for (int branch_idx = 0; branch_idx < n_branches; ++branch_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + branch_idx * n_taps_v;
+        const auto* x_data = ch_state + window_idx[branch_idx];
+        float32x4 accum_0 {};
+        float32x4 accum_1 {};
+        int k = 0;
+        for (; k + 1 < n_taps_v; k += 2)
+        {
+            accum_0 += load_unaligned<float32x4> (x_data + k * v_size) * filter_coeffs[k];
+            accum_1 += load_unaligned<float32x4> (x_data + (k + 1) * v_size) * filter_coeffs[k + 1];
+        }
+        for (; k < n_taps_v; ++k)
+            accum_0 += load_unaligned<float32x4> (x_data + k * v_size) * filter_coeffs[k];
+
+        y_data[branch_idx] = horizontal_add (accum_0 + accum_1);
+    }
+}
+
+/**
+ * Widens 4 fp16 or bf16 coefficients to float. The fp16 conversion only uses integer operations and
+ * normal floats, so it gives the same results as `half_to_float()`, even with denormals flushed to zero.
+ */
+template <bool is_bf16>
+static float32x4 load_half_coeffs (const uint16_t* coeffs)
+{
+    const auto h = __builtin_convertvector (load_unaligned<uint16x4> (coeffs), uint32x4);
+    if constexpr (is_bf16)
+        return (float32x4) (h << 16);
+
+    static constexpr uint32_t exponent_mask = 0x7c00u << 13;
+    auto bits = (h & 0x7fff) << 13;
+    const auto exponent = bits & exponent_mask;
+    const auto is_inf_or_nan = (uint32x4) (exponent == exponent_mask);
+    const auto is_subnormal = (uint32x4) (exponent == 0);
+
+    bits += (uint32_t) (127 - 15) << 23; // re-bias the exponent
+    bits += is_inf_or_nan & ((uint32_t) (128 - 16) << 23);
+    bits += is_subnormal & (1u << 23); // subnormals: 2^-14 * (1 + mantissa), minus 2^-14
+    const auto subnormal_bits = (uint32x4) ((float32x4) bits - (float32x4) (is_subnormal & (113u << 23)));
+    bits = (subnormal_bits & is_subnormal) | (bits & ~is_subnormal);
+    return (float32x4) (bits | ((h & 0x8000) << 16));
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            float32x4 accum {};
+            for (int k = 0; k < n_taps_v; ++k)
+                accum += load_unaligned<float32x4> (ch_state + n + k * v_size) * load_half_coeffs<is_bf16> (filter_coeffs + k * v_size);
+            scratch[n] = horizontal_add (accum);
+        }
+
+        for (int n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* channel_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4 accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = channel_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+                accum += load_unaligned<float32x4> (filter_state + k * v_size) * load_half_coeffs<is_bf16> (filter_coeffs + k * v_size);
+        }
+
+        store_output<accumulate> (y_data + n, horizontal_add (accum), gain);
+    }
+}
+
+/** Same as `process_fir_interp()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_interp_half<true, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else
+        process_fir_interp_half<false, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+}
+
+/** Same as `process_fir_decim()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* channel_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float*,
+                                    float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_decim_half<true, accumulate> (state, channel_state, y_data, n_samples_out, gain);
+    else
+        process_fir_decim_half<false, accumulate> (state, channel_state, y_data, n_samples_out, gain);
+}
+
+/**
+ * Runs a chain of first-order allpass sections, (a + z^-1) / (1 + a z^-1), over one sample of 4 channels.
+ * `mem[k]` holds the previous input of section `k` (which is also the previous output of section `k - 1`).
+ */
+static float32x4 process_allpass_chain (float32x4 x, float* mem, const float* coeffs, int n_stages)
+{
+    static constexpr int group_size = 8; // same as `iir_channel_group_size`
+    for (int k = 0; k < n_stages; ++k)
+    {
+        const auto y = load_unaligned<float32x4> (mem + k * group_size)
+                       + (x - load_unaligned<float32x4> (mem + (k + 1) * group_size)) * load_unaligned<float32x4> (coeffs + k * group_size);
+        store_unaligned (mem + k * group_size, x);
+        x = y;
+    }
+    store_unaligned (mem + n_stages * group_size, x);
+    return x;
+}
+
+static void process_iir_interp_channels (const Polyphase_IIR_State* state,
+                                         float* group_state,
+                                         const float* x_data,
+                                         float* y_data,
+                                         int n_lanes,
+                                         int n_samples_in)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+
+    // each half of the group is a separate vector
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            const auto x = load_unaligned<float32x4> (x_data + n * group_size + half);
+            store_unaligned (y_data + (2 * n) * group_size + half, process_allpass_chain (x, group_state + half, state->coeffs + half, n_stages_0));
+            store_unaligned (y_data + (2 * n + 1) * group_size + half, process_allpass_chain (x, mem_1 + half, coeffs_1 + half, n_stages_1));
+        }
+    }
+}
+
+static void process_iir_decim_channels (const Polyphase_IIR_State* state,
+                                        float* group_state,
+                                        const float* x_data,
+                                        float* y_data,
+                                        int n_lanes,
+                                        int n_samples_out)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto y_0 = process_allpass_chain (load_unaligned<float32x4> (x_data + (2 * n + 1) * group_size + half), group_state + half, state->coeffs + half, n_stages_0);
+            const auto y_1 = process_allpass_chain (load_unaligned<float32x4> (x_data + (2 * n) * group_size + half), mem_1 + half, coeffs_1 + half, n_stages_1);
+            store_unaligned (y_data + n * group_size + half, (y_0 + y_1) * broadcast (0.5f));
+        }
+    }
+}
+
+/** Loads 4 PCM samples, as integers scaled to the full 32-bit range */
+static int32x4 load_pcm_samples (const std::byte* in, int format)
+{
+    if (format == FIR_PCM_Int16)
+        return __builtin_convertvector (load_unaligned<int16x4> (in), int32x4) << 16;
+    if (format == FIR_PCM_Int32)
+        return load_unaligned<int32x4> (in);
+
+    const auto* bytes = reinterpret_cast<const uint8_t*> (in);
+    int32x4 samples;
+    for (int i = 0; i < 4; ++i)
+        samples[i] = (int32_t) (((uint32_t) bytes[3 * i] << 8) | ((uint32_t) bytes[3 * i + 1] << 16) | ((uint32_t) bytes[3 * i + 2] << 24));
+    return samples;
+}
+
+static void convert_pcm_to_float (const std::byte* in, int format, float* out, int n_samples)
+{
+    static constexpr int v_size = 4;
+    const auto bytes_per_sample = format == FIR_PCM_Int16 ? 2 : (format == FIR_PCM_Int24 ? 3 : 4);
+    const auto scale = broadcast (1.0f / 2147483648.0f);
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        store_unaligned (out + n, __builtin_convertvector (load_pcm_samples (in + n * bytes_per_sample, format), float32x4) * scale);
+
+    if (n < n_samples)
+    {
+        std::byte in_tail[v_size * 4] {};
+        float out_tail[v_size];
+        std::memcpy (in_tail, in + n * bytes_per_sample, (size_t) ((n_samples - n) * bytes_per_sample));
+        store_unaligned (out_tail, __builtin_convertvector (load_pcm_samples (in_tail, format), float32x4) * scale);
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (float));
+    }
+}
+
+static float32x4 get_dither (uint32x4& rng_state)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+
+    const auto sum = (rng_state >> 16) + (rng_state & 0xffff);
+    return __builtin_convertvector (sum, float32x4) * broadcast (1.0f / 65536.0f) - broadcast (1.0f);
+}
+
+static void convert_float_to_int (const float* in, int32_t* out, int n_samples, float scale, float max_value, unsigned int* dither_state)
+{
+    static constexpr int v_size = 4;
+    auto rng_state = dither_state != nullptr ? load_unaligned<uint32x4> (dither_state) : uint32x4 {};
+
+    const auto convert = [&] (const float* x, int32_t* y)
+    {
+        auto v = load_unaligned<float32x4> (x) * broadcast (scale);
+        if (dither_state != nullptr)
+            v += get_dither (rng_state);
+
+        // round to nearest (like the SSE and NEON conversions), rather than truncating like __builtin_convertvector()
+        int32x4 v_int;
+        for (int i = 0; i < v_size; ++i)
+            v_int[i] = (int32_t) std::nearbyint (std::min (std::max (v[i], -scale), max_value));
+        store_unaligned (y, v_int);
+    };
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        convert (in + n, out + n);
+
+    if (n < n_samples)
+    {
+        float in_tail[v_size] {};
+        int32_t out_tail[v_size];
+        std::memcpy (in_tail, in + n, (size_t) (n_samples - n) * sizeof (float));
+        convert (in_tail, out_tail);
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (int32_t));
+    }
+
+    if (dither_state != nullptr)
+        store_unaligned (dither_state, rng_state);
+}
+
+/**
+ * Accumulates one complex output from a filter with complex samples (see `FIR_Flag_Complex_Samples`).
+ * Each vector holds two interleaved (I, Q) samples, and the matching taps duplicated across the I and Q lanes.
+ * Complex coefficients have a second table of (-imag, imag) pairs, which multiplies the (Q, I) swapped samples.
+ */
+template <bool complex_coeffs>
+static float32x4 accumulate_complex (float32x4 accum, const float* x_data, const float32x4* coeffs_re, const float32x4* coeffs_im, int n_taps_v)
+{
+    static constexpr int v_size = 4;
+    for (int k = 0; k < n_taps_v; ++k)
+    {
+        const auto z = load_unaligned<float32x4> (x_data + k * v_size);
+        accum += z * coeffs_re[k];
+        if constexpr (complex_coeffs)
+            accum += float32x4 { z[1], z[0], z[3], z[2] } * coeffs_im[k];
+    }
+    return accum;
+}
+
+/** Adds the two complex values in a vector, and stores the (I, Q) result. */
+static void store_complex (float* y, float32x4 accum)
+{
+    y[0] = accum[0] + accum[2];
+    y[1] = accum[1] + accum[3];
+}
+
+template <bool complex_coeffs>
+static void process_fir_interp_complex (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
+
+    for (int n = 0; n < n_samples_in; ++n)
+    {
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto accum = accumulate_complex<complex_coeffs> (float32x4 {},
+                                                                   ch_state + 2 * n,
+                                                                   coeffs_v + filter_idx * n_taps_v,
+                                                                   coeffs_im_v + filter_idx * n_taps_v,
+                                                                   n_taps_v);
+            store_complex (y_data + 2 * (n * state->factor + filter_idx), accum);
+        }
+    }
+}
+
+template <bool complex_coeffs>
+static void process_fir_decim_complex (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4 accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            accum = accumulate_complex<complex_coeffs> (accum,
+                                                        ch_state + filter_idx * state->state_per_filter_padded + 2 * n,
+                                                        coeffs_v + filter_idx * n_taps_v,
+                                                        coeffs_im_v + filter_idx * n_taps_v,
+                                                        n_taps_v);
+        }
+        store_complex (y_data + 2 * n, accum);
+    }
+}
+} // namespace chowdsp::polyphase_fir::generic
@@ -2,11 +2,33 @@
 
 namespace chowdsp::polyphase_fir::neon
 {
+/** Stores one output sample, scaled by the channel's gain, and optionally added into the existing output. */
+template <bool accumulate>
+static void store_output (float* y, float x, float gain)
+{
+    if constexpr (accumulate)
+        *y += gain * x;
+    else
+        *y = gain * x;
+}
+
+/** Same as above, for 4 consecutive output samples. */
+template <bool accumulate>
+static void store_output (float* y, float32x4_t x, float gain)
+{
+    x = vmulq_n_f32 (x, gain);
+    if constexpr (accumulate)
+        x = vaddq_f32 (vld1q_f32 (y), x);
+    vst1q_f32 (y, x);
+}
+
+template <bool accumulate>
 static void process_fir_interp (const Polyphase_FIR_State* state,
                                 const float* ch_state,
                                 float* y_data,
                                 int n_samples_in,
-                                float* scratch)
+                                float* scratch,
+                                float gain)
 {
     static constexpr int v_size = 4;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
@@ -39,75 +61,654 @@ static void process_fir_interp (const Polyphase_FIR_State* state,
         }
 
         for (int n = 0; n < n_samples_in; ++n)
-            y_data[n * state->factor + filter_idx] = scratch[n];
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
     }
 }
 
+template <bool accumulate>
 static void process_fir_decim (const Polyphase_FIR_State* state,
                                const float* channel_state,
                                float* y_data,
                                int n_samples_out,
-                               float* scratch)
+                               float*,
+                               float gain)
 {
     static constexpr int v_size = 4;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
     const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
-    auto* scratch_v = reinterpret_cast<float32x4_t*> (scratch);
 
-    int filter_idx = 0;
-    const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-    const auto* filter_state = channel_state + filter_idx * state->state_per_filter_padded;
+    // every polyphase filter accumulates into the same registers, which are reduced once per output
     for (int n = 0; n < n_samples_out; ++n)
     {
+        float32x4_t accum_0 {};
+        float32x4_t accum_1 {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = channel_state + filter_idx * state->state_per_filter_padded + n;
+            int k = 0;
+            for (; k + 1 < n_taps_v; k += 2)
+            {
+                const auto z0 = vld1q_f32 (filter_state + k * v_size);
+                accum_0 = vfmaq_f32 (accum_0, z0, filter_coeffs[k]);
+                const auto z1 = vld1q_f32 (filter_state + (k + 1) * v_size);
+                accum_1 = vfmaq_f32 (accum_1, z1, filter_coeffs[k + 1]);
+            }
+            for (; k < n_taps_v; ++k)
+            {
+                const auto z = vld1q_f32 (filter_state + k * v_size);
+                accum_0 = vfmaq_f32 (accum_0, z, filter_coeffs[k]);
+            }
+        }
+
+        const auto accum = vaddq_f32 (accum_0, accum_1);
+        auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+        store_output<accumulate> (y_data + n, vget_lane_f32 (vpadd_f32 (rr, rr), 0), gain);
+    }
+}
+
+static float32x4_t horizontal_add_4 (float32x4_t accum_0, float32x4_t accum_1, float32x4_t accum_2, float32x4_t accum_3)
+{
+    const auto rr_01 = vpadd_f32 (vadd_f32 (vget_low_f32 (accum_0), vget_high_f32 (accum_0)),
+                                  vadd_f32 (vget_low_f32 (accum_1), vget_high_f32 (accum_1)));
+    const auto rr_23 = vpadd_f32 (vadd_f32 (vget_low_f32 (accum_2), vget_high_f32 (accum_2)),
+                                  vadd_f32 (vget_low_f32 (accum_3), vget_high_f32 (accum_3)));
+    return vcombine_f32 (rr_01, rr_23);
+}
+
+template <bool accumulate>
+static void process_fir_interp_blocked (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in,
+                                        float* scratch,
+                                        float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        int n = 0;
+        for (; n + block_size <= n_samples_in; n += block_size)
+        {
+            float32x4_t accum_0 {};
+            float32x4_t accum_1 {};
+            float32x4_t accum_2 {};
+            float32x4_t accum_3 {};
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = ch_state + n + k * v_size;
+                accum_0 = vfmaq_f32 (accum_0, vld1q_f32 (x_data), coeffs);
+                accum_1 = vfmaq_f32 (accum_1, vld1q_f32 (x_data + 1), coeffs);
+                accum_2 = vfmaq_f32 (accum_2, vld1q_f32 (x_data + 2), coeffs);
+                accum_3 = vfmaq_f32 (accum_3, vld1q_f32 (x_data + 3), coeffs);
+            }
+            vst1q_f32 (scratch + n, horizontal_add_4 (accum_0, accum_1, accum_2, accum_3));
+        }
+
+        for (; n < n_samples_in; ++n)
+        {
+            float32x4_t accum {};
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = vld1q_f32 (ch_state + n + k * v_size);
+                accum = vfmaq_f32 (accum, z, filter_coeffs[k]);
+            }
+            auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+            scratch[n] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
+        }
+
+        for (n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_blocked (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out,
+                                       float* scratch,
+                                       float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
+
+    int n = 0;
+    for (; n + block_size <= n_samples_out; n += block_size)
+    {
+        float32x4_t accum_0 {};
+        float32x4_t accum_1 {};
+        float32x4_t accum_2 {};
+        float32x4_t accum_3 {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = filter_state + k * v_size;
+                accum_0 = vfmaq_f32 (accum_0, vld1q_f32 (x_data), coeffs);
+                accum_1 = vfmaq_f32 (accum_1, vld1q_f32 (x_data + 1), coeffs);
+                accum_2 = vfmaq_f32 (accum_2, vld1q_f32 (x_data + 2), coeffs);
+                accum_3 = vfmaq_f32 (accum_3, vld1q_f32 (x_data + 3), coeffs);
+            }
+        }
+
+        store_output<accumulate> (y_data + n, horizontal_add_4 (accum_0, accum_1, accum_2, accum_3), gain);
+    }
+
+    if (n < n_samples_out)
+        process_fir_decim<accumulate> (state, ch_state + n, y_data + n, n_samples_out - n, scratch, gain);
+}
+
+template <bool accumulate>
+static void process_fir_interp_channels (const Polyphase_FIR_State* state,
+                                         const float* group_coeffs,
+                                         const float* group_state,
+                                         float* const* y_data,
+                                         int n_lanes,
+                                         int n_samples_in,
+                                         const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (group_coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            float32x4_t accum {};
+            for (int k = 0; k < n_taps; ++k)
+            {
+                const auto z = vld1q_f32 (group_state + (n + k) * v_size);
+                accum = vfmaq_f32 (accum, z, filter_coeffs[k]);
+            }
+
+            float lanes[v_size];
+            vst1q_f32 (lanes, accum);
+            for (int lane = 0; lane < n_lanes; ++lane)
+                store_output<accumulate> (y_data[lane] + n * state->factor + filter_idx, lanes[lane], gains[lane]);
+        }
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_channels (const Polyphase_FIR_State* state,
+                                        const float* group_coeffs,
+                                        const float* group_state,
+                                        float* const* y_data,
+                                        int n_lanes,
+                                        int n_samples_out,
+                                        const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (group_coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4_t accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+            const auto* filter_state = group_state + (filter_idx * state->state_per_filter_padded + n) * v_size;
+            for (int k = 0; k < n_taps; ++k)
+            {
+                const auto z = vld1q_f32 (filter_state + k * v_size);
+                accum = vfmaq_f32 (accum, z, filter_coeffs[k]);
+            }
+        }
+
+        float lanes[v_size];
+        vst1q_f32 (lanes, accum);
+        for (int lane = 0; lane < n_lanes; ++lane)
+            store_output<accumulate> (y_data[lane] + n, lanes[lane], gains[lane]);
+    }
+}
+
+static void process_fir_asrc (const Polyphase_ASRC_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              const int* window_idx,
+                              const int* phase_row,
+                              const float* weights,
+                              int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
+
+    if (state->interpolation == ASRC_Interpolation_Cubic)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto* x_data = ch_state + window_idx[n];
+            const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+            const auto* coeffs_1 = coeffs_0 + n_taps_v;
+            const auto* coeffs_2 = coeffs_1 + n_taps_v;
+            const auto* coeffs_3 = coeffs_2 + n_taps_v;
+
+            float32x4_t accum_0 {};
+            float32x4_t accum_1 {};
+            float32x4_t accum_2 {};
+            float32x4_t accum_3 {};
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = vld1q_f32 (x_data + k * v_size);
+                accum_0 = vfmaq_f32 (accum_0, z, coeffs_0[k]);
+                accum_1 = vfmaq_f32 (accum_1, z, coeffs_1[k]);
+                accum_2 = vfmaq_f32 (accum_2, z, coeffs_2[k]);
+                accum_3 = vfmaq_f32 (accum_3, z, coeffs_3[k]);
+            }
+
+            const auto* w = weights + 4 * n;
+            auto accum = vmulq_n_f32 (accum_0, w[0]);
+            accum = vfmaq_n_f32 (accum, accum_1, w[1]);
+            accum = vfmaq_n_f32 (accum, accum_2, w[2]);
+            accum = vfmaq_n_f32 (accum, accum_3, w[3]);
+
+            auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+            y_data[n] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
+        }
+        return;
+    }
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        const auto* x_data = ch_state + window_idx[n];
+        const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+        const auto* coeffs_1 = coeffs_0 + n_taps_v;
+
+        float32x4_t accum_0 {};
+        float32x4_t accum_1 {};
+        for (int k = 0; k < n_taps_v; ++k)
+        {
+            const auto z = vld1q_f32 (x_data + k * v_size);
+            accum_0 = vfmaq_f32 (accum_0, z, coeffs_0[k]);
+            accum_1 = vfmaq_f32 (accum_1, z, coeffs_1[k]);
+        }
+
+        const auto* w = weights + 2 * n;
+        auto accum = vmulq_n_f32 (accum_0, w[0]);
+        accum = vfmaq_n_f32 (accum, accum_1, w[1]);
+
+        auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+        y_data[n] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
+    }
+}
+
+static void process_fir_branches (const float* coeffs,
+                                  int taps_per_filter_padded,
+                                  const float* ch_state,
+                                  const int* window_idx,
+                                  float* y_data,
+                                  int n_branches)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (coeffs);
+
+    for (int branch_idx = 0; branch_idx < n_branches; ++branch_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + branch_idx * n_taps_v;
+        const auto* x_data = ch_state + window_idx[branch_idx];
         float32x4_t accum_0 {};
         float32x4_t accum_1 {};
         int k = 0;
         for (; k + 1 < n_taps_v; k += 2)
         {
-            const auto z0 = vld1q_f32 (filter_state + n + k * v_size);
+            const auto z0 = vld1q_f32 (x_data + k * v_size);
             accum_0 = vfmaq_f32 (accum_0, z0, filter_coeffs[k]);
-            const auto z1 = vld1q_f32 (filter_state + n + (k + 1) * v_size);
+            const auto z1 = vld1q_f32 (x_data + (k + 1) * v_size);
             accum_1 = vfmaq_f32 (accum_1, z1, filter_coeffs[k + 1]);
         }
         for (; k < n_taps_v; ++k)
         {
-            const auto z = vld1q_f32 (filter_state + n + k * v_size);
+            const auto z = vld1q_f32 (x_data + k * v_size);
             accum_0 = vfmaq_f32 (accum_0, z, filter_coeffs[k]);
         }
 
-        scratch_v[n] = vaddq_f32 (accum_0, accum_1);
+        const auto accum = vaddq_f32 (accum_0, accum_1);
+        auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+        y_data[branch_idx] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
     }
+}
+
+/** Widens 4 fp16 or bf16 coefficients to float. */
+template <bool is_bf16>
+static float32x4_t load_half_coeffs (const uint16_t* coeffs)
+{
+    const auto h = vld1_u16 (coeffs);
+    if constexpr (is_bf16)
+        return vreinterpretq_f32_u32 (vshll_n_u16 (h, 16));
+    else
+        return vcvt_f32_f16 (vreinterpret_f16_u16 (h));
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
 
-    for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
     {
-        filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-        filter_state = channel_state + filter_idx * state->state_per_filter_padded;
-        for (int n = 0; n < n_samples_out; ++n)
+        const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+        for (int n = 0; n < n_samples_in; ++n)
         {
-            float32x4_t accum_0 {};
-            float32x4_t accum_1 {};
-            int k = 0;
-            for (; k + 1 < n_taps_v; k += 2)
+            float32x4_t accum {};
+            for (int k = 0; k < n_taps_v; ++k)
             {
-                const auto z0 = vld1q_f32 (filter_state + n + k * v_size);
-                accum_0 = vfmaq_f32 (accum_0, z0, filter_coeffs[k]);
-                const auto z1 = vld1q_f32 (filter_state + n + (k + 1) * v_size);
-                accum_1 = vfmaq_f32 (accum_1, z1, filter_coeffs[k + 1]);
+                const auto z = vld1q_f32 (ch_state + n + k * v_size);
+                accum = vfmaq_f32 (accum, z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size));
             }
-            for (; k < n_taps_v; ++k)
+
+            auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+            scratch[n] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
+        }
+
+        for (int n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* channel_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        float32x4_t accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = channel_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
             {
-                const auto z = vld1q_f32 (filter_state + n + k * v_size);
-                accum_0 = vfmaq_f32 (accum_0, z, filter_coeffs[k]);
+                const auto z = vld1q_f32 (filter_state + k * v_size);
+                accum = vfmaq_f32 (accum, z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size));
             }
+        }
+
+        auto rr = vadd_f32 (vget_high_f32 (accum), vget_low_f32 (accum));
+        store_output<accumulate> (y_data + n, vget_lane_f32 (vpadd_f32 (rr, rr), 0), gain);
+    }
+}
+
+/** Same as `process_fir_interp()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_interp_half<true, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else
+        process_fir_interp_half<false, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+}
+
+/** Same as `process_fir_decim()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* channel_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float*,
+                                    float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_decim_half<true, accumulate> (state, channel_state, y_data, n_samples_out, gain);
+    else
+        process_fir_decim_half<false, accumulate> (state, channel_state, y_data, n_samples_out, gain);
+}
+
+/**
+ * Runs a chain of first-order allpass sections, (a + z^-1) / (1 + a z^-1), over one sample of 4 channels.
+ * `mem[k]` holds the previous input of section `k` (which is also the previous output of section `k - 1`).
+ */
+static float32x4_t process_allpass_chain (float32x4_t x, float* mem, const float* coeffs, int n_stages)
+{
+    static constexpr int group_size = 8; // same as `iir_channel_group_size`
+    for (int k = 0; k < n_stages; ++k)
+    {
+        const auto y = vfmaq_f32 (vld1q_f32 (mem + k * group_size),
+                                  vsubq_f32 (x, vld1q_f32 (mem + (k + 1) * group_size)),
+                                  vld1q_f32 (coeffs + k * group_size));
+        vst1q_f32 (mem + k * group_size, x);
+        x = y;
+    }
+    vst1q_f32 (mem + n_stages * group_size, x);
+    return x;
+}
+
+static void process_iir_interp_channels (const Polyphase_IIR_State* state,
+                                         float* group_state,
+                                         const float* x_data,
+                                         float* y_data,
+                                         int n_lanes,
+                                         int n_samples_in)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
 
-            scratch_v[n] = vaddq_f32 (scratch_v[n], vaddq_f32 (accum_0, accum_1));
+    // each half of the group is a separate vector
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            const auto x = vld1q_f32 (x_data + n * group_size + half);
+            vst1q_f32 (y_data + (2 * n) * group_size + half, process_allpass_chain (x, group_state + half, state->coeffs + half, n_stages_0));
+            vst1q_f32 (y_data + (2 * n + 1) * group_size + half, process_allpass_chain (x, mem_1 + half, coeffs_1 + half, n_stages_1));
         }
     }
+}
+
+static void process_iir_decim_channels (const Polyphase_IIR_State* state,
+                                        float* group_state,
+                                        const float* x_data,
+                                        float* y_data,
+                                        int n_lanes,
+                                        int n_samples_out)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+    const auto half_gain = vdupq_n_f32 (0.5f);
+
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto y_0 = process_allpass_chain (vld1q_f32 (x_data + (2 * n + 1) * group_size + half), group_state + half, state->coeffs + half, n_stages_0);
+            const auto y_1 = process_allpass_chain (vld1q_f32 (x_data + (2 * n) * group_size + half), mem_1 + half, coeffs_1 + half, n_stages_1);
+            vst1q_f32 (y_data + n * group_size + half, vmulq_f32 (vaddq_f32 (y_0, y_1), half_gain));
+        }
+    }
+}
+
+/** Loads 4 PCM samples, as integers scaled to the full 32-bit range */
+static int32x4_t load_pcm_samples (const std::byte* in, int format)
+{
+    if (format == FIR_PCM_Int16)
+        return vshll_n_s16 (vld1_s16 (reinterpret_cast<const int16_t*> (in)), 16);
+    if (format == FIR_PCM_Int32)
+        return vld1q_s32 (reinterpret_cast<const int32_t*> (in));
+
+    const auto* bytes = reinterpret_cast<const uint8_t*> (in);
+    int32_t samples[4];
+    for (int i = 0; i < 4; ++i)
+        samples[i] = (int32_t) (((uint32_t) bytes[3 * i] << 8) | ((uint32_t) bytes[3 * i + 1] << 16) | ((uint32_t) bytes[3 * i + 2] << 24));
+    return vld1q_s32 (samples);
+}
+
+static void convert_pcm_to_float (const std::byte* in, int format, float* out, int n_samples)
+{
+    static constexpr int v_size = 4;
+    const auto bytes_per_sample = format == FIR_PCM_Int16 ? 2 : (format == FIR_PCM_Int24 ? 3 : 4);
+    static constexpr float scale = 1.0f / 2147483648.0f;
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        vst1q_f32 (out + n, vmulq_n_f32 (vcvtq_f32_s32 (load_pcm_samples (in + n * bytes_per_sample, format)), scale));
+
+    if (n < n_samples)
+    {
+        std::byte in_tail[v_size * 4] {};
+        float out_tail[v_size];
+        std::memcpy (in_tail, in + n * bytes_per_sample, (size_t) ((n_samples - n) * bytes_per_sample));
+        vst1q_f32 (out_tail, vmulq_n_f32 (vcvtq_f32_s32 (load_pcm_samples (in_tail, format)), scale));
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (float));
+    }
+}
+
+static float32x4_t get_dither (uint32x4_t& rng_state)
+{
+    rng_state = veorq_u32 (rng_state, vshlq_n_u32 (rng_state, 13));
+    rng_state = veorq_u32 (rng_state, vshrq_n_u32 (rng_state, 17));
+    rng_state = veorq_u32 (rng_state, vshlq_n_u32 (rng_state, 5));
+
+    const auto sum = vaddq_u32 (vshrq_n_u32 (rng_state, 16), vandq_u32 (rng_state, vdupq_n_u32 (0xffff)));
+    return vsubq_f32 (vmulq_n_f32 (vcvtq_f32_u32 (sum), 1.0f / 65536.0f), vdupq_n_f32 (1.0f));
+}
+
+static void convert_float_to_int (const float* in, int32_t* out, int n_samples, float scale, float max_value, unsigned int* dither_state)
+{
+    static constexpr int v_size = 4;
+    const auto min_v = vdupq_n_f32 (-scale);
+    const auto max_v = vdupq_n_f32 (max_value);
+    auto rng_state = dither_state != nullptr ? vld1q_u32 (dither_state) : vdupq_n_u32 (0);
+
+    const auto convert = [&] (const float* x, int32_t* y)
+    {
+        auto v = vmulq_n_f32 (vld1q_f32 (x), scale);
+        if (dither_state != nullptr)
+            v = vaddq_f32 (v, get_dither (rng_state));
+        v = vminq_f32 (vmaxq_f32 (v, min_v), max_v);
+        vst1q_s32 (y, vcvtnq_s32_f32 (v));
+    };
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        convert (in + n, out + n);
+
+    if (n < n_samples)
+    {
+        float in_tail[v_size] {};
+        int32_t out_tail[v_size];
+        std::memcpy (in_tail, in + n, (size_t) (n_samples - n) * sizeof (float));
+        convert (in_tail, out_tail);
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (int32_t));
+    }
+
+    if (dither_state != nullptr)
+        vst1q_u32 (dither_state, rng_state);
+}
+
+/**
+ * Accumulates one complex output from a filter with complex samples (see `FIR_Flag_Complex_Samples`).
+ * Each vector holds two interleaved (I, Q) samples, and the matching taps duplicated across the I and Q lanes.
+ * Complex coefficients have a second table of (-imag, imag) pairs, which multiplies the (Q, I) swapped samples.
+ */
+template <bool complex_coeffs>
+static float32x4_t accumulate_complex (float32x4_t accum, const float* x_data, const float32x4_t* coeffs_re, const float32x4_t* coeffs_im, int n_taps_v)
+{
+    static constexpr int v_size = 4;
+    for (int k = 0; k < n_taps_v; ++k)
+    {
+        const auto z = vld1q_f32 (x_data + k * v_size);
+        accum = vfmaq_f32 (accum, z, coeffs_re[k]);
+        if constexpr (complex_coeffs)
+            accum = vfmaq_f32 (accum, vrev64q_f32 (z), coeffs_im[k]);
+    }
+    return accum;
+}
+
+/** Adds the two complex values in a vector, and stores the (I, Q) result. */
+static void store_complex (float* y, float32x4_t accum)
+{
+    vst1_f32 (y, vadd_f32 (vget_low_f32 (accum), vget_high_f32 (accum)));
+}
+
+template <bool complex_coeffs>
+static void process_fir_interp_complex (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
+
+    for (int n = 0; n < n_samples_in; ++n)
+    {
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto accum = accumulate_complex<complex_coeffs> (float32x4_t {},
+                                                                   ch_state + 2 * n,
+                                                                   coeffs_v + filter_idx * n_taps_v,
+                                                                   coeffs_im_v + filter_idx * n_taps_v,
+                                                                   n_taps_v);
+            store_complex (y_data + 2 * (n * state->factor + filter_idx), accum);
+        }
+    }
+}
+
+template <bool complex_coeffs>
+static void process_fir_decim_complex (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const float32x4_t*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
 
     for (int n = 0; n < n_samples_out; ++n)
     {
-        auto rr = vadd_f32 (vget_high_f32 (scratch_v[n]), vget_low_f32 (scratch_v[n]));
-        y_data[n] = vget_lane_f32 (vpadd_f32 (rr, rr), 0);
+        float32x4_t accum {};
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            accum = accumulate_complex<complex_coeffs> (accum,
+                                                        ch_state + filter_idx * state->state_per_filter_padded + 2 * n,
+                                                        coeffs_v + filter_idx * n_taps_v,
+                                                        coeffs_im_v + filter_idx * n_taps_v,
+                                                        n_taps_v);
+        }
+        store_complex (y_data + 2 * n, accum);
     }
 }
 } // namespace chowdsp::polyphase_fir::neon
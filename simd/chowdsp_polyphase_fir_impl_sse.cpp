@@ -2,11 +2,33 @@
 
 namespace chowdsp::polyphase_fir::sse
 {
+/** Stores one output sample, scaled by the channel's gain, and optionally added into the existing output. */
+template <bool accumulate>
+static void store_output (float* y, float x, float gain)
+{
+    if constexpr (accumulate)
+        *y += gain * x;
+    else
+        *y = gain * x;
+}
+
+/** Same as above, for 4 consecutive output samples. */
+template <bool accumulate>
+static void store_output (float* y, __m128 x, float gain)
+{
+    x = _mm_mul_ps (x, _mm_set1_ps (gain));
+    if constexpr (accumulate)
+        x = _mm_add_ps (_mm_loadu_ps (y), x);
+    _mm_storeu_ps (y, x);
+}
+
+template <bool accumulate>
 static void process_fir_interp (const Polyphase_FIR_State* state,
                                 const float* ch_state,
                                 float* y_data,
                                 int n_samples_in,
-                                float* scratch)
+                                float* scratch,
+                                float gain)
 {
     static constexpr int v_size = 4;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
@@ -30,57 +52,666 @@ static void process_fir_interp (const Polyphase_FIR_State* state,
         }
 
         for (int n = 0; n < n_samples_in; ++n)
-            y_data[n * state->factor + filter_idx] = scratch[n];
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
     }
 }
 
+template <bool accumulate>
 static void process_fir_decim (const Polyphase_FIR_State* state,
                                const float* ch_state,
                                float* y_data,
                                int n_samples_out,
-                               float* scratch)
+                               float*,
+                               float gain)
 {
     static constexpr int v_size = 4;
     const auto n_taps_v = state->taps_per_filter_padded / v_size;
     const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
-    auto* scratch_v = reinterpret_cast<__m128*> (scratch);
 
-    int filter_idx = 0;
-    const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-    const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded;
+    // every polyphase filter accumulates into the same register, which is reduced once per output
     for (int n = 0; n < n_samples_out; ++n)
     {
         auto accum = _mm_setzero_ps();
-        for (int k = 0; k < n_taps_v; ++k)
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
         {
-            const auto z = _mm_loadu_ps (filter_state + n + k * v_size);
-            accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm_loadu_ps (filter_state + k * v_size);
+                accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
+            }
         }
-        scratch_v[n] = accum;
+
+        auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+        rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+        store_output<accumulate> (y_data + n, _mm_cvtss_f32 (rr), gain);
     }
+}
 
-    for (filter_idx = 1; filter_idx < state->factor; ++filter_idx)
+template <bool accumulate>
+static void process_fir_interp_blocked (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in,
+                                        float* scratch,
+                                        float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
     {
-        filter_coeffs = coeffs_v + filter_idx * n_taps_v;
-        filter_state = ch_state + filter_idx * state->state_per_filter_padded;
-        for (int n = 0; n < n_samples_out; ++n)
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+        int n = 0;
+        for (; n + block_size <= n_samples_in; n += block_size)
+        {
+            auto accum_0 = _mm_setzero_ps();
+            auto accum_1 = _mm_setzero_ps();
+            auto accum_2 = _mm_setzero_ps();
+            auto accum_3 = _mm_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = ch_state + n + k * v_size;
+                accum_0 = _mm_add_ps (accum_0, _mm_mul_ps (_mm_loadu_ps (x_data), coeffs));
+                accum_1 = _mm_add_ps (accum_1, _mm_mul_ps (_mm_loadu_ps (x_data + 1), coeffs));
+                accum_2 = _mm_add_ps (accum_2, _mm_mul_ps (_mm_loadu_ps (x_data + 2), coeffs));
+                accum_3 = _mm_add_ps (accum_3, _mm_mul_ps (_mm_loadu_ps (x_data + 3), coeffs));
+            }
+
+            _MM_TRANSPOSE4_PS (accum_0, accum_1, accum_2, accum_3);
+            _mm_storeu_ps (scratch + n, _mm_add_ps (_mm_add_ps (accum_0, accum_1), _mm_add_ps (accum_2, accum_3)));
+        }
+
+        for (; n < n_samples_in; ++n)
         {
             auto accum = _mm_setzero_ps();
             for (int k = 0; k < n_taps_v; ++k)
             {
-                const auto z = _mm_loadu_ps (filter_state + n + k * v_size);
+                const auto z = _mm_loadu_ps (ch_state + n + k * v_size);
+                accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
+            }
+
+            auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+            rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+            scratch[n] = _mm_cvtss_f32 (rr);
+        }
+
+        for (n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_blocked (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out,
+                                       float* scratch,
+                                       float gain)
+{
+    static constexpr int v_size = 4;
+    static constexpr int block_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
+
+    int n = 0;
+    for (; n + block_size <= n_samples_out; n += block_size)
+    {
+        auto accum_0 = _mm_setzero_ps();
+        auto accum_1 = _mm_setzero_ps();
+        auto accum_2 = _mm_setzero_ps();
+        auto accum_3 = _mm_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps_v;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto coeffs = filter_coeffs[k];
+                const auto* x_data = filter_state + k * v_size;
+                accum_0 = _mm_add_ps (accum_0, _mm_mul_ps (_mm_loadu_ps (x_data), coeffs));
+                accum_1 = _mm_add_ps (accum_1, _mm_mul_ps (_mm_loadu_ps (x_data + 1), coeffs));
+                accum_2 = _mm_add_ps (accum_2, _mm_mul_ps (_mm_loadu_ps (x_data + 2), coeffs));
+                accum_3 = _mm_add_ps (accum_3, _mm_mul_ps (_mm_loadu_ps (x_data + 3), coeffs));
+            }
+        }
+
+        _MM_TRANSPOSE4_PS (accum_0, accum_1, accum_2, accum_3);
+        store_output<accumulate> (y_data + n, _mm_add_ps (_mm_add_ps (accum_0, accum_1), _mm_add_ps (accum_2, accum_3)), gain);
+    }
+
+    if (n < n_samples_out)
+        process_fir_decim<accumulate> (state, ch_state + n, y_data + n, n_samples_out - n, scratch, gain);
+}
+
+template <bool accumulate>
+static void process_fir_interp_channels (const Polyphase_FIR_State* state,
+                                         const float* group_coeffs,
+                                         const float* group_state,
+                                         float* const* y_data,
+                                         int n_lanes,
+                                         int n_samples_in,
+                                         const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (group_coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            auto accum = _mm_setzero_ps();
+            for (int k = 0; k < n_taps; ++k)
+            {
+                const auto z = _mm_loadu_ps (group_state + (n + k) * v_size);
+                accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
+            }
+
+            alignas (16) float lanes[v_size];
+            _mm_store_ps (lanes, accum);
+            for (int lane = 0; lane < n_lanes; ++lane)
+                store_output<accumulate> (y_data[lane] + n * state->factor + filter_idx, lanes[lane], gains[lane]);
+        }
+    }
+}
+
+template <bool accumulate>
+static void process_fir_decim_channels (const Polyphase_FIR_State* state,
+                                        const float* group_coeffs,
+                                        const float* group_state,
+                                        float* const* y_data,
+                                        int n_lanes,
+                                        int n_samples_out,
+                                        const float* gains)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps = state->taps_per_filter_padded;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (group_coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        auto accum = _mm_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs_v + filter_idx * n_taps;
+            const auto* filter_state = group_state + (filter_idx * state->state_per_filter_padded + n) * v_size;
+            for (int k = 0; k < n_taps; ++k)
+            {
+                const auto z = _mm_loadu_ps (filter_state + k * v_size);
                 accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
             }
-            scratch_v[n] = _mm_add_ps (scratch_v[n], accum);
         }
+
+        alignas (16) float lanes[v_size];
+        _mm_store_ps (lanes, accum);
+        for (int lane = 0; lane < n_lanes; ++lane)
+            store_output<accumulate> (y_data[lane] + n, lanes[lane], gains[lane]);
+    }
+}
+
+static void process_fir_asrc (const Polyphase_ASRC_State* state,
+                              const float* ch_state,
+                              float* y_data,
+                              const int* window_idx,
+                              const int* phase_row,
+                              const float* weights,
+                              int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
+
+    if (state->interpolation == ASRC_Interpolation_Cubic)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto* x_data = ch_state + window_idx[n];
+            const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+            const auto* coeffs_1 = coeffs_0 + n_taps_v;
+            const auto* coeffs_2 = coeffs_1 + n_taps_v;
+            const auto* coeffs_3 = coeffs_2 + n_taps_v;
+
+            auto accum_0 = _mm_setzero_ps();
+            auto accum_1 = _mm_setzero_ps();
+            auto accum_2 = _mm_setzero_ps();
+            auto accum_3 = _mm_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm_loadu_ps (x_data + k * v_size);
+                accum_0 = _mm_add_ps (accum_0, _mm_mul_ps (z, coeffs_0[k]));
+                accum_1 = _mm_add_ps (accum_1, _mm_mul_ps (z, coeffs_1[k]));
+                accum_2 = _mm_add_ps (accum_2, _mm_mul_ps (z, coeffs_2[k]));
+                accum_3 = _mm_add_ps (accum_3, _mm_mul_ps (z, coeffs_3[k]));
+            }
+
+            const auto* w = weights + 4 * n;
+            auto accum = _mm_mul_ps (accum_0, _mm_set1_ps (w[0]));
+            accum = _mm_add_ps (accum, _mm_mul_ps (accum_1, _mm_set1_ps (w[1])));
+            accum = _mm_add_ps (accum, _mm_mul_ps (accum_2, _mm_set1_ps (w[2])));
+            accum = _mm_add_ps (accum, _mm_mul_ps (accum_3, _mm_set1_ps (w[3])));
+
+            auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+            rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+            y_data[n] = _mm_cvtss_f32 (rr);
+        }
+        return;
     }
 
     for (int n = 0; n < n_samples_out; ++n)
     {
-        const auto accum = scratch_v[n];
+        const auto* x_data = ch_state + window_idx[n];
+        const auto* coeffs_0 = coeffs_v + phase_row[n] * n_taps_v;
+        const auto* coeffs_1 = coeffs_0 + n_taps_v;
+
+        auto accum_0 = _mm_setzero_ps();
+        auto accum_1 = _mm_setzero_ps();
+        for (int k = 0; k < n_taps_v; ++k)
+        {
+            const auto z = _mm_loadu_ps (x_data + k * v_size);
+            accum_0 = _mm_add_ps (accum_0, _mm_mul_ps (z, coeffs_0[k]));
+            accum_1 = _mm_add_ps (accum_1, _mm_mul_ps (z, coeffs_1[k]));
+        }
+
+        const auto* w = weights + 2 * n;
+        auto accum = _mm_mul_ps (accum_0, _mm_set1_ps (w[0]));
+        accum = _mm_add_ps (accum, _mm_mul_ps (accum_1, _mm_set1_ps (w[1])));
+
         auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
         rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
         y_data[n] = _mm_cvtss_f32 (rr);
     }
 }
+
+static void process_fir_branches (const float* coeffs,
+                                  int taps_per_filter_padded,
+                                  const float* ch_state,
+                                  const int* window_idx,
+                                  float* y_data,
+                                  int n_branches)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (coeffs);
+
+    for (int branch_idx = 0; branch_idx < n_branches; ++branch_idx)
+    {
+        const auto* filter_coeffs = coeffs_v + branch_idx * n_taps_v;
+        const auto* x_data = ch_state + window_idx[branch_idx];
+        auto accum = _mm_setzero_ps();
+        for (int k = 0; k < n_taps_v; ++k)
+        {
+            const auto z = _mm_loadu_ps (x_data + k * v_size);
+            accum = _mm_add_ps (accum, _mm_mul_ps (z, filter_coeffs[k]));
+        }
+
+        auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+        rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+        y_data[branch_idx] = _mm_cvtss_f32 (rr);
+    }
+}
+
+/**
+ * Widens 4 fp16 or bf16 coefficients to float. SSE2 doesn't have F16C, so fp16 is converted with
+ * integer ops: normal values just need their exponent re-biased (127 - 15), and subnormals are
+ * re-normalized with a float subtraction, which still works when denormals are flushed to zero.
+ */
+template <bool is_bf16>
+static __m128 load_half_coeffs (const uint16_t* coeffs)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto h = _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (coeffs));
+    if constexpr (is_bf16)
+    {
+        return _mm_castsi128_ps (_mm_unpacklo_epi16 (zero, h));
+    }
+    else
+    {
+        const auto h32 = _mm_unpacklo_epi16 (h, zero);
+        const auto sign = _mm_slli_epi32 (_mm_and_si128 (h32, _mm_set1_epi32 (0x8000)), 16);
+        const auto exp_mantissa = _mm_slli_epi32 (_mm_and_si128 (h32, _mm_set1_epi32 (0x7fff)), 13);
+
+        const auto normal = _mm_add_epi32 (exp_mantissa, _mm_set1_epi32 (112 << 23));
+        const auto magic = _mm_set1_epi32 (113 << 23);
+        const auto subnormal = _mm_castps_si128 (_mm_sub_ps (_mm_castsi128_ps (_mm_or_si128 (exp_mantissa, magic)), _mm_castsi128_ps (magic)));
+        const auto is_subnormal = _mm_cmpeq_epi32 (_mm_and_si128 (h32, _mm_set1_epi32 (0x7c00)), zero);
+        const auto value = _mm_or_si128 (_mm_and_si128 (is_subnormal, subnormal), _mm_andnot_si128 (is_subnormal, normal));
+        return _mm_castsi128_ps (_mm_or_si128 (value, sign));
+    }
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+
+    for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+    {
+        const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            auto accum = _mm_setzero_ps();
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm_loadu_ps (ch_state + n + k * v_size);
+                accum = _mm_add_ps (accum, _mm_mul_ps (z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size)));
+            }
+
+            auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+            rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+            scratch[n] = _mm_cvtss_f32 (rr);
+        }
+
+        for (int n = 0; n < n_samples_in; ++n)
+            store_output<accumulate> (y_data + n * state->factor + filter_idx, scratch[n], gain);
+    }
+}
+
+template <bool is_bf16, bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* ch_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float gain)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs = reinterpret_cast<const uint16_t*> (state->coeffs);
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        auto accum = _mm_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto* filter_coeffs = coeffs + filter_idx * state->taps_per_filter_padded;
+            const auto* filter_state = ch_state + filter_idx * state->state_per_filter_padded + n;
+            for (int k = 0; k < n_taps_v; ++k)
+            {
+                const auto z = _mm_loadu_ps (filter_state + k * v_size);
+                accum = _mm_add_ps (accum, _mm_mul_ps (z, load_half_coeffs<is_bf16> (filter_coeffs + k * v_size)));
+            }
+        }
+
+        auto rr = _mm_add_ps (_mm_shuffle_ps (accum, accum, 0x4e), accum);
+        rr = _mm_add_ps (rr, _mm_shuffle_ps (rr, rr, 0xb1));
+        store_output<accumulate> (y_data + n, _mm_cvtss_f32 (rr), gain);
+    }
+}
+
+/** Same as `process_fir_interp()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_interp_half (const Polyphase_FIR_State* state,
+                                     const float* ch_state,
+                                     float* y_data,
+                                     int n_samples_in,
+                                     float* scratch,
+                                     float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_interp_half<true, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+    else
+        process_fir_interp_half<false, accumulate> (state, ch_state, y_data, n_samples_in, scratch, gain);
+}
+
+/** Same as `process_fir_decim()`, but with fp16 or bf16 coefficients (see `FIR_Flag_Coeffs_F16`). */
+template <bool accumulate>
+static void process_fir_decim_half (const Polyphase_FIR_State* state,
+                                    const float* ch_state,
+                                    float* y_data,
+                                    int n_samples_out,
+                                    float*,
+                                    float gain)
+{
+    if ((state->flags & FIR_Flag_Coeffs_BF16) != 0)
+        process_fir_decim_half<true, accumulate> (state, ch_state, y_data, n_samples_out, gain);
+    else
+        process_fir_decim_half<false, accumulate> (state, ch_state, y_data, n_samples_out, gain);
+}
+
+/**
+ * Runs a chain of first-order allpass sections, (a + z^-1) / (1 + a z^-1), over one sample of 4 channels.
+ * `mem[k]` holds the previous input of section `k` (which is also the previous output of section `k - 1`).
+ */
+static __m128 process_allpass_chain (__m128 x, float* mem, const float* coeffs, int n_stages)
+{
+    static constexpr int group_size = 8; // same as `iir_channel_group_size`
+    for (int k = 0; k < n_stages; ++k)
+    {
+        const auto y = _mm_add_ps (_mm_mul_ps (_mm_sub_ps (x, _mm_loadu_ps (mem + (k + 1) * group_size)),
+                                               _mm_loadu_ps (coeffs + k * group_size)),
+                                   _mm_loadu_ps (mem + k * group_size));
+        _mm_storeu_ps (mem + k * group_size, x);
+        x = y;
+    }
+    _mm_storeu_ps (mem + n_stages * group_size, x);
+    return x;
+}
+
+static void process_iir_interp_channels (const Polyphase_IIR_State* state,
+                                         float* group_state,
+                                         const float* x_data,
+                                         float* y_data,
+                                         int n_lanes,
+                                         int n_samples_in)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+
+    // each half of the group is a separate vector
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            const auto x = _mm_loadu_ps (x_data + n * group_size + half);
+            _mm_storeu_ps (y_data + (2 * n) * group_size + half, process_allpass_chain (x, group_state + half, state->coeffs + half, n_stages_0));
+            _mm_storeu_ps (y_data + (2 * n + 1) * group_size + half, process_allpass_chain (x, mem_1 + half, coeffs_1 + half, n_stages_1));
+        }
+    }
+}
+
+static void process_iir_decim_channels (const Polyphase_IIR_State* state,
+                                        float* group_state,
+                                        const float* x_data,
+                                        float* y_data,
+                                        int n_lanes,
+                                        int n_samples_out)
+{
+    static constexpr int group_size = 8;
+    const auto n_stages_0 = (state->n_coeffs + 1) / 2;
+    const auto n_stages_1 = state->n_coeffs / 2;
+    const auto* coeffs_1 = state->coeffs + n_stages_0 * group_size;
+    auto* mem_1 = group_state + (n_stages_0 + 1) * group_size;
+    const auto half_gain = _mm_set1_ps (0.5f);
+
+    for (int half = 0; half < n_lanes; half += 4)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto y_0 = process_allpass_chain (_mm_loadu_ps (x_data + (2 * n + 1) * group_size + half), group_state + half, state->coeffs + half, n_stages_0);
+            const auto y_1 = process_allpass_chain (_mm_loadu_ps (x_data + (2 * n) * group_size + half), mem_1 + half, coeffs_1 + half, n_stages_1);
+            _mm_storeu_ps (y_data + n * group_size + half, _mm_mul_ps (_mm_add_ps (y_0, y_1), half_gain));
+        }
+    }
+}
+
+/**
+ * Loads 4 PCM samples, as integers scaled to the full 32-bit range
+ * (i.e. left-justified, so that every format has the same scale).
+ */
+static __m128i load_pcm_samples (const std::byte* in, int format)
+{
+    if (format == FIR_PCM_Int16)
+        return _mm_unpacklo_epi16 (_mm_setzero_si128(), _mm_loadl_epi64 (reinterpret_cast<const __m128i*> (in)));
+    if (format == FIR_PCM_Int32)
+        return _mm_loadu_si128 (reinterpret_cast<const __m128i*> (in));
+
+    // SSE2 has no byte shuffle, so the packed 24-bit samples are assembled one at a time
+    const auto* bytes = reinterpret_cast<const uint8_t*> (in);
+    const auto load_24 = [bytes] (int i)
+    { return (int) (((uint32_t) bytes[3 * i] << 8) | ((uint32_t) bytes[3 * i + 1] << 16) | ((uint32_t) bytes[3 * i + 2] << 24)); };
+    return _mm_setr_epi32 (load_24 (0), load_24 (1), load_24 (2), load_24 (3));
+}
+
+/** Converts `n_samples` PCM samples to float, in the range [-1, 1) */
+static void convert_pcm_to_float (const std::byte* in, int format, float* out, int n_samples)
+{
+    static constexpr int v_size = 4;
+    const auto bytes_per_sample = format == FIR_PCM_Int16 ? 2 : (format == FIR_PCM_Int24 ? 3 : 4);
+    const auto scale = _mm_set1_ps (1.0f / 2147483648.0f);
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        _mm_storeu_ps (out + n, _mm_mul_ps (_mm_cvtepi32_ps (load_pcm_samples (in + n * bytes_per_sample, format)), scale));
+
+    if (n < n_samples)
+    {
+        // the last few samples are copied out, so that the vector loads stay in bounds
+        std::byte in_tail[v_size * 4] {};
+        float out_tail[v_size];
+        std::memcpy (in_tail, in + n * bytes_per_sample, (size_t) ((n_samples - n) * bytes_per_sample));
+        _mm_storeu_ps (out_tail, _mm_mul_ps (_mm_cvtepi32_ps (load_pcm_samples (in_tail, format)), scale));
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (float));
+    }
+}
+
+/** Returns triangular dither in [-1, 1), from 4 xorshift generators */
+static __m128 get_dither (__m128i& rng_state)
+{
+    rng_state = _mm_xor_si128 (rng_state, _mm_slli_epi32 (rng_state, 13));
+    rng_state = _mm_xor_si128 (rng_state, _mm_srli_epi32 (rng_state, 17));
+    rng_state = _mm_xor_si128 (rng_state, _mm_slli_epi32 (rng_state, 5));
+
+    // the sum of two uniform 16-bit values
+    const auto sum = _mm_add_epi32 (_mm_srli_epi32 (rng_state, 16), _mm_and_si128 (rng_state, _mm_set1_epi32 (0xffff)));
+    return _mm_sub_ps (_mm_mul_ps (_mm_cvtepi32_ps (sum), _mm_set1_ps (1.0f / 65536.0f)), _mm_set1_ps (1.0f));
+}
+
+/**
+ * Converts `n_samples` float samples to integers, scaled by `scale`, and clipped to [-scale, max_value].
+ * If `dither_state` is not null, dither is added before rounding.
+ */
+static void convert_float_to_int (const float* in, int32_t* out, int n_samples, float scale, float max_value, unsigned int* dither_state)
+{
+    static constexpr int v_size = 4;
+    const auto scale_v = _mm_set1_ps (scale);
+    const auto min_v = _mm_set1_ps (-scale);
+    const auto max_v = _mm_set1_ps (max_value);
+    auto rng_state = dither_state != nullptr ? _mm_loadu_si128 (reinterpret_cast<const __m128i*> (dither_state)) : _mm_setzero_si128();
+
+    const auto convert = [&] (const float* x, int32_t* y)
+    {
+        auto v = _mm_mul_ps (_mm_loadu_ps (x), scale_v);
+        if (dither_state != nullptr)
+            v = _mm_add_ps (v, get_dither (rng_state));
+        v = _mm_min_ps (_mm_max_ps (v, min_v), max_v);
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (y), _mm_cvtps_epi32 (v));
+    };
+
+    int n = 0;
+    for (; n + v_size <= n_samples; n += v_size)
+        convert (in + n, out + n);
+
+    if (n < n_samples)
+    {
+        float in_tail[v_size] {};
+        int32_t out_tail[v_size];
+        std::memcpy (in_tail, in + n, (size_t) (n_samples - n) * sizeof (float));
+        convert (in_tail, out_tail);
+        std::memcpy (out + n, out_tail, (size_t) (n_samples - n) * sizeof (int32_t));
+    }
+
+    if (dither_state != nullptr)
+        _mm_storeu_si128 (reinterpret_cast<__m128i*> (dither_state), rng_state);
+}
+
+/**
+ * Accumulates one complex output from a filter with complex samples (see `FIR_Flag_Complex_Samples`).
+ * Each vector holds two interleaved (I, Q) samples, and the matching taps duplicated across the I and Q lanes.
+ * Complex coefficients have a second table of (-imag, imag) pairs, which multiplies the (Q, I) swapped samples.
+ */
+template <bool complex_coeffs>
+static __m128 accumulate_complex (__m128 accum, const float* x_data, const __m128* coeffs_re, const __m128* coeffs_im, int n_taps_v)
+{
+    static constexpr int v_size = 4;
+    for (int k = 0; k < n_taps_v; ++k)
+    {
+        const auto z = _mm_loadu_ps (x_data + k * v_size);
+        accum = _mm_add_ps (accum, _mm_mul_ps (z, coeffs_re[k]));
+        if constexpr (complex_coeffs)
+            accum = _mm_add_ps (accum, _mm_mul_ps (_mm_shuffle_ps (z, z, 0xb1), coeffs_im[k]));
+    }
+    return accum;
+}
+
+/** Adds the two complex values in a vector, and stores the (I, Q) result. */
+static void store_complex (float* y, __m128 accum)
+{
+    _mm_storel_pi (reinterpret_cast<__m64*> (y), _mm_add_ps (accum, _mm_movehl_ps (accum, accum)));
+}
+
+template <bool complex_coeffs>
+static void process_fir_interp_complex (const Polyphase_FIR_State* state,
+                                        const float* ch_state,
+                                        float* y_data,
+                                        int n_samples_in)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
+
+    for (int n = 0; n < n_samples_in; ++n)
+    {
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            const auto accum = accumulate_complex<complex_coeffs> (_mm_setzero_ps(),
+                                                                   ch_state + 2 * n,
+                                                                   coeffs_v + filter_idx * n_taps_v,
+                                                                   coeffs_im_v + filter_idx * n_taps_v,
+                                                                   n_taps_v);
+            store_complex (y_data + 2 * (n * state->factor + filter_idx), accum);
+        }
+    }
+}
+
+template <bool complex_coeffs>
+static void process_fir_decim_complex (const Polyphase_FIR_State* state,
+                                       const float* ch_state,
+                                       float* y_data,
+                                       int n_samples_out)
+{
+    static constexpr int v_size = 4;
+    const auto n_taps_v = state->taps_per_filter_padded / v_size;
+    const auto* coeffs_v = reinterpret_cast<const __m128*> (state->coeffs);
+    const auto* coeffs_im_v = coeffs_v + n_taps_v * state->factor;
+
+    for (int n = 0; n < n_samples_out; ++n)
+    {
+        auto accum = _mm_setzero_ps();
+        for (int filter_idx = 0; filter_idx < state->factor; ++filter_idx)
+        {
+            accum = accumulate_complex<complex_coeffs> (accum,
+                                                        ch_state + filter_idx * state->state_per_filter_padded + 2 * n,
+                                                        coeffs_v + filter_idx * n_taps_v,
+                                                        coeffs_im_v + filter_idx * n_taps_v,
+                                                        n_taps_v);
+        }
+        store_complex (y_data + 2 * n, accum);
+    }
+}
 } // namespace chowdsp::polyphase_fir::sse
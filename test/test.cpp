@@ -323,3 +323,20 @@ TEST_CASE ("Round-Trip Polyphase Interpolation/Decimation")
         }
     }
 }
+
+TEST_CASE ("Scratch Size")
+{
+    namespace pfir = chowdsp::polyphase_fir;
+
+    // the scratch holds one float per sample (or per tap), regardless of the vector width
+    for (int alignment : { 16, 32, 64 })
+    {
+        for (int max_samples_in : { 1, 64, 1000 })
+        {
+            CAPTURE (alignment, max_samples_in);
+            const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, 2, max_samples_in, alignment);
+            REQUIRE (scratch_bytes >= (size_t) max_samples_in * sizeof (float));
+            REQUIRE (scratch_bytes <= (size_t) std::max (max_samples_in, n_taps + alignment) * sizeof (float) + (size_t) alignment);
+        }
+    }
+}
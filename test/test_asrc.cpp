@@ -0,0 +1,251 @@
+#include <chowdsp_filters/chowdsp_filters.h>
+#include <chowdsp_polyphase_fir.h>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace pfir = chowdsp::polyphase_fir;
+static constexpr double pi = 3.14159265358979323846;
+
+static constexpr int n_taps = 25;
+static constexpr float coeffs[n_taps] {
+    0.000410322870809364f,
+    -0.000000000000000001f,
+    -0.002230285518524044f,
+    0.000000000000000003f,
+    0.007100857132041434f,
+    -0.000000000000000006f,
+    -0.017917030421899412f,
+    0.000000000000000010f,
+    0.040107417651266832f,
+    -0.000000000000000015f,
+    -0.090106922079616902f,
+    0.000000000000000018f,
+    0.312633321620530980f,
+    0.500004637490783610f,
+    0.312633321620530980f,
+    0.000000000000000018f,
+    -0.090106922079616916f,
+    -0.000000000000000015f,
+    0.040107417651266852f,
+    0.000000000000000010f,
+    -0.017917030421899436f,
+    -0.000000000000000006f,
+    0.007100857132041438f,
+    0.000000000000000003f,
+    -0.002230285518524042f,
+};
+
+/** Blackman-windowed sinc lowpass at `n_phases` times the input rate, with unity gain per phase */
+static std::vector<float> make_prototype (int n_phases, int taps_per_phase)
+{
+    const auto n = n_phases * taps_per_phase;
+    std::vector<float> h ((size_t) n);
+    const auto centre = 0.5 * (n - 1);
+    const auto cutoff = 0.45 / n_phases;
+    for (int i = 0; i < n; ++i)
+    {
+        const auto t = (double) i - centre;
+        const auto sinc = t == 0.0 ? 2.0 * cutoff : std::sin (2.0 * pi * cutoff * t) / (pi * t);
+        const auto window = 0.42 - 0.5 * std::cos (2.0 * pi * i / (n - 1)) + 0.08 * std::cos (4.0 * pi * i / (n - 1));
+        h[(size_t) i] = (float) (sinc * window * n_phases);
+    }
+    return h;
+}
+
+template <int factor>
+static void test_asrc_integer_ratio (int n_channels, pfir::Polyphase_ASRC_Interpolation interpolation, bool use_avx)
+{
+    static constexpr int n_samples = 200;
+    const int block_sizes[] = { 1, 17, 64, 3, 50, 65 };
+    static constexpr int max_block_size = 65;
+
+    chowdsp::Buffer<float> buffer_in { n_channels, n_samples };
+    for (auto [ch, data] : chowdsp::buffer_iters::channels (buffer_in))
+        for (auto [n, x] : chowdsp::enumerate (data))
+            x = std::sin (0.1f * (float) n + (float) ch);
+
+    const auto alignment = use_avx ? 32 : 16;
+
+    // reference: integer polyphase interpolation
+    chowdsp::Buffer<float> ref_buffer_out { n_channels, n_samples * factor };
+    {
+        const auto persistent_bytes = pfir::persistent_bytes_required (n_channels, n_taps, factor, n_samples, alignment);
+        const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, n_samples, alignment);
+        chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+        auto* state = pfir::init (n_channels, n_taps, factor, n_samples, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+        pfir::load_coeffs (state, coeffs, n_taps);
+        pfir::process_interpolate (state,
+                                   buffer_in.getArrayOfReadPointers(),
+                                   ref_buffer_out.getArrayOfWritePointers(),
+                                   n_channels,
+                                   n_samples,
+                                   arena.allocate_bytes (scratch_bytes, alignment),
+                                   use_avx);
+    }
+
+    const auto persistent_bytes = pfir::asrc_persistent_bytes_required (n_channels, n_taps, factor, max_block_size, alignment);
+    const auto scratch_bytes = pfir::asrc_scratch_bytes_required (n_taps, factor, max_block_size, (double) factor, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+    auto* state = pfir::asrc_init (n_channels,
+                                   n_taps,
+                                   factor,
+                                   max_block_size,
+                                   (double) factor,
+                                   interpolation,
+                                   arena.allocate_bytes (persistent_bytes, alignment),
+                                   alignment);
+    pfir::asrc_load_coeffs (state, coeffs, n_taps);
+    pfir::asrc_set_ratio (state, (double) factor);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    chowdsp::Buffer<float> test_buffer_out { n_channels, n_samples * factor };
+    int sample_in = 0;
+    int sample_out = 0;
+    for (auto block_size : block_sizes)
+    {
+        const auto expected_samples_out = pfir::asrc_samples_out (state, block_size);
+        auto block_in = chowdsp::BufferView { buffer_in, sample_in, block_size };
+        auto block_out = chowdsp::BufferView { test_buffer_out, sample_out, expected_samples_out };
+        const auto n_samples_out = pfir::asrc_process (state,
+                                                       block_in.getArrayOfReadPointers(),
+                                                       block_out.getArrayOfWritePointers(),
+                                                       n_channels,
+                                                       block_size,
+                                                       scratch_data,
+                                                       use_avx);
+        REQUIRE (n_samples_out == expected_samples_out);
+        sample_in += block_size;
+        sample_out += n_samples_out;
+    }
+
+    // the resampler holds back one input sample of look-ahead
+    REQUIRE (sample_out == (sample_in - 1) * factor);
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        for (int n = 0; n < sample_out; ++n)
+            REQUIRE (test_buffer_out.getReadPointer (ch)[n] == Catch::Approx { ref_buffer_out.getReadPointer (ch)[n] }.margin (1.0e-5));
+    }
+}
+
+/** Resamples a sine at a ratio that drifts around `nominal_ratio`, and checks it against the ideal resampled sine */
+static void test_asrc_drift (double nominal_ratio, pfir::Polyphase_ASRC_Interpolation interpolation, bool use_avx)
+{
+    static constexpr int n_channels = 2;
+    static constexpr int n_phases = 64;
+    static constexpr int taps_per_phase = 32;
+    static constexpr int block_size = 96;
+    static constexpr int n_blocks = 40;
+    const auto max_ratio = 1.01 * nominal_ratio;
+    static constexpr double freq = 0.02; // cycles per input sample
+    const auto prototype = make_prototype (n_phases, taps_per_phase);
+    const auto n_proto_taps = (int) prototype.size();
+    const auto delay = 0.5 * (n_proto_taps - 1) / n_phases;
+
+    const auto alignment = use_avx ? 32 : 16;
+    const auto persistent_bytes = pfir::asrc_persistent_bytes_required (n_channels, n_proto_taps, n_phases, block_size, alignment);
+    const auto scratch_bytes = pfir::asrc_scratch_bytes_required (n_proto_taps, n_phases, block_size, max_ratio, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+    auto* state = pfir::asrc_init (n_channels,
+                                   n_proto_taps,
+                                   n_phases,
+                                   block_size,
+                                   max_ratio,
+                                   interpolation,
+                                   arena.allocate_bytes (persistent_bytes, alignment),
+                                   alignment);
+    pfir::asrc_load_coeffs (state, prototype.data(), n_proto_taps);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    chowdsp::Buffer<float> buffer_in { n_channels, block_size };
+    chowdsp::Buffer<float> buffer_out { n_channels, (int) std::ceil (block_size * max_ratio) + 1 };
+    REQUIRE (pfir::asrc_samples_out (state, block_size) <= buffer_out.getNumSamples()); // the initial ratio is within `max_ratio`
+
+    double block_start = 0.0;
+    double time = 0.0;
+    for (int block = 0; block < n_blocks; ++block)
+    {
+        // sweep the ratio between blocks, as a clock-drift compensator would
+        const auto ratio = nominal_ratio * (1.0 + 0.0001 * (double) (block % 7) - 0.0003);
+        pfir::asrc_set_ratio (state, ratio);
+
+        for (auto [ch, data] : chowdsp::buffer_iters::channels (buffer_in))
+            for (auto [n, x] : chowdsp::enumerate (data))
+                x = (float) std::sin (2.0 * pi * freq * (block_start + (double) n) + ch);
+
+        const auto n_samples_out = pfir::asrc_process (state,
+                                                       buffer_in.getArrayOfReadPointers(),
+                                                       buffer_out.getArrayOfWritePointers(),
+                                                       n_channels,
+                                                       block_size,
+                                                       scratch_data,
+                                                       use_avx);
+        REQUIRE (n_samples_out <= buffer_out.getNumSamples());
+
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            const auto t = block_start + time + (double) n / ratio;
+            if (t < (double) taps_per_phase) // skip the filter's warm-up
+                continue;
+
+            for (int ch = 0; ch < n_channels; ++ch)
+            {
+                const auto expected = std::sin (2.0 * pi * freq * (t - delay) + ch);
+                REQUIRE (buffer_out.getReadPointer (ch)[n] == Catch::Approx { expected }.margin (2.0e-3));
+            }
+        }
+
+        time += (double) n_samples_out / ratio - (double) block_size;
+        block_start += (double) block_size;
+    }
+}
+
+TEST_CASE ("Asynchronous Resampling")
+{
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    const bool use_avx[] = { false, true };
+#else
+    const bool use_avx[] = { false };
+#endif
+    const pfir::Polyphase_ASRC_Interpolation interpolations[] = { pfir::ASRC_Interpolation_Linear, pfir::ASRC_Interpolation_Cubic };
+
+    SECTION ("Integer Ratio")
+    {
+        for (auto avx : use_avx)
+        {
+            for (auto interpolation : interpolations)
+            {
+                for (int n_channels : { 1, 2 })
+                {
+                    test_asrc_integer_ratio<2> (n_channels, interpolation, avx);
+                    test_asrc_integer_ratio<3> (n_channels, interpolation, avx);
+                }
+            }
+        }
+    }
+
+    SECTION ("Drifting Ratio")
+    {
+        for (auto avx : use_avx)
+            for (auto interpolation : interpolations)
+                test_asrc_drift (1.0, interpolation, avx);
+    }
+
+    SECTION ("Downsampling")
+    {
+        for (auto avx : use_avx)
+        {
+            for (auto interpolation : interpolations)
+            {
+                for (double nominal_ratio : { 44100.0 / 48000.0, 0.5 })
+                {
+                    CAPTURE (avx, interpolation, nominal_ratio);
+                    test_asrc_drift (nominal_ratio, interpolation, avx);
+                }
+            }
+        }
+    }
+}
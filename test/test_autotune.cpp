@@ -0,0 +1,157 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+static constexpr pfir::Polyphase_FIR_Kernel all_kernels[] {
+    pfir::FIR_Kernel_SSE,
+    pfir::FIR_Kernel_SSE_Blocked,
+    pfir::FIR_Kernel_AVX,
+    pfir::FIR_Kernel_AVX_Blocked,
+    pfir::FIR_Kernel_NEON,
+    pfir::FIR_Kernel_NEON_Blocked,
+    pfir::FIR_Kernel_Generic,
+    pfir::FIR_Kernel_Generic_Blocked,
+};
+
+/** Checks that a kernel matches the default kernel (chosen by `use_avx = false`), for block sizes that don't line up with the blocking. */
+static void test_kernel (pfir::Polyphase_FIR_Kernel kernel, int factor, int n_taps, bool decimate)
+{
+    static constexpr int n_channels = 2;
+    static constexpr int alignment = 32;
+    const int block_sizes[] = { 37, 1, 6, 64, 4 };
+    static constexpr int max_block_size = 64;
+
+    std::mt19937 rng { 0x1357 + (unsigned) n_taps };
+    const auto coeffs = make_random_vector (n_taps, rng);
+    const auto in_factor = decimate ? factor : 1;
+    const auto out_factor = decimate ? 1 : factor;
+
+    const auto persistent_bytes = pfir::persistent_bytes_required (n_channels, n_taps, factor, max_block_size, alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, max_block_size, alignment);
+    chowdsp::ArenaAllocator<> arena { 2 * persistent_bytes + scratch_bytes + alignment };
+    pfir::Polyphase_FIR_State* states[2];
+    for (auto& state : states)
+    {
+        state = pfir::init (n_channels, n_taps, factor, max_block_size, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+        pfir::load_coeffs (state, coeffs.data(), n_taps);
+    }
+    pfir::set_kernels (states[1], kernel, kernel);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    for (auto block_size : block_sizes)
+    {
+        chowdsp::Buffer<float> buffer_in { n_channels, block_size * in_factor };
+        for (int ch = 0; ch < n_channels; ++ch)
+        {
+            const auto x = make_random_vector (block_size * in_factor, rng);
+            std::copy (x.begin(), x.end(), buffer_in.getWritePointer (ch));
+        }
+
+        chowdsp::Buffer<float> buffers_out[2] { { n_channels, block_size * out_factor }, { n_channels, block_size * out_factor } };
+        for (int i = 0; i < 2; ++i)
+        {
+            if (decimate)
+                pfir::process_decimate (states[i], buffer_in.getArrayOfReadPointers(), buffers_out[i].getArrayOfWritePointers(), n_channels, block_size * factor, scratch_data, false);
+            else
+                pfir::process_interpolate (states[i], buffer_in.getArrayOfReadPointers(), buffers_out[i].getArrayOfWritePointers(), n_channels, block_size, scratch_data, false);
+        }
+
+        for (int ch = 0; ch < n_channels; ++ch)
+        {
+            for (int n = 0; n < block_size * out_factor; ++n)
+                REQUIRE (buffers_out[1].getReadPointer (ch)[n] == Catch::Approx { buffers_out[0].getReadPointer (ch)[n] }.margin (1.0e-5));
+        }
+    }
+}
+
+TEST_CASE ("Kernel Variants")
+{
+    for (auto kernel : all_kernels)
+    {
+        if (! pfir::kernel_available (kernel))
+            continue;
+
+        for (int factor : { 2, 3 })
+        {
+            for (int n_taps : { 25, 64 })
+            {
+                test_kernel (kernel, factor, n_taps, false);
+                test_kernel (kernel, factor, n_taps, true);
+            }
+        }
+    }
+}
+
+TEST_CASE ("Autotune")
+{
+    static constexpr int n_channels = 2;
+    static constexpr int n_taps = 48;
+    static constexpr int factor = 2;
+    static constexpr int block_size = 128;
+    static constexpr int alignment = 32;
+
+    std::mt19937 rng { 0x9abc };
+    const auto coeffs = make_random_vector (n_taps, rng);
+    const auto wisdom_path = (std::filesystem::temp_directory_path() / "chowdsp_polyphase_fir_test_wisdom.txt").string();
+    std::remove (wisdom_path.c_str());
+
+    const auto persistent_bytes = pfir::persistent_bytes_required (n_channels, n_taps, factor, block_size, alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, block_size, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+    auto* state = pfir::init (n_channels, n_taps, factor, block_size, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+    pfir::load_coeffs (state, coeffs.data(), n_taps);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    SECTION ("Measurement")
+    {
+        pfir::autotune (state, block_size, scratch_data, wisdom_path.c_str());
+        REQUIRE (state->interp_kernel != pfir::FIR_Kernel_Auto);
+        REQUIRE (state->decim_kernel != pfir::FIR_Kernel_Auto);
+        REQUIRE (pfir::kernel_available ((pfir::Polyphase_FIR_Kernel) state->interp_kernel));
+        REQUIRE (pfir::kernel_available ((pfir::Polyphase_FIR_Kernel) state->decim_kernel));
+
+        // one line per mode
+        std::ifstream wisdom_file { wisdom_path };
+        int n_lines = 0;
+        for (std::string line; std::getline (wisdom_file, line);)
+            n_lines++;
+        REQUIRE (n_lines == 2);
+    }
+
+    SECTION ("Wisdom")
+    {
+        // the state should pick up whatever the wisdom file says, without measuring again
+        auto expected_kernel = pfir::FIR_Kernel_Generic_Blocked;
+        const auto* kernel_name = "generic_blocked";
+        if (pfir::kernel_available (pfir::FIR_Kernel_SSE_Blocked))
+        {
+            expected_kernel = pfir::FIR_Kernel_SSE_Blocked;
+            kernel_name = "sse_blocked";
+        }
+        else if (pfir::kernel_available (pfir::FIR_Kernel_NEON_Blocked))
+        {
+            expected_kernel = pfir::FIR_Kernel_NEON_Blocked;
+            kernel_name = "neon_blocked";
+        }
+        {
+            std::ofstream wisdom_file { wisdom_path };
+            wisdom_file << "interp " << n_channels << " " << factor << " " << state->taps_per_filter_padded << " " << block_size << " 0 " << kernel_name << "\n";
+            wisdom_file << "decim " << n_channels << " " << factor << " " << state->taps_per_filter_padded << " " << block_size << " 0 " << kernel_name << "\n";
+        }
+
+        pfir::autotune (state, block_size, scratch_data, wisdom_path.c_str());
+        REQUIRE (state->interp_kernel == expected_kernel);
+        REQUIRE (state->decim_kernel == expected_kernel);
+    }
+
+    std::remove (wisdom_path.c_str());
+}
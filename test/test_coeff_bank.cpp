@@ -0,0 +1,181 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr int alignment = 32;
+constexpr int max_block_size = 64;
+
+struct Filter_Config
+{
+    unsigned int id;
+    int n_channels;
+    int n_taps;
+    int factor;
+    int flags;
+};
+
+constexpr Filter_Config filter_configs[] {
+    { 10, 2, 57, 2, pfir::FIR_Flags_None },
+    { 20, 1, 100, 3, pfir::FIR_Flag_Coeffs_F16 },
+    { 30, 6, 33, 2, pfir::FIR_Flag_Per_Channel_Coeffs },
+};
+
+Filter_Spec get_spec (int n_channels, int n_taps, int factor, int flags)
+{
+    return { .n_channels = n_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_block_size, .flags = flags, .alignment = alignment };
+}
+
+/** Interpolates a signal whose channels are stored one after another */
+std::vector<float> interpolate (Filter& filter, const std::vector<float>& x)
+{
+    const auto n_channels = filter.state->n_channels;
+    const auto n_samples = (int) x.size() / n_channels;
+    std::vector<float> y (x.size() * (size_t) filter.state->factor);
+    std::vector<const float*> in;
+    std::vector<float*> out;
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        in.push_back (x.data() + ch * n_samples);
+        out.push_back (y.data() + ch * n_samples * filter.state->factor);
+    }
+    pfir::process_interpolate (filter.state, in.data(), out.data(), n_channels, n_samples, filter.scratch_data, false);
+    return y;
+}
+} // namespace
+
+TEST_CASE ("Coefficient Bank")
+{
+    const auto path = (std::filesystem::temp_directory_path() / "chowdsp_polyphase_fir_test_bank.bin").string();
+    std::mt19937 rng { 0xba4c };
+
+    // design the filters the usual way, and save their coefficient tables
+    std::vector<std::unique_ptr<Filter>> filters;
+    std::vector<const pfir::Polyphase_FIR_State*> states;
+    std::vector<unsigned int> ids;
+    for (const auto& config : filter_configs)
+    {
+        auto& filter = filters.emplace_back (std::make_unique<Filter> (get_spec (config.n_channels, config.n_taps, config.factor, config.flags)));
+        if ((config.flags & pfir::FIR_Flag_Per_Channel_Coeffs) != 0)
+        {
+            for (int ch = 0; ch < config.n_channels; ++ch)
+                pfir::load_coeffs_channel (filter->state, ch, make_random_vector (config.n_taps, rng).data(), config.n_taps);
+        }
+        else
+        {
+            pfir::load_coeffs (filter->state, make_random_vector (config.n_taps, rng).data(), config.n_taps);
+        }
+        states.push_back (filter->state);
+        ids.push_back (config.id);
+    }
+    REQUIRE (pfir::coeff_bank_write (path.c_str(), states.data(), ids.data(), (int) states.size()));
+
+    pfir::Polyphase_FIR_Coeff_Bank bank {};
+    REQUIRE (pfir::coeff_bank_open (&bank, path.c_str()));
+    REQUIRE (bank.n_entries == (int) std::size (filter_configs));
+    REQUIRE (pfir::coeff_bank_find (&bank, 999) == -1);
+
+    SECTION ("Attached filters match the original filters")
+    {
+        for (size_t i = 0; i < std::size (filter_configs); ++i)
+        {
+            const auto& config = filter_configs[i];
+            const auto index = pfir::coeff_bank_find (&bank, config.id);
+            REQUIRE (index == (int) i);
+
+            pfir::Polyphase_FIR_Coeff_Bank_Entry entry {};
+            pfir::coeff_bank_get_entry (&bank, index, &entry);
+            REQUIRE (entry.factor == config.factor);
+            REQUIRE (entry.flags == config.flags);
+            REQUIRE ((size_t) entry.coeffs % 64 == 0);
+
+            // external filters don't need any memory for coefficients
+            const auto flags = entry.flags | pfir::FIR_Flag_External_Coeffs;
+            REQUIRE (pfir::persistent_bytes_required_with_flags (config.n_channels, entry.n_taps, entry.factor, max_block_size, flags, alignment)
+                     < pfir::persistent_bytes_required_with_flags (config.n_channels, entry.n_taps, entry.factor, max_block_size, entry.flags, alignment));
+
+            Filter attached { get_spec (config.n_channels, entry.n_taps, entry.factor, flags) };
+            REQUIRE (pfir::coeff_bank_attach (attached.state, &bank, index));
+            REQUIRE ((const void*) attached.state->coeffs == (const void*) entry.coeffs);
+
+            const auto x = make_random_vector (config.n_channels * max_block_size, rng);
+            const auto y = interpolate (attached, x);
+            REQUIRE (y == interpolate (*filters[i], x));
+
+            // the table layout doesn't depend on the alignment, so filters with any alignment can share it
+            auto spec_16 = get_spec (config.n_channels, entry.n_taps, entry.factor, flags);
+            spec_16.alignment = 16;
+            Filter attached_16 { spec_16 };
+            REQUIRE (pfir::coeff_bank_attach (attached_16.state, &bank, index));
+            REQUIRE (interpolate (attached_16, x) == y);
+        }
+    }
+
+    SECTION ("Incompatible filters are rejected")
+    {
+        const auto index = pfir::coeff_bank_find (&bank, 10);
+        Filter wrong_factor { get_spec (2, 57, 3, pfir::FIR_Flag_External_Coeffs) };
+        REQUIRE (! pfir::coeff_bank_attach (wrong_factor.state, &bank, index));
+        Filter wrong_length { get_spec (2, 200, 2, pfir::FIR_Flag_External_Coeffs) };
+        REQUIRE (! pfir::coeff_bank_attach (wrong_length.state, &bank, index));
+        Filter wrong_format { get_spec (2, 57, 2, pfir::FIR_Flag_External_Coeffs | pfir::FIR_Flag_Coeffs_BF16) };
+        REQUIRE (! pfir::coeff_bank_attach (wrong_format.state, &bank, index));
+        Filter not_external { get_spec (2, 57, 2, pfir::FIR_Flags_None) };
+        REQUIRE (! pfir::coeff_bank_attach (not_external.state, &bank, index));
+
+        // the per-channel table only covers 2 groups of 4 channels
+        const auto per_channel_index = pfir::coeff_bank_find (&bank, 30);
+        Filter too_many_channels { get_spec (9, 33, 2, pfir::FIR_Flag_External_Coeffs | pfir::FIR_Flag_Per_Channel_Coeffs) };
+        REQUIRE (! pfir::coeff_bank_attach (too_many_channels.state, &bank, per_channel_index));
+        Filter fewer_channels { get_spec (3, 33, 2, pfir::FIR_Flag_External_Coeffs | pfir::FIR_Flag_Per_Channel_Coeffs) };
+        REQUIRE (pfir::coeff_bank_attach (fewer_channels.state, &bank, per_channel_index));
+    }
+
+    pfir::coeff_bank_close (&bank);
+    REQUIRE (bank.data == nullptr);
+
+    SECTION ("Invalid files are rejected")
+    {
+        // truncated
+        std::vector<char> contents;
+        {
+            auto* file = std::fopen (path.c_str(), "rb");
+            REQUIRE (file != nullptr);
+            for (int c; (c = std::fgetc (file)) != EOF;)
+                contents.push_back ((char) c);
+            std::fclose (file);
+        }
+        const auto rewrite = [&path] (const std::vector<char>& data)
+        {
+            auto* file = std::fopen (path.c_str(), "wb");
+            std::fwrite (data.data(), 1, data.size(), file);
+            std::fclose (file);
+        };
+
+        rewrite (std::vector<char> (contents.begin(), contents.end() - 16));
+        REQUIRE (! pfir::coeff_bank_open (&bank, path.c_str()));
+
+        // wrong version (version 1 banks used the old, alignment-padded layout)
+        auto bad_version = contents;
+        bad_version[8] = 1;
+        rewrite (bad_version);
+        REQUIRE (! pfir::coeff_bank_open (&bank, path.c_str()));
+
+        // not a bank at all
+        rewrite (std::vector<char> (100, 'x'));
+        REQUIRE (! pfir::coeff_bank_open (&bank, path.c_str()));
+
+        REQUIRE (! pfir::coeff_bank_open (&bank, (path + ".missing").c_str()));
+    }
+
+    std::filesystem::remove (path);
+}
@@ -0,0 +1,140 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr double pi = 3.14159265358979323846;
+constexpr int alignment = 16;
+constexpr int n_channels = 2;
+constexpr int n_taps = 61;
+constexpr int max_samples_in = 96;
+
+Filter_Spec get_spec (int filter_channels, int flags, int factor)
+{
+    return { .n_channels = filter_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_samples_in, .flags = flags, .alignment = alignment };
+}
+
+/**
+ * Checks a complex filter against two real filters, which process the I and Q parts as separate channels:
+ * (h_re + j h_im) * (x_i + j x_q) = (h_re * x_i - h_im * x_q) + j (h_re * x_q + h_im * x_i)
+ */
+void check_complex (int factor, bool decimate, bool complex_coeffs)
+{
+    auto coeffs_re = design_lowpass (n_taps, factor, (double) factor);
+    std::vector<float> coeffs_im (n_taps), coeffs_complex (2 * n_taps);
+    if (complex_coeffs)
+    {
+        // shift the lowpass up by a quarter of the lower sample rate, to select one band of the input
+        for (int n = 0; n < n_taps; ++n)
+        {
+            const auto phase = 0.5 * pi * (double) n / (double) factor;
+            coeffs_im[(size_t) n] = coeffs_re[(size_t) n] * (float) std::sin (phase);
+            coeffs_re[(size_t) n] *= (float) std::cos (phase);
+        }
+    }
+    for (int n = 0; n < n_taps; ++n)
+    {
+        coeffs_complex[(size_t) (2 * n)] = coeffs_re[(size_t) n];
+        coeffs_complex[(size_t) (2 * n + 1)] = coeffs_im[(size_t) n];
+    }
+
+    Filter complex_filter { get_spec (n_channels, complex_coeffs ? pfir::FIR_Flag_Complex_Coeffs : pfir::FIR_Flag_Complex_Samples, factor) };
+    if (complex_coeffs)
+        pfir::load_coeffs_complex (complex_filter.state, coeffs_complex.data(), n_taps);
+    else
+        pfir::load_coeffs (complex_filter.state, coeffs_re.data(), n_taps);
+
+    // channels (2 * ch, 2 * ch + 1) hold the (I, Q) parts of complex channel `ch`
+    Filter re_filter { get_spec (2 * n_channels, pfir::FIR_Flags_None, factor), coeffs_re };
+    Filter im_filter { get_spec (2 * n_channels, pfir::FIR_Flags_None, factor), coeffs_im };
+
+    std::mt19937 rng { 0xc0 };
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    for (int block_size : get_block_sizes (max_samples_in))
+    {
+        const auto n_samples_in = decimate ? block_size * factor : block_size;
+        const auto n_samples_out = decimate ? block_size : block_size * factor;
+
+        auto x = make_buffer (n_channels, 2 * n_samples_in);
+        auto x_planar = make_buffer (2 * n_channels, n_samples_in);
+        for (int ch = 0; ch < n_channels; ++ch)
+        {
+            for (int n = 0; n < 2 * n_samples_in; ++n)
+            {
+                x[(size_t) ch][(size_t) n] = dist (rng);
+                x_planar[(size_t) (2 * ch + n % 2)][(size_t) (n / 2)] = x[(size_t) ch][(size_t) n];
+            }
+        }
+
+        auto y = make_buffer (n_channels, 2 * n_samples_out);
+        auto y_re = make_buffer (2 * n_channels, n_samples_out);
+        auto y_im = make_buffer (2 * n_channels, n_samples_out);
+        const auto x_ptrs = get_input_pointers (x);
+        const auto x_planar_ptrs = get_input_pointers (x_planar);
+        const auto y_ptrs = get_output_pointers (y);
+        const auto y_re_ptrs = get_output_pointers (y_re);
+        const auto y_im_ptrs = get_output_pointers (y_im);
+        if (decimate)
+        {
+            pfir::process_decimate_complex (complex_filter.state, x_ptrs.data(), y_ptrs.data(), n_channels, n_samples_in);
+            pfir::process_decimate (re_filter.state, x_planar_ptrs.data(), y_re_ptrs.data(), 2 * n_channels, n_samples_in, re_filter.scratch_data, false);
+            pfir::process_decimate (im_filter.state, x_planar_ptrs.data(), y_im_ptrs.data(), 2 * n_channels, n_samples_in, im_filter.scratch_data, false);
+        }
+        else
+        {
+            pfir::process_interpolate_complex (complex_filter.state, x_ptrs.data(), y_ptrs.data(), n_channels, n_samples_in);
+            pfir::process_interpolate (re_filter.state, x_planar_ptrs.data(), y_re_ptrs.data(), 2 * n_channels, n_samples_in, re_filter.scratch_data, false);
+            pfir::process_interpolate (im_filter.state, x_planar_ptrs.data(), y_im_ptrs.data(), 2 * n_channels, n_samples_in, im_filter.scratch_data, false);
+        }
+
+        for (int ch = 0; ch < n_channels; ++ch)
+        {
+            const auto& i_re = y_re[(size_t) (2 * ch)];
+            const auto& q_re = y_re[(size_t) (2 * ch + 1)];
+            const auto& i_im = y_im[(size_t) (2 * ch)];
+            const auto& q_im = y_im[(size_t) (2 * ch + 1)];
+            CAPTURE (block_size, ch);
+            for (int n = 0; n < n_samples_out; ++n)
+            {
+                // the complex kernels sum the taps in a different order
+                REQUIRE (y[(size_t) ch][(size_t) (2 * n)] == Catch::Approx { i_re[(size_t) n] - q_im[(size_t) n] }.margin (1.0e-5));
+                REQUIRE (y[(size_t) ch][(size_t) (2 * n + 1)] == Catch::Approx { q_re[(size_t) n] + i_im[(size_t) n] }.margin (1.0e-5));
+            }
+        }
+    }
+}
+} // namespace
+
+TEST_CASE ("Complex Samples")
+{
+    SECTION ("Real Coefficients")
+    {
+        for (int factor : { 1, 2, 3, 4 })
+        {
+            for (bool decimate : { false, true })
+            {
+                CAPTURE (factor, decimate);
+                check_complex (factor, decimate, false);
+            }
+        }
+    }
+
+    SECTION ("Complex Coefficients")
+    {
+        for (int factor : { 1, 2, 3, 4 })
+        {
+            for (bool decimate : { false, true })
+            {
+                CAPTURE (factor, decimate);
+                check_complex (factor, decimate, true);
+            }
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include <chowdsp_polyphase_fir_design.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace pfir = chowdsp::polyphase_fir;
+
+namespace
+{
+constexpr double pi = 3.14159265358979323846;
+
+// designed at compile-time
+constexpr auto constexpr_coeffs = pfir::design_kaiser_lowpass<63> ({ .factor = 2, .passband = 0.8, .stopband_attenuation_db = 80.0, .gain = 2.0 });
+static_assert (constexpr_coeffs[0] == constexpr_coeffs[62] && constexpr_coeffs[10] == constexpr_coeffs[52]);
+static_assert (constexpr_coeffs[31] > 0.9f && constexpr_coeffs[31] < 1.1f);
+
+/** Returns the filter's magnitude response in dB, at a frequency relative to the low-rate Nyquist frequency */
+double get_magnitude_db (const std::vector<float>& coeffs, int factor, double frequency)
+{
+    const auto omega = frequency * pi / (double) factor;
+    double real = 0.0, imag = 0.0;
+    for (size_t n = 0; n < coeffs.size(); ++n)
+    {
+        real += (double) coeffs[n] * std::cos (omega * (double) n);
+        imag -= (double) coeffs[n] * std::sin (omega * (double) n);
+    }
+    return 20.0 * std::log10 (std::sqrt (real * real + imag * imag));
+}
+
+std::vector<float> design (const pfir::Polyphase_FIR_Design& params)
+{
+    std::vector<float> coeffs ((size_t) params.n_taps);
+    pfir::design_kaiser_lowpass (params, coeffs.data());
+    return coeffs;
+}
+} // namespace
+
+TEST_CASE ("Filter Design")
+{
+    SECTION ("Compile-time design matches run-time design")
+    {
+        const auto coeffs = design ({ .n_taps = 63, .factor = 2, .passband = 0.8, .stopband_attenuation_db = 80.0, .gain = 2.0 });
+        for (size_t n = 0; n < coeffs.size(); ++n)
+            REQUIRE (coeffs[n] == constexpr_coeffs[n]);
+    }
+
+    SECTION ("Kaiser lowpass meets its specification")
+    {
+        for (int factor : { 2, 3, 4, 8 })
+        {
+            for (double attenuation_db : { 60.0, 100.0, 140.0 })
+            {
+                static constexpr double passband = 0.85;
+                const auto n_taps = pfir::kaiser_taps_required (factor, passband, attenuation_db);
+                const auto coeffs = design ({ .n_taps = n_taps, .factor = factor, .passband = passband, .stopband_attenuation_db = attenuation_db });
+                CAPTURE (factor, attenuation_db, n_taps);
+
+                // Kaiser's formulas are estimates, so leave a little margin
+                for (double frequency = 0.0; frequency <= passband; frequency += 0.01)
+                    REQUIRE (std::abs (get_magnitude_db (coeffs, factor, frequency)) < 0.01);
+                for (double frequency = 1.0; frequency <= (double) factor; frequency += 0.01)
+                    REQUIRE (get_magnitude_db (coeffs, factor, frequency) < -attenuation_db + 3.0);
+            }
+        }
+    }
+
+    SECTION ("Half-band")
+    {
+        const auto coeffs = design ({ .n_taps = 95, .factor = 2, .stopband_attenuation_db = 100.0, .gain = 2.0, .half_band = true });
+        for (int n = 0; n < 95; ++n)
+        {
+            if (n != 47 && (47 - n) % 2 == 0)
+                REQUIRE (coeffs[(size_t) n] == 0.0f);
+            else
+                REQUIRE (coeffs[(size_t) n] != 0.0f);
+        }
+
+        // the response is symmetric about the half-band frequency, where it's -6 dB
+        REQUIRE (std::abs (get_magnitude_db (coeffs, 2, 1.0) - 20.0 * std::log10 (1.0)) < 0.01);
+        REQUIRE (std::abs (get_magnitude_db (coeffs, 2, 0.0) - 20.0 * std::log10 (2.0)) < 1.0e-3);
+        for (double frequency = 0.0; frequency < 0.7; frequency += 0.01)
+            REQUIRE (get_magnitude_db (coeffs, 2, 2.0 - frequency) < -97.0);
+    }
+
+    SECTION ("Design cache")
+    {
+        static constexpr int max_taps = 256;
+        std::vector<std::byte> cache_data (pfir::design_cache_bytes_required (2, max_taps));
+        auto* cache = pfir::design_cache_init (2, max_taps, cache_data.data());
+
+        const pfir::Polyphase_FIR_Design design_a { .n_taps = 100, .factor = 2 };
+        const pfir::Polyphase_FIR_Design design_b { .n_taps = 200, .factor = 4, .gain = 4.0 };
+        const pfir::Polyphase_FIR_Design design_c { .n_taps = 150, .factor = 3, .passband = 0.8 };
+
+        const auto* coeffs_a = pfir::design_cache_get (cache, design_a);
+        const auto* coeffs_b = pfir::design_cache_get (cache, design_b);
+        REQUIRE (coeffs_a != coeffs_b);
+        REQUIRE (pfir::design_cache_get (cache, design_a) == coeffs_a);
+        REQUIRE (pfir::design_cache_get (cache, design_b) == coeffs_b);
+
+        const auto expected_a = design (design_a);
+        for (size_t n = 0; n < expected_a.size(); ++n)
+            REQUIRE (coeffs_a[n] == expected_a[n]);
+
+        // a is now the least recently used, so c replaces it
+        REQUIRE (pfir::design_cache_get (cache, design_c) == coeffs_a);
+        REQUIRE (pfir::design_cache_get (cache, design_b) == coeffs_b);
+        const auto expected_c = design (design_c);
+        for (size_t n = 0; n < expected_c.size(); ++n)
+            REQUIRE (coeffs_a[n] == expected_c[n]);
+
+        // half-band designs ignore the passband
+        const pfir::Polyphase_FIR_Design half_band { .n_taps = 31, .factor = 2, .passband = 0.5, .half_band = true };
+        auto half_band_other_passband = half_band;
+        half_band_other_passband.passband = 0.6;
+        const auto* coeffs_half_band = pfir::design_cache_get (cache, half_band);
+        REQUIRE (pfir::design_cache_get (cache, half_band_other_passband) == coeffs_half_band);
+    }
+}
@@ -0,0 +1,172 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+static constexpr double pi = 3.14159265358979323846;
+
+/** X_k[f] = sum_i h[i] x[f * D - i] exp (-j 2 pi k (f * D - i) / M) */
+static std::complex<double> reference_analysis (const std::vector<float>& h, const std::vector<float>& x, int n_bands, int hop_size, int frame, int band)
+{
+    std::complex<double> sum {};
+    const auto t = frame * hop_size;
+    for (int i = 0; i < (int) h.size() && i <= t; ++i)
+    {
+        const auto angle = -2.0 * pi * (double) band * (double) (t - i) / (double) n_bands;
+        sum += (double) h[(size_t) i] * (double) x[(size_t) (t - i)] * std::polar (1.0, angle);
+    }
+    return sum;
+}
+
+/** y[t] = D * Re { sum_f sum_k Y_k[f] g[t - f * D] exp (j 2 pi k t / M) } */
+static double reference_synthesis (const std::vector<float>& g, const std::vector<std::complex<float>>& frames, int n_bands, int hop_size, int t)
+{
+    std::complex<double> sum {};
+    for (int frame = 0; frame * hop_size <= t && frame * n_bands < (int) frames.size(); ++frame)
+    {
+        const auto i = t - frame * hop_size;
+        if (i >= (int) g.size())
+            continue;
+        for (int band = 0; band < n_bands; ++band)
+        {
+            const auto angle = 2.0 * pi * (double) band * (double) t / (double) n_bands;
+            sum += (double) g[(size_t) i] * std::complex<double> { frames[(size_t) (frame * n_bands + band)] } * std::polar (1.0, angle);
+        }
+    }
+    return (double) hop_size * sum.real();
+}
+
+static void test_filter_bank (int n_bands, int oversampling, int n_taps, int n_channels, bool use_avx)
+{
+    std::mt19937 rng { 0x1234 };
+    const auto hop_size = n_bands / oversampling;
+    const auto prototype = make_random_vector (n_taps, rng);
+    const int blocks_in_frames[] = { 2 * oversampling, oversampling, 5 * oversampling, 3 * oversampling };
+    static constexpr int max_frames = 5 * 4;
+    int total_frames = 0;
+    for (auto frames : blocks_in_frames)
+        total_frames += frames;
+
+    const auto alignment = use_avx ? 32 : 16;
+    const auto persistent_bytes = pfir::filter_bank_persistent_bytes_required (n_channels, n_taps, n_bands, oversampling, max_frames, alignment);
+    const auto scratch_bytes = pfir::filter_bank_scratch_bytes_required (n_taps, n_bands, oversampling, max_frames, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+    auto* state = pfir::filter_bank_init (n_channels,
+                                          n_taps,
+                                          n_bands,
+                                          oversampling,
+                                          max_frames,
+                                          arena.allocate_bytes (persistent_bytes, alignment),
+                                          alignment);
+    pfir::filter_bank_load_coeffs (state, prototype.data(), n_taps);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    std::vector<std::vector<float>> x;
+    for (int ch = 0; ch < n_channels; ++ch)
+        x.push_back (make_random_vector (total_frames * hop_size, rng));
+
+    // analysis
+    chowdsp::Buffer<float> subbands { n_channels, 2 * total_frames * n_bands };
+    {
+        int frame = 0;
+        for (auto block_frames : blocks_in_frames)
+        {
+            std::vector<const float*> in_ptrs;
+            std::vector<float*> out_ptrs;
+            for (int ch = 0; ch < n_channels; ++ch)
+            {
+                in_ptrs.push_back (x[(size_t) ch].data() + frame * hop_size);
+                out_ptrs.push_back (subbands.getWritePointer (ch) + 2 * frame * n_bands);
+            }
+            pfir::filter_bank_process_analysis (state, in_ptrs.data(), out_ptrs.data(), n_channels, block_frames * hop_size, scratch_data, use_avx);
+            frame += block_frames;
+        }
+    }
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        for (int frame = 0; frame < total_frames; ++frame)
+        {
+            for (int band = 0; band < n_bands; ++band)
+            {
+                const auto expected = reference_analysis (prototype, x[(size_t) ch], n_bands, hop_size, frame, band);
+                const auto* actual = subbands.getReadPointer (ch) + 2 * (frame * n_bands + band);
+                REQUIRE (actual[0] == Catch::Approx { expected.real() }.margin (1.0e-4));
+                REQUIRE (actual[1] == Catch::Approx { expected.imag() }.margin (1.0e-4));
+            }
+        }
+    }
+
+    // synthesis, from random subband frames, in blocks that don't line up with the oversampling
+    const int synthesis_blocks[] = { 1, 4, 7, 2, 6 };
+    std::vector<std::vector<std::complex<float>>> y_frames;
+    chowdsp::Buffer<float> synthesis_in { n_channels, 2 * total_frames * n_bands };
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        const auto frame_data = make_random_vector (2 * total_frames * n_bands, rng);
+        std::copy (frame_data.begin(), frame_data.end(), synthesis_in.getWritePointer (ch));
+        y_frames.emplace_back ((const std::complex<float>*) frame_data.data(),
+                               (const std::complex<float>*) frame_data.data() + total_frames * n_bands);
+    }
+
+    chowdsp::Buffer<float> y { n_channels, total_frames * hop_size };
+    {
+        int frame = 0;
+        for (int block = 0; frame < total_frames; ++block)
+        {
+            const auto block_frames = std::min (synthesis_blocks[block % 5], total_frames - frame);
+            std::vector<const float*> in_ptrs;
+            std::vector<float*> out_ptrs;
+            for (int ch = 0; ch < n_channels; ++ch)
+            {
+                in_ptrs.push_back (synthesis_in.getReadPointer (ch) + 2 * frame * n_bands);
+                out_ptrs.push_back (y.getWritePointer (ch) + frame * hop_size);
+            }
+            pfir::filter_bank_process_synthesis (state, in_ptrs.data(), out_ptrs.data(), n_channels, block_frames, scratch_data, use_avx);
+            frame += block_frames;
+        }
+        REQUIRE (frame == total_frames);
+    }
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        for (int t = 0; t < total_frames * hop_size; ++t)
+        {
+            const auto expected = reference_synthesis (prototype, y_frames[(size_t) ch], n_bands, hop_size, t);
+            REQUIRE (y.getReadPointer (ch)[t] == Catch::Approx { expected }.margin (1.0e-3));
+        }
+    }
+}
+
+TEST_CASE ("Polyphase DFT Filter Bank")
+{
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    const bool use_avx[] = { false, true };
+#else
+    const bool use_avx[] = { false };
+#endif
+
+    SECTION ("Critically Sampled")
+    {
+        for (auto avx : use_avx)
+        {
+            test_filter_bank (8, 1, 64, 1, avx);
+            test_filter_bank (4, 1, 37, 2, avx);
+        }
+    }
+
+    SECTION ("Oversampled")
+    {
+        for (auto avx : use_avx)
+        {
+            test_filter_bank (8, 2, 64, 2, avx);
+            test_filter_bank (16, 4, 100, 1, avx);
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr pfir::Polyphase_FIR_Kernel fuzz_kernels[] {
+    pfir::FIR_Kernel_SSE,
+    pfir::FIR_Kernel_SSE_Blocked,
+    pfir::FIR_Kernel_AVX,
+    pfir::FIR_Kernel_AVX_Blocked,
+    pfir::FIR_Kernel_NEON,
+    pfir::FIR_Kernel_NEON_Blocked,
+    pfir::FIR_Kernel_Generic,
+    pfir::FIR_Kernel_Generic_Blocked,
+};
+
+/**
+ * The worst SNR measured over 4000 random configurations was about 122 dB,
+ * so this leaves some headroom for other compilers and platforms.
+ */
+constexpr double min_snr_db = 110.0;
+
+struct Fuzz_Config
+{
+    bool decimate;
+    bool per_channel;
+    int n_taps;
+    int factor;
+    int n_channels;
+    int alignment;
+    int max_block_size;
+    std::vector<int> blocks; // block sizes, in output samples when decimating, and input samples when interpolating
+};
+
+Fuzz_Config random_config (std::mt19937& rng)
+{
+    const auto random_int = [&rng] (int min, int max)
+    { return std::uniform_int_distribution<int> { min, max }(rng); };
+
+    Fuzz_Config config {};
+    config.decimate = random_int (0, 1) == 1;
+    config.per_channel = random_int (0, 3) == 0;
+    config.n_taps = (int) std::exp2 (std::uniform_real_distribution<double> { 4.0, 11.0 }(rng)); // 16-2048, log-uniform
+    config.factor = random_int (2, 8);
+    config.n_channels = random_int (1, 9);
+    config.alignment = 16 << random_int (0, 2);
+    config.max_block_size = random_int (0, 2) == 0 ? random_int (1, 8) : random_int (1, 300);
+
+    // run long enough for the whole filter to get involved
+    const auto n_samples = std::max (2 * config.n_taps / config.factor, 64);
+    for (int total = 0; total < n_samples;)
+    {
+        config.blocks.push_back (random_int (1, config.max_block_size));
+        total += config.blocks.back();
+    }
+    return config;
+}
+
+/** Direct-form polyphase reference, in double precision: y[m F + k] = sum_j h[j F + k] x[m - j] */
+std::vector<double> reference_interpolate (const std::vector<float>& h, const std::vector<float>& x, int factor)
+{
+    std::vector<double> y (x.size() * (size_t) factor);
+    for (int m = 0; m < (int) x.size(); ++m)
+    {
+        for (int k = 0; k < factor; ++k)
+        {
+            double sum = 0.0;
+            for (int j = 0; j * factor + k < (int) h.size() && j <= m; ++j)
+                sum += (double) h[(size_t) (j * factor + k)] * (double) x[(size_t) (m - j)];
+            y[(size_t) (m * factor + k)] = sum;
+        }
+    }
+    return y;
+}
+
+/** Direct-form reference, in double precision: y[m] = sum_i h[i] x[m F - i] */
+std::vector<double> reference_decimate (const std::vector<float>& h, const std::vector<float>& x, int factor)
+{
+    std::vector<double> y (x.size() / (size_t) factor);
+    for (int m = 0; m < (int) y.size(); ++m)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < (int) h.size() && i <= m * factor; ++i)
+            sum += (double) h[(size_t) i] * (double) x[(size_t) (m * factor - i)];
+        y[(size_t) m] = sum;
+    }
+    return y;
+}
+
+double get_snr_db (const std::vector<double>& reference, const std::vector<float>& test)
+{
+    double signal_energy = 0.0;
+    double error_energy = 0.0;
+    for (size_t n = 0; n < reference.size(); ++n)
+    {
+        signal_energy += reference[n] * reference[n];
+        error_energy += (reference[n] - (double) test[n]) * (reference[n] - (double) test[n]);
+    }
+    if (error_energy == 0.0)
+        return HUGE_VAL;
+    return 10.0 * std::log10 (signal_energy / error_energy);
+}
+
+std::vector<float> process_blocks (const Fuzz_Config& config,
+                                   pfir::Polyphase_FIR_Kernel kernel,
+                                   const std::vector<std::vector<float>>& coeffs,
+                                   const std::vector<std::vector<float>>& x,
+                                   int n_out_per_channel)
+{
+    const auto flags = config.per_channel ? pfir::FIR_Flag_Per_Channel_Coeffs : pfir::FIR_Flags_None;
+    const auto persistent_bytes = pfir::persistent_bytes_required_with_flags (config.n_channels, config.n_taps, config.factor, config.max_block_size, flags, config.alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (config.n_taps, config.factor, config.max_block_size, config.alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + 2 * (size_t) config.alignment };
+    auto* state = pfir::init_with_flags (config.n_channels,
+                                         config.n_taps,
+                                         config.factor,
+                                         config.max_block_size,
+                                         flags,
+                                         arena.allocate_bytes (persistent_bytes, (size_t) config.alignment),
+                                         config.alignment);
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, (size_t) config.alignment);
+    if (config.per_channel)
+    {
+        for (int ch = 0; ch < config.n_channels; ++ch)
+            pfir::load_coeffs_channel (state, ch, coeffs[(size_t) ch].data(), (int) coeffs[(size_t) ch].size());
+    }
+    else
+    {
+        pfir::load_coeffs (state, coeffs[0].data(), config.n_taps);
+    }
+    pfir::set_kernels (state, kernel, kernel);
+
+    const auto in_factor = config.decimate ? config.factor : 1;
+    const auto out_factor = config.decimate ? 1 : config.factor;
+    std::vector<float> y ((size_t) (n_out_per_channel * config.n_channels));
+    std::vector<const float*> in_ptrs ((size_t) config.n_channels);
+    std::vector<float*> out_ptrs ((size_t) config.n_channels);
+    int sample = 0;
+    for (auto block_size : config.blocks)
+    {
+        for (int ch = 0; ch < config.n_channels; ++ch)
+        {
+            in_ptrs[(size_t) ch] = x[(size_t) ch].data() + sample * in_factor;
+            out_ptrs[(size_t) ch] = y.data() + ch * n_out_per_channel + sample * out_factor;
+        }
+
+        if (config.decimate)
+            pfir::process_decimate (state, in_ptrs.data(), out_ptrs.data(), config.n_channels, block_size * config.factor, scratch_data, false);
+        else
+            pfir::process_interpolate (state, in_ptrs.data(), out_ptrs.data(), config.n_channels, block_size, scratch_data, false);
+        sample += block_size;
+    }
+
+    return y;
+}
+} // namespace
+
+/**
+ * Differential fuzz test: random filters, factors, channel counts, alignments, and block splits,
+ * processed with every kernel available on this machine, and compared against a double-precision reference.
+ */
+TEST_CASE ("Differential Fuzz")
+{
+    static constexpr int n_configs = 128;
+    std::mt19937 rng { 0x5eed };
+
+    double worst_snr_db = HUGE_VAL;
+    for (int config_idx = 0; config_idx < n_configs; ++config_idx)
+    {
+        const auto config = random_config (rng);
+        int n_samples = 0;
+        for (auto block_size : config.blocks)
+            n_samples += block_size;
+        const auto n_in = config.decimate ? n_samples * config.factor : n_samples;
+        const auto n_out = config.decimate ? n_samples : n_samples * config.factor;
+
+        // per-channel filters may be shorter than the length the state was sized for
+        const auto coeff_scale = 1.0f / std::sqrt ((float) config.n_taps);
+        std::vector<std::vector<float>> coeffs;
+        for (int ch = 0; ch < (config.per_channel ? config.n_channels : 1); ++ch)
+        {
+            const auto n_taps = ch == 0 ? config.n_taps : std::uniform_int_distribution<int> { 1, config.n_taps }(rng);
+            coeffs.push_back (make_random_vector (n_taps, rng, coeff_scale));
+        }
+
+        std::vector<std::vector<float>> x;
+        std::vector<std::vector<double>> y_ref;
+        for (int ch = 0; ch < config.n_channels; ++ch)
+        {
+            x.push_back (make_random_vector (n_in, rng));
+            const auto& h = coeffs[config.per_channel ? (size_t) ch : 0];
+            y_ref.push_back (config.decimate ? reference_decimate (h, x.back(), config.factor)
+                                             : reference_interpolate (h, x.back(), config.factor));
+        }
+
+        for (auto kernel : fuzz_kernels)
+        {
+            const auto is_avx = kernel == pfir::FIR_Kernel_AVX || kernel == pfir::FIR_Kernel_AVX_Blocked;
+            const auto is_blocked = kernel == pfir::FIR_Kernel_SSE_Blocked || kernel == pfir::FIR_Kernel_AVX_Blocked || kernel == pfir::FIR_Kernel_NEON_Blocked || kernel == pfir::FIR_Kernel_Generic_Blocked;
+            if (! pfir::kernel_available (kernel)
+                || (is_avx && config.alignment < 32)
+                || (is_blocked && config.per_channel)) // the per-channel kernels don't have blocked variants
+                continue;
+
+            const auto y = process_blocks (config, kernel, coeffs, x, n_out);
+            for (int ch = 0; ch < config.n_channels; ++ch)
+            {
+                const std::vector<float> y_ch (y.begin() + ch * n_out, y.begin() + (ch + 1) * n_out);
+                const auto snr_db = get_snr_db (y_ref[(size_t) ch], y_ch);
+                worst_snr_db = std::min (worst_snr_db, snr_db);
+
+                CAPTURE (config_idx, config.decimate, config.per_channel, config.n_taps, config.factor, config.n_channels, config.alignment, config.max_block_size, (int) kernel, ch);
+                REQUIRE (snr_db > min_snr_db);
+            }
+        }
+    }
+
+    INFO ("worst SNR: " << worst_snr_db << " dB");
+    CHECK (worst_snr_db > min_snr_db);
+}
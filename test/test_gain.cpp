@@ -0,0 +1,143 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr int n_channels = 6;
+constexpr int factor = 3;
+constexpr int n_taps = 53;
+constexpr int max_samples_in = 128;
+constexpr float gains[n_channels] { 0.5f, -1.25f, 2.0f, 0.0f, 1.0f, 0.3f };
+
+struct Gain_Test_Filter : Filter
+{
+    Gain_Test_Filter (int flags, pfir::Polyphase_FIR_Kernel kernel)
+        : Filter { { .n_channels = n_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_samples_in, .flags = flags },
+                   design_lowpass (n_taps, factor, (double) factor) }
+    {
+        pfir::set_kernels (state, kernel, kernel);
+    }
+};
+
+/** The fused gain and accumulation should match scaling and adding the plain output afterwards */
+void check_gain (int flags, pfir::Polyphase_FIR_Kernel kernel, bool decimate, bool accumulate, std::mt19937& rng)
+{
+    Gain_Test_Filter plain_filter { flags, kernel };
+    Gain_Test_Filter gain_filter { flags, kernel };
+
+    for (int block_size : get_block_sizes (max_samples_in))
+    {
+        const auto n_samples_in = decimate ? block_size * factor : block_size;
+        const auto n_samples_out = decimate ? block_size : block_size * factor;
+        const auto x = make_random_buffer (n_channels, n_samples_in, rng);
+        const auto x_ptrs = get_input_pointers (x);
+
+        auto y_plain = make_buffer (n_channels, n_samples_out);
+        auto y_gain = make_random_buffer (n_channels, n_samples_out, rng); // the existing contents of the bus
+        auto y_expected = y_gain;
+        const auto y_plain_ptrs = get_output_pointers (y_plain);
+        const auto y_gain_ptrs = get_output_pointers (y_gain);
+
+        if (decimate)
+        {
+            pfir::process_decimate (plain_filter.state, x_ptrs.data(), y_plain_ptrs.data(), n_channels, n_samples_in, plain_filter.scratch_data, false);
+            pfir::process_decimate_with_gain (gain_filter.state, x_ptrs.data(), y_gain_ptrs.data(), gains, accumulate, n_channels, n_samples_in, gain_filter.scratch_data, false);
+        }
+        else
+        {
+            pfir::process_interpolate (plain_filter.state, x_ptrs.data(), y_plain_ptrs.data(), n_channels, n_samples_in, plain_filter.scratch_data, false);
+            pfir::process_interpolate_with_gain (gain_filter.state, x_ptrs.data(), y_gain_ptrs.data(), gains, accumulate, n_channels, n_samples_in, gain_filter.scratch_data, false);
+        }
+
+        for (int ch = 0; ch < n_channels; ++ch)
+        {
+            for (int n = 0; n < n_samples_out; ++n)
+            {
+                auto& expected = y_expected[(size_t) ch][(size_t) n];
+                const auto scaled = gains[ch] * y_plain[(size_t) ch][(size_t) n];
+                expected = accumulate ? expected + scaled : scaled;
+            }
+            // the AVX kernels may fuse the accumulation into an FMA, which rounds slightly differently
+            CAPTURE (block_size, ch);
+            for (int n = 0; n < n_samples_out; ++n)
+                REQUIRE (y_gain[(size_t) ch][(size_t) n] == Catch::Approx { y_expected[(size_t) ch][(size_t) n] }.margin (1.0e-6));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE ("Gain and Accumulation")
+{
+    SECTION ("Fused Gain")
+    {
+        std::mt19937 rng { 0x6a1 };
+        for (int flags : { (int) pfir::FIR_Flags_None, (int) pfir::FIR_Flag_Per_Channel_Coeffs, (int) pfir::FIR_Flag_Coeffs_F16 })
+        {
+            for (auto kernel : { pfir::FIR_Kernel_SSE, pfir::FIR_Kernel_SSE_Blocked, pfir::FIR_Kernel_AVX, pfir::FIR_Kernel_AVX_Blocked, pfir::FIR_Kernel_NEON, pfir::FIR_Kernel_NEON_Blocked, pfir::FIR_Kernel_Generic, pfir::FIR_Kernel_Generic_Blocked })
+            {
+                if (! pfir::kernel_available (kernel))
+                    continue;
+
+                for (bool decimate : { false, true })
+                {
+                    for (bool accumulate : { false, true })
+                    {
+                        CAPTURE (flags, kernel, decimate, accumulate);
+                        check_gain (flags, kernel, decimate, accumulate, rng);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION ("Null gains accumulate at unity gain")
+    {
+        std::mt19937 rng { 0x6a2 };
+        Gain_Test_Filter plain_filter { pfir::FIR_Flags_None, pfir::FIR_Kernel_Auto };
+        Gain_Test_Filter gain_filter { pfir::FIR_Flags_None, pfir::FIR_Kernel_Auto };
+        const auto x = make_random_buffer (n_channels, max_samples_in, rng);
+        const auto x_ptrs = get_input_pointers (x);
+
+        auto y_plain = make_buffer (n_channels, max_samples_in * factor);
+        auto y_gain = make_random_buffer (n_channels, max_samples_in * factor, rng);
+        const auto y_bus = y_gain;
+        pfir::process_interpolate (plain_filter.state, x_ptrs.data(), get_output_pointers (y_plain).data(), n_channels, max_samples_in, plain_filter.scratch_data, false);
+        pfir::process_interpolate_with_gain (gain_filter.state, x_ptrs.data(), get_output_pointers (y_gain).data(), nullptr, true, n_channels, max_samples_in, gain_filter.scratch_data, false);
+
+        for (int ch = 0; ch < n_channels; ++ch)
+            for (int n = 0; n < max_samples_in * factor; ++n)
+                REQUIRE (y_gain[(size_t) ch][(size_t) n] == y_bus[(size_t) ch][(size_t) n] + y_plain[(size_t) ch][(size_t) n]);
+    }
+
+    SECTION ("Static gain is folded into the coefficients")
+    {
+        static constexpr float static_gain = 0.7f;
+        const auto coeffs = design_lowpass (n_taps, factor, (double) factor);
+        auto scaled_coeffs = coeffs;
+        for (auto& c : scaled_coeffs)
+            c *= static_gain;
+
+        for (int flags : { (int) pfir::FIR_Flags_None, (int) pfir::FIR_Flag_Per_Channel_Coeffs, (int) pfir::FIR_Flag_Coeffs_BF16 })
+        {
+            CAPTURE (flags);
+            Gain_Test_Filter scaled_filter { flags, pfir::FIR_Kernel_Auto };
+            Gain_Test_Filter gain_filter { flags, pfir::FIR_Kernel_Auto };
+            pfir::load_coeffs (scaled_filter.state, scaled_coeffs.data(), n_taps);
+            pfir::load_coeffs_with_gain (gain_filter.state, coeffs.data(), n_taps, static_gain);
+
+            // compare the raw coefficient storage, since it holds fp16/bf16 values for the half-precision flags
+            const auto coeffs_bytes = (size_t) (gain_filter.state->taps_per_filter_padded * factor)
+                                      * ((flags & pfir::FIR_Flag_Coeffs_BF16) != 0 ? sizeof (uint16_t) : sizeof (float))
+                                      * ((flags & pfir::FIR_Flag_Per_Channel_Coeffs) != 0 ? 8 : 1); // 2 groups of 4 channels
+            REQUIRE (std::memcmp (gain_filter.state->coeffs, scaled_filter.state->coeffs, coeffs_bytes) == 0);
+        }
+    }
+}
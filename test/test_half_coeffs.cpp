@@ -0,0 +1,130 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+/** Rounds to the nearest fp16 or bf16 value (ties to even), ignoring overflow. */
+float round_to_half (float value, bool is_fp16)
+{
+    if (value == 0.0f)
+        return 0.0f;
+
+    int exponent;
+    std::frexp (value, &exponent);
+    const auto n_bits = is_fp16 ? 11 : 8;
+    if (is_fp16)
+        exponent = std::max (exponent, -13); // fp16 subnormals have a fixed step of 2^-24
+    const auto step = std::ldexp (1.0, exponent - n_bits);
+    return (float) (std::nearbyint ((double) value / step) * step);
+}
+
+std::vector<float> process (const std::vector<float>& coeffs,
+                            const std::vector<float>& x,
+                            int factor,
+                            bool decimate,
+                            int flags,
+                            pfir::Polyphase_FIR_Kernel kernel)
+{
+    static constexpr int max_block_size = 96;
+    Filter filter { { .n_taps = (int) coeffs.size(), .factor = factor, .max_samples_in = max_block_size, .flags = flags }, coeffs };
+    pfir::set_kernels (filter.state, kernel, kernel);
+
+    const auto in_factor = decimate ? factor : 1;
+    const auto out_factor = decimate ? 1 : factor;
+    const auto n_samples = (int) x.size() / in_factor;
+    std::vector<float> y ((size_t) (n_samples * out_factor));
+    for (int sample = 0; sample < n_samples; sample += max_block_size)
+    {
+        const auto block_size = std::min (max_block_size, n_samples - sample);
+        const float* in = x.data() + sample * in_factor;
+        float* out = y.data() + sample * out_factor;
+        if (decimate)
+            pfir::process_decimate (filter.state, &in, &out, 1, block_size * factor, filter.scratch_data, false);
+        else
+            pfir::process_interpolate (filter.state, &in, &out, 1, block_size, filter.scratch_data, false);
+    }
+    return y;
+}
+
+double get_snr_db (const std::vector<float>& reference, const std::vector<float>& test)
+{
+    double signal_energy = 0.0;
+    double error_energy = 0.0;
+    for (size_t n = 0; n < reference.size(); ++n)
+    {
+        signal_energy += (double) reference[n] * (double) reference[n];
+        error_energy += ((double) reference[n] - (double) test[n]) * ((double) reference[n] - (double) test[n]);
+    }
+    return 10.0 * std::log10 (signal_energy / error_energy);
+}
+
+void test_half_coeffs (int flags, double min_snr_db)
+{
+    const auto is_fp16 = flags == pfir::FIR_Flag_Coeffs_F16;
+    static constexpr int n_taps = 127;
+    static constexpr int n_samples = 400;
+
+    // half-precision coefficients need half as much memory
+    REQUIRE (pfir::persistent_bytes_required_with_flags (1, 1024, 2, 64, flags, 32) < pfir::persistent_bytes_required (1, 1024, 2, 64, 32));
+
+    for (auto kernel : { pfir::FIR_Kernel_SSE, pfir::FIR_Kernel_AVX, pfir::FIR_Kernel_NEON, pfir::FIR_Kernel_Generic })
+    {
+        if (! pfir::kernel_available (kernel))
+            continue;
+
+        auto worst_snr_db = HUGE_VAL;
+
+        for (int factor : { 2, 3 })
+        {
+            for (bool decimate : { false, true })
+            {
+                std::mt19937 rng { 0x1616 + (unsigned) factor };
+                const auto x = make_random_vector (decimate ? n_samples * factor : n_samples, rng);
+                const auto coeffs = design_lowpass (n_taps, factor, 1.0);
+                std::vector<float> rounded_coeffs;
+                for (auto coeff : coeffs)
+                    rounded_coeffs.push_back (round_to_half (coeff, is_fp16));
+
+                // the kernels should compute the same thing as a float filter with rounded coefficients...
+                const auto y = process (coeffs, x, factor, decimate, flags, kernel);
+                const auto y_rounded = process (rounded_coeffs, x, factor, decimate, pfir::FIR_Flags_None, kernel);
+                for (size_t n = 0; n < y.size(); ++n)
+                {
+                    CAPTURE (kernel, factor, decimate, n);
+                    REQUIRE (y[n] == Catch::Approx { y_rounded[n] }.margin (1.0e-6));
+                }
+
+                // ... and the rounding shouldn't cost too much accuracy
+                const auto y_float = process (coeffs, x, factor, decimate, pfir::FIR_Flags_None, kernel);
+                const auto snr_db = get_snr_db (y_float, y);
+                CAPTURE (kernel, factor, decimate);
+                REQUIRE (snr_db > min_snr_db);
+                worst_snr_db = std::min (worst_snr_db, snr_db);
+            }
+        }
+
+        WARN ((is_fp16 ? "fp16" : "bf16") << " coefficients (kernel " << (int) kernel << "): worst SNR vs. float coefficients = " << worst_snr_db << " dB");
+    }
+}
+} // namespace
+
+TEST_CASE ("Half-Precision Coefficients")
+{
+    SECTION ("fp16")
+    {
+        test_half_coeffs (pfir::FIR_Flag_Coeffs_F16, 65.0);
+    }
+
+    SECTION ("bf16")
+    {
+        test_half_coeffs (pfir::FIR_Flag_Coeffs_BF16, 50.0);
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <chowdsp_filters/chowdsp_filters.h>
+#include <chowdsp_polyphase_fir.h>
+#include <chowdsp_polyphase_fir_design.h>
+
+#include <random>
+#include <vector>
+
+/** Setup shared between the tests: filters that own their memory, and test signals. */
+namespace test_helpers
+{
+namespace pfir = chowdsp::polyphase_fir;
+
+/** The filter that `Filter` allocates and initializes. */
+struct Filter_Spec
+{
+    int n_channels = 1;
+    int n_taps = 0;
+    int factor = 1; // or the largest factor, with `switchable_factor`
+    int max_samples_in = 0;
+    int flags = pfir::FIR_Flags_None;
+    int alignment = 32;
+    bool switchable_factor = false; // initialize with `init_max_factor()`, so that `set_factor()` can be used
+    bool pcm_scratch = false; // allocate enough scratch memory for the PCM process methods
+};
+
+inline size_t get_persistent_bytes (const Filter_Spec& spec)
+{
+    if (spec.switchable_factor)
+        return pfir::persistent_bytes_required_max_factor (spec.n_channels, spec.n_taps, spec.factor, spec.max_samples_in, spec.flags, spec.alignment);
+    return pfir::persistent_bytes_required_with_flags (spec.n_channels, spec.n_taps, spec.factor, spec.max_samples_in, spec.flags, spec.alignment);
+}
+
+inline size_t get_scratch_bytes (const Filter_Spec& spec)
+{
+    // a factor of 1 has the most taps per filter, so its scratch is enough for any factor
+    const auto factor = spec.switchable_factor ? 1 : spec.factor;
+    if (spec.pcm_scratch)
+        return pfir::pcm_scratch_bytes_required (spec.n_taps, factor, spec.max_samples_in, spec.alignment);
+    return pfir::scratch_bytes_required (spec.n_taps, factor, spec.max_samples_in, spec.alignment);
+}
+
+/** A filter, along with the arena that holds its persistent and scratch memory. */
+struct Filter
+{
+    explicit Filter (const Filter_Spec& spec)
+        : arena { get_persistent_bytes (spec) + get_scratch_bytes (spec) + 2 * (size_t) spec.alignment }
+    {
+        auto* persistent_data = arena.allocate_bytes (get_persistent_bytes (spec), (size_t) spec.alignment);
+        state = spec.switchable_factor
+                    ? pfir::init_max_factor (spec.n_channels, spec.n_taps, spec.factor, spec.max_samples_in, spec.flags, persistent_data, spec.alignment)
+                    : pfir::init_with_flags (spec.n_channels, spec.n_taps, spec.factor, spec.max_samples_in, spec.flags, persistent_data, spec.alignment);
+        scratch_data = arena.allocate_bytes (get_scratch_bytes (spec), (size_t) spec.alignment);
+    }
+
+    /** Also loads the coefficients, with `load_coeffs()`. */
+    Filter (const Filter_Spec& spec, const std::vector<float>& coeffs)
+        : Filter { spec }
+    {
+        pfir::load_coeffs (state, coeffs.data(), (int) coeffs.size());
+    }
+
+    Filter (const Filter&) = delete; // the state points into the arena
+    Filter& operator= (const Filter&) = delete;
+
+    chowdsp::ArenaAllocator<> arena;
+    pfir::Polyphase_FIR_State* state {};
+    void* scratch_data {};
+};
+
+/** A polyphase IIR half-band filter, along with the arena that holds its persistent and scratch memory. */
+struct IIR_Halfband_Filter
+{
+    IIR_Halfband_Filter (const std::vector<float>& coeffs, int n_channels, int max_samples_in, int alignment = 32)
+        : arena { pfir::iir_halfband_persistent_bytes_required (n_channels, (int) coeffs.size(), alignment)
+                  + pfir::iir_halfband_scratch_bytes_required (max_samples_in, alignment) + 2 * (size_t) alignment }
+    {
+        const auto n_coeffs = (int) coeffs.size();
+        auto* persistent_data = arena.allocate_bytes (pfir::iir_halfband_persistent_bytes_required (n_channels, n_coeffs, alignment), (size_t) alignment);
+        state = pfir::iir_halfband_init (n_channels, n_coeffs, persistent_data, alignment);
+        scratch_data = arena.allocate_bytes (pfir::iir_halfband_scratch_bytes_required (max_samples_in, alignment), (size_t) alignment);
+        pfir::iir_halfband_load_coeffs (state, coeffs.data(), n_coeffs);
+    }
+
+    IIR_Halfband_Filter (const IIR_Halfband_Filter&) = delete;
+    IIR_Halfband_Filter& operator= (const IIR_Halfband_Filter&) = delete;
+
+    chowdsp::ArenaAllocator<> arena;
+    pfir::Polyphase_IIR_State* state {};
+    void* scratch_data {};
+};
+
+/** A Kaiser-windowed lowpass, for a filter with the given factor. */
+inline std::vector<float> design_lowpass (int n_taps, int factor, double gain)
+{
+    std::vector<float> coeffs ((size_t) n_taps);
+    pfir::design_kaiser_lowpass ({ .n_taps = n_taps, .factor = factor, .gain = gain }, coeffs.data());
+    return coeffs;
+}
+
+/**
+ * Block sizes to process in turn: a full block, then sizes that leave different remainders
+ * after the kernels' vector widths and block sizes.
+ */
+inline std::vector<int> get_block_sizes (int max_block_size)
+{
+    return { max_block_size, 1, 37, 4, max_block_size - 5 };
+}
+
+/** Uniform noise in [-scale, scale]. */
+inline std::vector<float> make_random_vector (int size, std::mt19937& rng, float scale = 1.0f)
+{
+    std::uniform_real_distribution<float> dist { -scale, scale };
+    std::vector<float> x ((size_t) size);
+    for (auto& value : x)
+        value = dist (rng);
+    return x;
+}
+
+using Buffer = std::vector<std::vector<float>>;
+
+inline Buffer make_buffer (int n_channels, int n_samples)
+{
+    return Buffer ((size_t) n_channels, std::vector<float> ((size_t) n_samples));
+}
+
+/** A buffer of uniform noise in [-1, 1]. */
+inline Buffer make_random_buffer (int n_channels, int n_samples, std::mt19937& rng)
+{
+    Buffer buffer;
+    for (int ch = 0; ch < n_channels; ++ch)
+        buffer.push_back (make_random_vector (n_samples, rng));
+    return buffer;
+}
+
+inline std::vector<const float*> get_input_pointers (const Buffer& buffer)
+{
+    std::vector<const float*> pointers;
+    for (auto& channel : buffer)
+        pointers.push_back (channel.data());
+    return pointers;
+}
+
+inline std::vector<float*> get_output_pointers (Buffer& buffer)
+{
+    std::vector<float*> pointers;
+    for (auto& channel : buffer)
+        pointers.push_back (channel.data());
+    return pointers;
+}
+} // namespace test_helpers
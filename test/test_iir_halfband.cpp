@@ -0,0 +1,182 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr double pi = 3.14159265358979323846;
+
+/** Reference implementation of the two allpass chains, processing a single channel */
+struct Reference_IIR_Halfband
+{
+    std::vector<float> coeffs_0, coeffs_1;
+    std::vector<float> mem_0, mem_1;
+
+    explicit Reference_IIR_Halfband (const std::vector<float>& coeffs)
+    {
+        for (size_t i = 0; i < coeffs.size(); ++i)
+            (i % 2 == 0 ? coeffs_0 : coeffs_1).push_back (coeffs[i]);
+        mem_0.resize (coeffs_0.size() + 1, 0.0f);
+        mem_1.resize (coeffs_1.size() + 1, 0.0f);
+    }
+
+    static float process_chain (float x, std::vector<float>& mem, const std::vector<float>& coeffs)
+    {
+        for (size_t k = 0; k < coeffs.size(); ++k)
+        {
+            const auto y = (x - mem[k + 1]) * coeffs[k] + mem[k];
+            mem[k] = x;
+            x = y;
+        }
+        mem[coeffs.size()] = x;
+        return x;
+    }
+
+    void interpolate (const float* x, float* y, int n_samples_in)
+    {
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            y[2 * n] = process_chain (x[n], mem_0, coeffs_0);
+            y[2 * n + 1] = process_chain (x[n], mem_1, coeffs_1);
+        }
+    }
+
+    void decimate (const float* x, float* y, int n_samples_out)
+    {
+        for (int n = 0; n < n_samples_out; ++n)
+            y[n] = 0.5f * (process_chain (x[2 * n + 1], mem_0, coeffs_0) + process_chain (x[2 * n], mem_1, coeffs_1));
+    }
+};
+
+std::vector<float> design (double passband, double attenuation_db)
+{
+    std::vector<float> coeffs ((size_t) pfir::iir_halfband_coeffs_required (passband, attenuation_db));
+    pfir::iir_halfband_design (coeffs.data(), (int) coeffs.size(), passband);
+    return coeffs;
+}
+
+/** Returns the magnitude response in dB, at a frequency relative to the low-rate Nyquist frequency */
+double get_magnitude_db (const std::vector<float>& impulse_response, double frequency)
+{
+    const auto omega = frequency * pi / 2.0;
+    double real = 0.0, imag = 0.0;
+    for (size_t n = 0; n < impulse_response.size(); ++n)
+    {
+        real += (double) impulse_response[n] * std::cos (omega * (double) n);
+        imag -= (double) impulse_response[n] * std::sin (omega * (double) n);
+    }
+    return 20.0 * std::log10 (std::sqrt (real * real + imag * imag));
+}
+} // namespace
+
+TEST_CASE ("IIR Half-Band")
+{
+    SECTION ("Design meets its specification")
+    {
+        for (double passband : { 0.8, 0.9 })
+        {
+            for (double attenuation_db : { 60.0, 90.0, 120.0 })
+            {
+                const auto coeffs = design (passband, attenuation_db);
+                CAPTURE (passband, attenuation_db, coeffs.size());
+                for (auto c : coeffs)
+                    REQUIRE ((c > 0.0f && c < 1.0f));
+
+                // the interpolator's impulse response, which is the filter's response at the higher sample rate
+                static constexpr int n_samples_in = 4096;
+                IIR_Halfband_Filter filter { coeffs, 1, n_samples_in };
+                std::vector<float> x (n_samples_in);
+                x[0] = 1.0f;
+                std::vector<float> h (2 * n_samples_in);
+                const float* in = x.data();
+                float* out = h.data();
+                pfir::iir_halfband_process_interpolate (filter.state, &in, &out, 1, n_samples_in, filter.scratch_data, false);
+
+                // unity gain in the passband (interpolating by 2), and the single-precision coefficients limit the stopband a little
+                for (double frequency = 0.0; frequency <= passband; frequency += 0.01)
+                    REQUIRE (std::abs (get_magnitude_db (h, frequency) - 20.0 * std::log10 (2.0)) < 0.01);
+                for (double frequency = 2.0 - passband; frequency <= 2.0; frequency += 0.01)
+                    REQUIRE (get_magnitude_db (h, frequency) - 20.0 * std::log10 (2.0) < -std::min (attenuation_db, 110.0) + 3.0);
+            }
+        }
+    }
+
+    SECTION ("Kernels match the reference")
+    {
+        static constexpr int n_channels = 11;
+        static constexpr int max_samples_in = 300;
+        const auto coeffs = design (0.85, 100.0);
+
+        std::mt19937 rng { 0x11b };
+        const auto x = make_random_buffer (n_channels, 2 * max_samples_in * 3, rng);
+
+        for (bool use_avx : { false, true })
+        {
+#if ! (defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64))
+            if (use_avx)
+                continue;
+#endif
+            CAPTURE (use_avx);
+
+            IIR_Halfband_Filter filter { coeffs, n_channels, max_samples_in };
+            std::vector<Reference_IIR_Halfband> interp_reference (n_channels, Reference_IIR_Halfband { coeffs });
+            std::vector<Reference_IIR_Halfband> decim_reference (n_channels, Reference_IIR_Halfband { coeffs });
+
+            // uneven block sizes, to check that the state carries over between blocks
+            int offset = 0;
+            for (int block_size : { 300, 17, 1, 128, 254, 100 })
+            {
+                auto interp_out = make_buffer (n_channels, 2 * block_size);
+                auto decim_out = make_buffer (n_channels, block_size);
+                std::vector<const float*> interp_in_ptrs, decim_in_ptrs;
+                std::vector<float*> interp_out_ptrs, decim_out_ptrs;
+                for (int ch = 0; ch < n_channels; ++ch)
+                {
+                    interp_in_ptrs.push_back (x[(size_t) ch].data() + offset);
+                    interp_out_ptrs.push_back (interp_out[(size_t) ch].data());
+                    decim_in_ptrs.push_back (x[(size_t) ch].data() + 2 * offset);
+                    decim_out_ptrs.push_back (decim_out[(size_t) ch].data());
+                }
+
+                pfir::iir_halfband_process_interpolate (filter.state, interp_in_ptrs.data(), interp_out_ptrs.data(), n_channels, block_size, filter.scratch_data, use_avx);
+                pfir::iir_halfband_process_decimate (filter.state, decim_in_ptrs.data(), decim_out_ptrs.data(), n_channels, 2 * block_size, filter.scratch_data, use_avx);
+
+                std::vector<float> y_ref (2 * (size_t) block_size);
+                for (int ch = 0; ch < n_channels; ++ch)
+                {
+                    CAPTURE (block_size, ch);
+                    interp_reference[(size_t) ch].interpolate (interp_in_ptrs[(size_t) ch], y_ref.data(), block_size);
+                    for (int n = 0; n < 2 * block_size; ++n)
+                        REQUIRE (interp_out[(size_t) ch][(size_t) n] == Catch::Approx { y_ref[(size_t) n] }.margin (1.0e-5));
+
+                    decim_reference[(size_t) ch].decimate (decim_in_ptrs[(size_t) ch], y_ref.data(), block_size);
+                    for (int n = 0; n < block_size; ++n)
+                        REQUIRE (decim_out[(size_t) ch][(size_t) n] == Catch::Approx { y_ref[(size_t) n] }.margin (1.0e-5));
+                }
+                offset += block_size;
+            }
+        }
+    }
+
+    SECTION ("Reset")
+    {
+        const auto coeffs = design (0.9, 80.0);
+        IIR_Halfband_Filter filter { coeffs, 3, 64 };
+        std::vector<float> x (64, 1.0f), y_first (128), y_second (128);
+        const float* in[] = { x.data(), x.data(), x.data() };
+        float* out_first[] = { y_first.data(), y_first.data(), y_first.data() };
+        float* out_second[] = { y_second.data(), y_second.data(), y_second.data() };
+
+        pfir::iir_halfband_process_interpolate (filter.state, in, out_first, 3, 64, filter.scratch_data, false);
+        pfir::iir_halfband_reset (filter.state);
+        pfir::iir_halfband_process_interpolate (filter.state, in, out_second, 3, 64, filter.scratch_data, false);
+        REQUIRE (y_first == y_second);
+    }
+}
@@ -0,0 +1,77 @@
+#include <chowdsp_filters/chowdsp_filters.h>
+#include <chowdsp_polyphase_fir.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace pfir = chowdsp::polyphase_fir;
+
+TEST_CASE ("Instrumentation")
+{
+    static constexpr int n_channels = 2;
+    static constexpr int n_taps = 32;
+    static constexpr int factor = 2;
+    static constexpr int block_size = 256;
+    static constexpr int n_blocks = 200;
+    static constexpr int alignment = 16;
+
+    for (int flags : { (int) pfir::FIR_Flags_None, (int) pfir::FIR_Flag_Per_Channel_Coeffs })
+    {
+        const auto persistent_bytes = pfir::persistent_bytes_required_with_flags (n_channels, n_taps, factor, block_size, flags, alignment);
+        const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, block_size, alignment);
+        chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+        auto* state = pfir::init_with_flags (n_channels, n_taps, factor, block_size, flags, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+        float coeffs[n_taps] {};
+        coeffs[0] = 1.0f;
+        pfir::load_coeffs (state, coeffs, n_taps);
+        auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+        chowdsp::Buffer<float> buffer { n_channels, block_size * factor };
+        chowdsp::Buffer<float> buffer_up { n_channels, block_size * factor };
+
+        // read the counters from another thread while processing, as a monitoring thread would
+        std::atomic_bool done { false };
+        bool counters_monotonic = true;
+        std::thread reader { [&]
+                             {
+                                 pfir::Polyphase_FIR_Stats previous {};
+                                 while (! done.load())
+                                 {
+                                     pfir::Polyphase_FIR_Stats stats {};
+                                     pfir::get_stats (state, &stats);
+                                     counters_monotonic &= stats.calls >= previous.calls && stats.samples_in >= previous.samples_in;
+                                     previous = stats;
+                                 }
+                             } };
+
+        for (int i = 0; i < n_blocks; ++i)
+        {
+            pfir::process_interpolate (state, buffer.getArrayOfReadPointers(), buffer_up.getArrayOfWritePointers(), n_channels, block_size, scratch_data, false);
+            pfir::process_decimate (state, buffer_up.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), n_channels, block_size * factor, scratch_data, false);
+        }
+        done = true;
+        reader.join();
+        REQUIRE (counters_monotonic);
+
+        pfir::Polyphase_FIR_Stats stats {};
+        if (pfir::get_stats (state, &stats))
+        {
+            REQUIRE (stats.calls == 2 * n_blocks);
+            REQUIRE (stats.samples_in == (unsigned long long) n_blocks * (block_size + block_size * factor));
+            REQUIRE (stats.cycles[pfir::FIR_Stage_Kernel] > 0);
+            REQUIRE (stats.cycles[pfir::FIR_Stage_Kernel] > stats.cycles[pfir::FIR_Stage_History_Save]);
+
+            pfir::reset_stats (state);
+            pfir::get_stats (state, &stats);
+            REQUIRE (stats.calls == 0);
+        }
+        else
+        {
+            // without instrumentation, the counters should always read zero
+            REQUIRE (stats.calls == 0);
+            REQUIRE (stats.cycles[pfir::FIR_Stage_Kernel] == 0);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr double pi = 3.14159265358979323846;
+constexpr int factor = 4;
+constexpr int n_taps = 255;
+constexpr double attenuation_db = 100.0;
+constexpr int max_block_size = 512;
+
+std::vector<float> design_sharp_lowpass()
+{
+    std::vector<float> coeffs (n_taps);
+    pfir::design_kaiser_lowpass ({ .n_taps = n_taps, .factor = factor, .passband = 0.6, .stopband_attenuation_db = attenuation_db, .gain = (double) factor }, coeffs.data());
+    return coeffs;
+}
+
+double get_magnitude_db (const std::vector<float>& coeffs, double omega)
+{
+    double real = 0.0, imag = 0.0;
+    for (size_t n = 0; n < coeffs.size(); ++n)
+    {
+        real += (double) coeffs[n] * std::cos (omega * (double) n);
+        imag -= (double) coeffs[n] * std::sin (omega * (double) n);
+    }
+    return 10.0 * std::log10 (real * real + imag * imag);
+}
+
+Filter_Spec get_spec (int n_channels, int flags)
+{
+    return { .n_channels = n_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_block_size, .flags = flags };
+}
+
+/** Measures the group delay at DC from the filter's impulse response, in output samples */
+double measure_interpolation_latency (Filter& filter)
+{
+    std::vector<float> x (max_block_size);
+    x[0] = 1.0f;
+    std::vector<float> y (x.size() * factor);
+    const float* in = x.data();
+    float* out = y.data();
+    pfir::process_interpolate (filter.state, &in, &out, 1, (int) x.size(), filter.scratch_data, false);
+
+    double sum = 0.0, moment = 0.0;
+    for (size_t n = 0; n < y.size(); ++n)
+    {
+        sum += (double) y[n];
+        moment += (double) n * (double) y[n];
+    }
+    return moment / sum;
+}
+
+/** Measures the group delay at DC from the filter's response to a ramp, in input samples */
+double measure_decimation_latency (Filter& filter, double dc_gain)
+{
+    std::vector<float> x (max_block_size * factor);
+    for (size_t n = 0; n < x.size(); ++n)
+        x[n] = (float) n / (float) x.size();
+    std::vector<float> y (max_block_size);
+    const float* in = x.data();
+    float* out = y.data();
+    pfir::process_decimate (filter.state, &in, &out, 1, (int) x.size(), filter.scratch_data, false);
+
+    // once the filter has warmed up, y[m] = dc_gain * (m * factor - latency) / x.size()
+    const auto m = (int) y.size() - 1;
+    return (double) (m * factor) - (double) y[(size_t) m] * (double) x.size() / dc_gain;
+}
+} // namespace
+
+TEST_CASE ("Latency and Minimum Phase")
+{
+    const auto coeffs = design_sharp_lowpass();
+
+    SECTION ("Linear-phase latency")
+    {
+        Filter filter { get_spec (1, pfir::FIR_Flags_None), coeffs };
+        pfir::Polyphase_FIR_Latency interp_latency {};
+        pfir::get_latency (filter.state, 0, false, &interp_latency);
+        REQUIRE (interp_latency.output_samples == Catch::Approx { 0.5 * (n_taps - 1) }.margin (1.0e-4));
+        REQUIRE (interp_latency.input_samples == Catch::Approx { 0.5 * (n_taps - 1) / factor }.margin (1.0e-4));
+        REQUIRE (measure_interpolation_latency (filter) == Catch::Approx { interp_latency.output_samples }.margin (1.0e-3));
+
+        pfir::Polyphase_FIR_Latency decim_latency {};
+        pfir::get_latency (filter.state, 0, true, &decim_latency);
+        REQUIRE (decim_latency.input_samples == Catch::Approx { 0.5 * (n_taps - 1) }.margin (1.0e-4));
+        REQUIRE (decim_latency.output_samples == Catch::Approx { 0.5 * (n_taps - 1) / factor }.margin (1.0e-4));
+        REQUIRE (measure_decimation_latency (filter, (double) factor) == Catch::Approx { decim_latency.input_samples }.margin (1.0e-2));
+
+        // the other coefficient layouts should report the same latency
+        for (int flags : { (int) pfir::FIR_Flag_Per_Channel_Coeffs, (int) pfir::FIR_Flag_Coeffs_F16, (int) pfir::FIR_Flag_Coeffs_BF16 })
+        {
+            Filter other_filter { get_spec (6, flags), coeffs };
+            for (int ch = 0; ch < 6; ++ch)
+            {
+                pfir::Polyphase_FIR_Latency latency {};
+                pfir::get_latency (other_filter.state, ch, false, &latency);
+                CAPTURE (flags, ch);
+                REQUIRE (latency.output_samples == Catch::Approx { interp_latency.output_samples }.margin (0.05));
+            }
+        }
+
+        // with complex samples, each tap takes 2 floats
+        {
+            Filter complex_filter { get_spec (2, pfir::FIR_Flag_Complex_Samples), coeffs };
+            pfir::Polyphase_FIR_Latency latency {};
+            pfir::get_latency (complex_filter.state, 1, true, &latency);
+            REQUIRE (latency.input_samples == Catch::Approx { decim_latency.input_samples }.margin (1.0e-4));
+            REQUIRE (latency.output_samples == Catch::Approx { decim_latency.output_samples }.margin (1.0e-4));
+        }
+        {
+            std::vector<float> complex_coeffs (2 * n_taps);
+            for (int n = 0; n < n_taps; ++n)
+                complex_coeffs[(size_t) (2 * n)] = coeffs[(size_t) n];
+
+            Filter complex_filter { get_spec (2, pfir::FIR_Flag_Complex_Coeffs) };
+            pfir::load_coeffs_complex (complex_filter.state, complex_coeffs.data(), n_taps);
+            pfir::Polyphase_FIR_Latency latency {};
+            pfir::get_latency (complex_filter.state, 0, false, &latency);
+            REQUIRE (latency.output_samples == Catch::Approx { interp_latency.output_samples }.margin (1.0e-4));
+            REQUIRE (latency.input_samples == Catch::Approx { interp_latency.input_samples }.margin (1.0e-4));
+        }
+    }
+
+    SECTION ("Minimum phase")
+    {
+        std::vector<float> min_phase_coeffs (n_taps);
+        std::vector<std::byte> scratch (pfir::minimum_phase_scratch_bytes_required (n_taps));
+        pfir::make_minimum_phase (coeffs.data(), min_phase_coeffs.data(), n_taps, scratch.data());
+
+        // same magnitude response
+        for (double omega = 0.0; omega < pi; omega += 0.005)
+        {
+            const auto linear_phase_db = get_magnitude_db (coeffs, omega);
+            const auto min_phase_db = get_magnitude_db (min_phase_coeffs, omega);
+            CAPTURE (omega, linear_phase_db, min_phase_db);
+            if (linear_phase_db > -60.0)
+                REQUIRE (min_phase_db == Catch::Approx { linear_phase_db }.margin (0.01));
+            else
+                REQUIRE (min_phase_db < std::max (linear_phase_db, -attenuation_db) + 3.0);
+        }
+
+        // with the energy packed towards the start of the filter
+        double linear_phase_energy = 0.0, min_phase_energy = 0.0;
+        for (int n = 0; n < n_taps; ++n)
+        {
+            linear_phase_energy += (double) coeffs[(size_t) n] * (double) coeffs[(size_t) n];
+            min_phase_energy += (double) min_phase_coeffs[(size_t) n] * (double) min_phase_coeffs[(size_t) n];
+            REQUIRE (min_phase_energy >= linear_phase_energy * (1.0 - 1.0e-5));
+        }
+
+        Filter filter { get_spec (1, pfir::FIR_Flags_None), min_phase_coeffs };
+        pfir::Polyphase_FIR_Latency latency {};
+        pfir::get_latency (filter.state, 0, false, &latency);
+        REQUIRE (latency.output_samples < 0.25 * (n_taps - 1) / 2);
+        REQUIRE (measure_interpolation_latency (filter) == Catch::Approx { latency.output_samples }.margin (1.0e-3));
+        WARN ("Minimum-phase latency: " << latency.output_samples << " output samples (vs. " << 0.5 * (n_taps - 1) << " for linear-phase)");
+    }
+}
@@ -0,0 +1,183 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr int n_channels = 3;
+constexpr int factor = 3;
+constexpr int n_taps = 61;
+constexpr int max_samples_in = 200;
+
+struct PCM_Test_Filter : Filter
+{
+    PCM_Test_Filter()
+        : Filter { { .n_channels = n_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_samples_in, .pcm_scratch = true },
+                   design_lowpass (n_taps, factor, (double) factor) }
+    {
+    }
+};
+
+int get_bytes_per_sample (pfir::Polyphase_FIR_PCM_Format format)
+{
+    return format == pfir::FIR_PCM_Int16 ? 2 : (format == pfir::FIR_PCM_Int24 ? 3 : 4);
+}
+
+double get_full_scale (pfir::Polyphase_FIR_PCM_Format format)
+{
+    return format == pfir::FIR_PCM_Int16 ? 32768.0 : (format == pfir::FIR_PCM_Int24 ? 8388608.0 : 2147483648.0);
+}
+
+int32_t read_pcm (const std::vector<uint8_t>& data, pfir::Polyphase_FIR_PCM_Format format, int index)
+{
+    const auto* bytes = data.data() + index * get_bytes_per_sample (format);
+    if (format == pfir::FIR_PCM_Int16)
+        return (int16_t) (bytes[0] | (bytes[1] << 8));
+    if (format == pfir::FIR_PCM_Int24)
+        return (int32_t) (((uint32_t) bytes[0] << 8) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 24)) >> 8;
+    return (int32_t) ((uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24));
+}
+
+void write_pcm (std::vector<uint8_t>& data, pfir::Polyphase_FIR_PCM_Format format, int index, int32_t value)
+{
+    auto* bytes = data.data() + index * get_bytes_per_sample (format);
+    for (int i = 0; i < get_bytes_per_sample (format); ++i)
+        bytes[i] = (uint8_t) ((uint32_t) value >> (8 * i));
+}
+
+/** The expected (undithered) conversion, done in double precision */
+int32_t float_to_pcm (float x, pfir::Polyphase_FIR_PCM_Format format)
+{
+    const auto full_scale = get_full_scale (format);
+    const auto max_value = format == pfir::FIR_PCM_Int32 ? 2147483520.0 : full_scale - 1.0;
+    return (int32_t) std::nearbyint (std::min (std::max ((double) (x * (float) full_scale), -full_scale), max_value));
+}
+
+std::vector<bool> get_isas()
+{
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    return { false, true };
+#else
+    return { false };
+#endif
+}
+
+/** Decimating from PCM should match decimating the same samples converted to float */
+void check_decimation (pfir::Polyphase_FIR_PCM_Format format, bool use_avx, std::mt19937& rng)
+{
+    PCM_Test_Filter pcm_filter, float_filter;
+    std::uniform_int_distribution<int32_t> dist { format == pfir::FIR_PCM_Int16 ? -32768 : (format == pfir::FIR_PCM_Int24 ? -8388608 : INT32_MIN),
+                                                  format == pfir::FIR_PCM_Int16 ? 32767 : (format == pfir::FIR_PCM_Int24 ? 8388607 : INT32_MAX) };
+
+    for (int block_size : get_block_sizes (max_samples_in))
+    {
+        const auto n_samples_in = block_size * factor;
+        std::vector<uint8_t> pcm ((size_t) (n_samples_in * n_channels * get_bytes_per_sample (format)));
+        auto x = make_buffer (n_channels, n_samples_in);
+        for (int n = 0; n < n_samples_in; ++n)
+        {
+            for (int ch = 0; ch < n_channels; ++ch)
+            {
+                const auto value = dist (rng);
+                write_pcm (pcm, format, n * n_channels + ch, value);
+                x[(size_t) ch][(size_t) n] = (float) ((double) value / get_full_scale (format));
+            }
+        }
+
+        auto y_pcm = make_buffer (n_channels, block_size);
+        auto y_float = make_buffer (n_channels, block_size);
+        const auto x_ptrs = get_input_pointers (x);
+        const auto y_pcm_ptrs = get_output_pointers (y_pcm);
+        const auto y_float_ptrs = get_output_pointers (y_float);
+
+        pfir::process_decimate_pcm (pcm_filter.state, pcm.data(), format, y_pcm_ptrs.data(), n_channels, n_samples_in, pcm_filter.scratch_data, use_avx);
+        pfir::process_decimate (float_filter.state, x_ptrs.data(), y_float_ptrs.data(), n_channels, n_samples_in, float_filter.scratch_data, use_avx);
+        for (int ch = 0; ch < n_channels; ++ch)
+            REQUIRE (y_pcm[(size_t) ch] == y_float[(size_t) ch]);
+    }
+}
+
+/** Interpolating to PCM should match interpolating to float and then converting */
+void check_interpolation (pfir::Polyphase_FIR_PCM_Format format, bool use_avx, std::mt19937& rng)
+{
+    PCM_Test_Filter pcm_filter, float_filter;
+    std::uniform_real_distribution<float> dist { -1.5f, 1.5f }; // some of the output will clip
+
+    for (int block_size : get_block_sizes (max_samples_in))
+    {
+        const auto n_samples_out = block_size * factor;
+        auto x = make_buffer (n_channels, block_size);
+        for (auto& channel : x)
+            for (auto& sample : channel)
+                sample = dist (rng);
+
+        auto y_float = make_buffer (n_channels, n_samples_out);
+        const auto x_ptrs = get_input_pointers (x);
+        const auto y_float_ptrs = get_output_pointers (y_float);
+
+        std::vector<uint8_t> pcm ((size_t) (n_samples_out * n_channels * get_bytes_per_sample (format)));
+        pfir::process_interpolate_pcm (pcm_filter.state, x_ptrs.data(), pcm.data(), format, false, n_channels, block_size, pcm_filter.scratch_data, use_avx);
+        pfir::process_interpolate (float_filter.state, x_ptrs.data(), y_float_ptrs.data(), n_channels, block_size, float_filter.scratch_data, use_avx);
+
+        for (int n = 0; n < n_samples_out; ++n)
+        {
+            for (int ch = 0; ch < n_channels; ++ch)
+            {
+                CAPTURE (block_size, n, ch);
+                REQUIRE (read_pcm (pcm, format, n * n_channels + ch) == float_to_pcm (y_float[(size_t) ch][(size_t) n], format));
+            }
+        }
+    }
+}
+
+void check_dither (pfir::Polyphase_FIR_PCM_Format format, bool use_avx, std::mt19937& rng)
+{
+    PCM_Test_Filter dithered_filter, undithered_filter;
+    std::uniform_real_distribution<float> dist { -0.5f, 0.5f };
+    std::vector<float> x (max_samples_in);
+    for (auto& sample : x)
+        sample = dist (rng);
+    const std::vector<const float*> x_ptrs (n_channels, x.data());
+
+    const auto n_samples = max_samples_in * factor * n_channels;
+    std::vector<uint8_t> dithered ((size_t) (n_samples * get_bytes_per_sample (format)));
+    std::vector<uint8_t> undithered (dithered.size());
+    pfir::process_interpolate_pcm (dithered_filter.state, x_ptrs.data(), dithered.data(), format, true, n_channels, max_samples_in, dithered_filter.scratch_data, use_avx);
+    pfir::process_interpolate_pcm (undithered_filter.state, x_ptrs.data(), undithered.data(), format, false, n_channels, max_samples_in, undithered_filter.scratch_data, use_avx);
+
+    // TPDF dither of +/-1 LSB moves each sample by at most 2 LSBs, and shouldn't add any offset
+    double error_sum = 0.0;
+    int n_changed = 0;
+    for (int n = 0; n < n_samples; ++n)
+    {
+        const auto error = (double) read_pcm (dithered, format, n) - (double) read_pcm (undithered, format, n);
+        REQUIRE (std::abs (error) <= 2.0);
+        error_sum += error;
+        n_changed += error != 0.0 ? 1 : 0;
+    }
+    REQUIRE (n_changed > n_samples / 4);
+    REQUIRE (std::abs (error_sum / n_samples) < 0.05);
+}
+} // namespace
+
+TEST_CASE ("PCM Conversion")
+{
+    std::mt19937 rng { 0x5eed };
+    for (auto format : { pfir::FIR_PCM_Int16, pfir::FIR_PCM_Int24, pfir::FIR_PCM_Int32 })
+    {
+        for (bool use_avx : get_isas())
+        {
+            CAPTURE (format, use_avx);
+            check_decimation (format, use_avx, rng);
+            check_interpolation (format, use_avx, rng);
+            if (format != pfir::FIR_PCM_Int32) // the float output is less precise than 1 LSB of int32
+                check_dither (format, use_avx, rng);
+        }
+    }
+}
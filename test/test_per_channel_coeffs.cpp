@@ -0,0 +1,114 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+/** Compares a filter with per-channel coefficients against one single-channel filter per channel. */
+static void test_per_channel_coeffs (int factor, int n_channels, bool decimate, bool use_avx)
+{
+    static constexpr int n_taps = 29;
+    static constexpr int n_samples = 160;
+    const int block_sizes[] = { 33, 1, 64, 62 };
+    static constexpr int max_block_size = 64;
+
+    std::mt19937 rng { 0x2468 + (unsigned) factor * 16 + (unsigned) n_channels };
+    std::vector<std::vector<float>> coeffs;
+    for (int ch = 0; ch < n_channels; ++ch)
+        coeffs.push_back (make_random_vector (ch == 1 ? n_taps - 9 : n_taps, rng)); // channels may use fewer taps
+
+    const auto n_in = decimate ? n_samples * factor : n_samples;
+    const auto n_out = decimate ? n_samples : n_samples * factor;
+    const auto in_factor = decimate ? factor : 1;
+    const auto out_factor = decimate ? 1 : factor;
+    chowdsp::Buffer<float> buffer_in { n_channels, n_in };
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        const auto x = make_random_vector (n_in, rng);
+        std::copy (x.begin(), x.end(), buffer_in.getWritePointer (ch));
+    }
+
+    const auto alignment = use_avx ? 32 : 16;
+
+    // reference: one filter per channel
+    chowdsp::Buffer<float> ref_buffer_out { n_channels, n_out };
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        const auto persistent_bytes = pfir::persistent_bytes_required (1, n_taps, factor, n_samples, alignment);
+        const auto ref_scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, n_samples, alignment);
+        chowdsp::ArenaAllocator<> arena { persistent_bytes + ref_scratch_bytes + alignment };
+        auto* state = pfir::init (1, n_taps, factor, n_samples, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+        pfir::load_coeffs (state, coeffs[(size_t) ch].data(), (int) coeffs[(size_t) ch].size());
+        const auto* in_data = buffer_in.getReadPointer (ch);
+        auto* out_data = ref_buffer_out.getWritePointer (ch);
+        auto* scratch_data = arena.allocate_bytes (ref_scratch_bytes, alignment);
+        if (decimate)
+            pfir::process_decimate (state, &in_data, &out_data, 1, n_in, scratch_data, use_avx);
+        else
+            pfir::process_interpolate (state, &in_data, &out_data, 1, n_in, scratch_data, use_avx);
+    }
+
+    const auto scratch_bytes = pfir::scratch_bytes_required (n_taps, factor, max_block_size, alignment);
+    const auto persistent_bytes = pfir::persistent_bytes_required_with_flags (n_channels, n_taps, factor, max_block_size, pfir::FIR_Flag_Per_Channel_Coeffs, alignment);
+    chowdsp::ArenaAllocator<> arena { persistent_bytes + scratch_bytes + alignment };
+    auto* state = pfir::init_with_flags (n_channels,
+                                         n_taps,
+                                         factor,
+                                         max_block_size,
+                                         pfir::FIR_Flag_Per_Channel_Coeffs,
+                                         arena.allocate_bytes (persistent_bytes, alignment),
+                                         alignment);
+    for (int ch = 0; ch < n_channels; ++ch)
+        pfir::load_coeffs_channel (state, ch, coeffs[(size_t) ch].data(), (int) coeffs[(size_t) ch].size());
+    auto* scratch_data = arena.allocate_bytes (scratch_bytes, alignment);
+
+    chowdsp::Buffer<float> test_buffer_out { n_channels, n_out };
+    int sample = 0;
+    for (auto block_size : block_sizes)
+    {
+        auto block_in = chowdsp::BufferView { buffer_in, sample * in_factor, block_size * in_factor };
+        auto block_out = chowdsp::BufferView { test_buffer_out, sample * out_factor, block_size * out_factor };
+        if (decimate)
+            pfir::process_decimate (state, block_in.getArrayOfReadPointers(), block_out.getArrayOfWritePointers(), n_channels, block_size * factor, scratch_data, use_avx);
+        else
+            pfir::process_interpolate (state, block_in.getArrayOfReadPointers(), block_out.getArrayOfWritePointers(), n_channels, block_size, scratch_data, use_avx);
+        sample += block_size;
+    }
+    REQUIRE (sample == n_samples);
+
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        for (int n = 0; n < n_out; ++n)
+        {
+            CAPTURE (factor, n_channels, use_avx, ch, n);
+            REQUIRE (test_buffer_out.getReadPointer (ch)[n] == Catch::Approx { ref_buffer_out.getReadPointer (ch)[n] }.margin (1.0e-5));
+        }
+    }
+}
+
+TEST_CASE ("Per-Channel Coefficients")
+{
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    const bool use_avx[] = { false, true };
+#else
+    const bool use_avx[] = { false };
+#endif
+
+    SECTION ("Interpolation")
+    {
+        for (auto avx : use_avx)
+            for (int n_channels : { 1, 3, 4, 6 })
+                for (int factor : { 2, 3 })
+                    test_per_channel_coeffs (factor, n_channels, false, avx);
+    }
+
+    SECTION ("Decimation")
+    {
+        for (auto avx : use_avx)
+            for (int n_channels : { 1, 3, 4, 6 })
+                for (int factor : { 2, 3 })
+                    test_per_channel_coeffs (factor, n_channels, true, avx);
+    }
+}
@@ -0,0 +1,158 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr int alignment = 32;
+constexpr int n_channels = 5;
+constexpr int max_factor = 8;
+constexpr int max_n_taps = 191;
+constexpr int block_size = 64;
+
+int get_n_taps (int factor)
+{
+    return factor == 1 ? 17 : 24 * factor - 1;
+}
+
+std::vector<float> design (int factor)
+{
+    return design_lowpass (get_n_taps (factor), std::max (factor, 2), (double) factor);
+}
+
+struct Set_Factor_Filter : Filter
+{
+    /** A filter for a single factor */
+    Set_Factor_Filter (int factor, int flags)
+        : Filter { { .n_channels = n_channels, .n_taps = get_n_taps (factor), .factor = factor, .max_samples_in = block_size, .flags = flags }, design (factor) }
+    {
+    }
+
+    /** A filter that can switch between every factor */
+    explicit Set_Factor_Filter (int flags)
+        : Filter { { .n_channels = n_channels, .n_taps = max_n_taps, .factor = max_factor, .max_samples_in = block_size, .flags = flags, .switchable_factor = true } }
+    {
+    }
+
+    void interpolate (const Buffer& x, Buffer& y)
+    {
+        pfir::process_interpolate (state, get_input_pointers (x).data(), get_output_pointers (y).data(), n_channels, (int) x[0].size(), scratch_data, false);
+    }
+
+    void decimate (const Buffer& x, Buffer& y)
+    {
+        pfir::process_decimate (state, get_input_pointers (x).data(), get_output_pointers (y).data(), n_channels, (int) y[0].size() * state->factor, scratch_data, false);
+    }
+};
+
+/**
+ * Switches the filter to a new factor, and checks it against a filter made for that factor. The reference
+ * interpolator is primed with the part of the previous input that the switched filter should have kept.
+ */
+void check_switch (Set_Factor_Filter& filter, int factor, int flags, const Buffer& previous_x, std::mt19937& rng)
+{
+    const auto old_taps_per_filter_padded = filter.state->taps_per_filter_padded;
+    pfir::set_factor (filter.state, factor, get_n_taps (factor));
+    pfir::load_coeffs (filter.state, design (factor).data(), get_n_taps (factor));
+
+    Set_Factor_Filter reference { factor, flags };
+    REQUIRE (filter.state->taps_per_filter_padded == reference.state->taps_per_filter_padded);
+    REQUIRE (filter.state->state_per_filter_padded == reference.state->state_per_filter_padded);
+
+    const auto samples_kept = std::min (old_taps_per_filter_padded, filter.state->taps_per_filter_padded) - 1;
+    auto primer = previous_x;
+    for (auto& channel : primer)
+        std::fill (channel.begin(), channel.end() - samples_kept, 0.0f);
+    auto primer_out = make_buffer (n_channels, block_size * factor);
+    reference.interpolate (primer, primer_out);
+
+    for (int block = 0; block < 3; ++block)
+    {
+        CAPTURE (factor, flags, block);
+        const auto x = make_random_buffer (n_channels, block_size, rng);
+
+        auto test_out = make_buffer (n_channels, block_size * factor);
+        auto ref_out = make_buffer (n_channels, block_size * factor);
+        filter.interpolate (x, test_out);
+        reference.interpolate (x, ref_out);
+        REQUIRE (test_out == ref_out);
+
+        test_out = make_buffer (n_channels, block_size / factor);
+        ref_out = make_buffer (n_channels, block_size / factor);
+        filter.decimate (x, test_out);
+        reference.decimate (x, ref_out);
+        REQUIRE (test_out == ref_out);
+    }
+}
+} // namespace
+
+TEST_CASE ("Set Factor")
+{
+    std::mt19937 rng { 0xfac };
+    for (int flags : { (int) pfir::FIR_Flags_None, (int) pfir::FIR_Flag_Per_Channel_Coeffs })
+    {
+        Set_Factor_Filter filter { flags };
+        for (int factor : { 1, 2, 4, 8 })
+            REQUIRE (pfir::persistent_bytes_required_max_factor (n_channels, max_n_taps, max_factor, block_size, flags, alignment)
+                     >= pfir::persistent_bytes_required_with_flags (n_channels, get_n_taps (factor), factor, block_size, flags, alignment));
+
+        auto previous_x = make_random_buffer (n_channels, block_size, rng);
+        auto y = make_buffer (n_channels, block_size * max_factor);
+        filter.interpolate (previous_x, y);
+
+        for (int factor : { 8, 2, 1, 4, 8, 1, 2 })
+        {
+            check_switch (filter, factor, flags, previous_x, rng);
+
+            // the input that the next switch should keep (some of)
+            previous_x = make_random_buffer (n_channels, block_size, rng);
+            y = make_buffer (n_channels, block_size * factor);
+            filter.interpolate (previous_x, y);
+        }
+    }
+}
+
+TEST_CASE ("Set Factor Silences Every Channel Group")
+{
+    // with per-channel coefficients, each group of 4 channels has its own coefficients, which should all be cleared
+    static constexpr int n_group_channels = 8;
+    static constexpr int flags = pfir::FIR_Flag_Per_Channel_Coeffs;
+    Filter filter { { .n_channels = n_group_channels, .n_taps = max_n_taps, .factor = max_factor, .max_samples_in = block_size, .flags = flags, .switchable_factor = true } };
+    auto* state = filter.state;
+
+    pfir::set_factor (state, 4, get_n_taps (4));
+    const auto coeffs = design (4);
+    for (int ch = 0; ch < n_group_channels; ++ch)
+        pfir::load_coeffs_channel (state, ch, coeffs.data(), get_n_taps (4));
+
+    std::mt19937 rng { 0x5e7 };
+    const auto x = make_random_buffer (n_group_channels, block_size, rng);
+    auto y = make_buffer (n_group_channels, block_size * max_factor);
+    const auto x_ptrs = get_input_pointers (x);
+    const auto y_ptrs = get_output_pointers (y);
+    pfir::process_interpolate (state, x_ptrs.data(), y_ptrs.data(), n_group_channels, block_size, filter.scratch_data, false);
+
+    // no `load_coeffs()` after switching, so every channel should be silent (switching to a smaller factor,
+    // so that the old coefficients of the second group lie beyond the first group's new coefficients)
+    pfir::set_factor (state, 2, get_n_taps (2));
+    pfir::process_interpolate (state, x_ptrs.data(), y_ptrs.data(), n_group_channels, block_size, filter.scratch_data, false);
+    for (int ch = 0; ch < n_group_channels; ++ch)
+    {
+        CAPTURE (ch);
+        for (int n = 0; n < block_size * 2; ++n)
+            REQUIRE (y[(size_t) ch][(size_t) n] == 0.0f);
+    }
+
+    pfir::process_decimate (state, x_ptrs.data(), y_ptrs.data(), n_group_channels, block_size, filter.scratch_data, false);
+    for (int ch = 0; ch < n_group_channels; ++ch)
+    {
+        CAPTURE (ch);
+        for (int n = 0; n < block_size / 2; ++n)
+            REQUIRE (y[(size_t) ch][(size_t) n] == 0.0f);
+    }
+}
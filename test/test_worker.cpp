@@ -0,0 +1,236 @@
+#include "test_helpers.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+namespace pfir = chowdsp::polyphase_fir;
+using namespace test_helpers;
+
+namespace
+{
+constexpr int alignment = 32;
+constexpr int n_channels = 3;
+constexpr int factor = 3;
+constexpr int n_taps = 47;
+constexpr int max_samples_in = 64;
+constexpr int queue_frames = 500;
+constexpr int n_frames_low_rate = 3000;
+
+struct Worker
+{
+    chowdsp::ArenaAllocator<> arena;
+    pfir::Polyphase_FIR_Worker* worker {};
+
+    explicit Worker (pfir::Polyphase_FIR_Worker_Mode mode)
+        : arena { pfir::worker_persistent_bytes_required (n_channels, n_taps, factor, max_samples_in, pfir::FIR_Flags_None, mode, queue_frames, alignment) + alignment }
+    {
+        const auto persistent_bytes = pfir::worker_persistent_bytes_required (n_channels, n_taps, factor, max_samples_in, pfir::FIR_Flags_None, mode, queue_frames, alignment);
+        worker = pfir::worker_init (n_channels, n_taps, factor, max_samples_in, pfir::FIR_Flags_None, mode, queue_frames, false, arena.allocate_bytes (persistent_bytes, alignment), alignment);
+        pfir::load_coeffs (worker->filter, design_lowpass (n_taps, factor, (double) factor).data(), n_taps);
+    }
+};
+
+/** Processes the whole (interleaved) signal with a plain filter, in `max_samples_in` blocks */
+std::vector<float> get_reference (pfir::Polyphase_FIR_Worker_Mode mode, const std::vector<float>& x)
+{
+    Filter filter { { .n_channels = n_channels, .n_taps = n_taps, .factor = factor, .max_samples_in = max_samples_in, .alignment = alignment },
+                    design_lowpass (n_taps, factor, (double) factor) };
+
+    const auto interpolate = mode == pfir::FIR_Worker_Interpolate;
+    const auto block_in = interpolate ? max_samples_in : max_samples_in * factor;
+    const auto block_out = interpolate ? max_samples_in * factor : max_samples_in;
+    const auto n_frames_in = (int) x.size() / n_channels;
+    std::vector<float> y;
+
+    auto x_planar = make_buffer (n_channels, block_in);
+    auto y_planar = make_buffer (n_channels, block_out);
+    const auto x_ptrs = get_input_pointers (x_planar);
+    const auto y_ptrs = get_output_pointers (y_planar);
+
+    for (int offset = 0; offset < n_frames_in; offset += block_in)
+    {
+        const auto n_in = std::min (block_in, n_frames_in - offset);
+        const auto n_out = interpolate ? n_in * factor : n_in / factor;
+        for (int n = 0; n < n_in; ++n)
+            for (int ch = 0; ch < n_channels; ++ch)
+                x_planar[(size_t) ch][(size_t) n] = x[(size_t) ((offset + n) * n_channels + ch)];
+
+        if (interpolate)
+            pfir::process_interpolate (filter.state, x_ptrs.data(), y_ptrs.data(), n_channels, n_in, filter.scratch_data, false);
+        else
+            pfir::process_decimate (filter.state, x_ptrs.data(), y_ptrs.data(), n_channels, n_in, filter.scratch_data, false);
+
+        for (int n = 0; n < n_out; ++n)
+            for (int ch = 0; ch < n_channels; ++ch)
+                y.push_back (y_planar[(size_t) ch][(size_t) n]);
+    }
+    return y;
+}
+
+std::vector<float> get_input (pfir::Polyphase_FIR_Worker_Mode mode)
+{
+    std::mt19937 rng { 0x3a7e };
+    std::uniform_real_distribution<float> dist { -1.0f, 1.0f };
+    std::vector<float> x ((size_t) (n_frames_low_rate * n_channels * (mode == pfir::FIR_Worker_Interpolate ? 1 : factor)));
+    for (auto& sample : x)
+        sample = dist (rng);
+    return x;
+}
+
+/** Pushes and pops the signal in uneven blocks (alternating planar and interleaved), processing on the calling thread */
+void check_synchronous (pfir::Polyphase_FIR_Worker_Mode mode)
+{
+    Worker worker { mode };
+    const auto x = get_input (mode);
+    const auto y_ref = get_reference (mode, x);
+    const auto n_frames_in = (int) x.size() / n_channels;
+
+    std::vector<float> y;
+    auto planar = make_buffer (n_channels, queue_frames * factor);
+    const auto in_ptrs = get_input_pointers (planar);
+    const auto out_ptrs = get_output_pointers (planar);
+
+    static constexpr int block_sizes[] { 1, 37, 200, 5, 128, 400 };
+    int offset = 0;
+    for (int block_idx = 0; offset < n_frames_in; ++block_idx)
+    {
+        const auto block_size = std::min (block_sizes[block_idx % std::size (block_sizes)], n_frames_in - offset);
+        const auto use_planar = block_idx % 2 == 0;
+        if (use_planar)
+        {
+            for (int n = 0; n < block_size; ++n)
+                for (int ch = 0; ch < n_channels; ++ch)
+                    planar[(size_t) ch][(size_t) n] = x[(size_t) ((offset + n) * n_channels + ch)];
+            REQUIRE (pfir::worker_push (worker.worker, in_ptrs.data(), block_size) == block_size);
+        }
+        else
+        {
+            REQUIRE (pfir::worker_push_interleaved (worker.worker, x.data() + offset * n_channels, block_size) == block_size);
+        }
+        offset += block_size;
+
+        pfir::worker_process (worker.worker);
+
+        pfir::Polyphase_FIR_Worker_Stats stats {};
+        pfir::worker_get_stats (worker.worker, &stats);
+        const auto n_out = stats.output_frames_queued;
+        if (use_planar)
+        {
+            REQUIRE (pfir::worker_pop (worker.worker, out_ptrs.data(), n_out) == n_out);
+            for (int n = 0; n < n_out; ++n)
+                for (int ch = 0; ch < n_channels; ++ch)
+                    y.push_back (planar[(size_t) ch][(size_t) n]);
+        }
+        else
+        {
+            y.resize (y.size() + (size_t) (n_out * n_channels));
+            REQUIRE (pfir::worker_pop_interleaved (worker.worker, y.data() + y.size() - (size_t) (n_out * n_channels), n_out) == n_out);
+        }
+    }
+
+    REQUIRE (y.size() == y_ref.size());
+    REQUIRE (y == y_ref);
+
+    pfir::Polyphase_FIR_Worker_Stats stats {};
+    pfir::worker_get_stats (worker.worker, &stats);
+    REQUIRE (stats.overrun_frames == 0);
+    REQUIRE (stats.underrun_frames == 0);
+    REQUIRE (stats.input_frames_queued == 0);
+    REQUIRE (stats.output_frames_queued == 0);
+}
+
+/** Runs the worker on its own thread, while this thread produces the input and consumes the output */
+void check_threaded (pfir::Polyphase_FIR_Worker_Mode mode)
+{
+    Worker worker { mode };
+    const auto x = get_input (mode);
+    const auto y_ref = get_reference (mode, x);
+    const auto n_frames_in = (int) x.size() / n_channels;
+    const auto n_frames_out = (int) y_ref.size() / n_channels;
+
+    std::thread worker_thread { pfir::worker_run, worker.worker };
+
+    std::vector<float> y ((size_t) n_frames_out * n_channels);
+    int n_pushed = 0, n_popped = 0;
+    while (n_popped < n_frames_out)
+    {
+        if (n_pushed < n_frames_in)
+            n_pushed += pfir::worker_push_interleaved (worker.worker, x.data() + n_pushed * n_channels, std::min (97, n_frames_in - n_pushed));
+
+        pfir::Polyphase_FIR_Worker_Stats stats {};
+        pfir::worker_get_stats (worker.worker, &stats);
+        const auto n_out = std::min (stats.output_frames_queued, n_frames_out - n_popped);
+        n_popped += pfir::worker_pop_interleaved (worker.worker, y.data() + n_popped * n_channels, n_out);
+        if (n_out == 0)
+            std::this_thread::yield();
+    }
+
+    pfir::worker_stop (worker.worker);
+    worker_thread.join();
+
+    REQUIRE (y == y_ref);
+
+    pfir::Polyphase_FIR_Worker_Stats stats {};
+    pfir::worker_get_stats (worker.worker, &stats);
+    REQUIRE (stats.underrun_frames == 0);
+    REQUIRE (stats.batches >= (unsigned long long) (n_frames_low_rate / max_samples_in));
+}
+} // namespace
+
+TEST_CASE ("Threaded Worker")
+{
+    SECTION ("Synchronous Interpolation")
+    {
+        check_synchronous (pfir::FIR_Worker_Interpolate);
+    }
+
+    SECTION ("Synchronous Decimation")
+    {
+        check_synchronous (pfir::FIR_Worker_Decimate);
+    }
+
+    SECTION ("Threaded Interpolation")
+    {
+        check_threaded (pfir::FIR_Worker_Interpolate);
+    }
+
+    SECTION ("Threaded Decimation")
+    {
+        check_threaded (pfir::FIR_Worker_Decimate);
+    }
+
+    SECTION ("Overruns and Underruns")
+    {
+        Worker worker { pfir::FIR_Worker_Interpolate };
+        std::vector<float> x ((size_t) (queue_frames + 10) * n_channels, 1.0f);
+        REQUIRE (pfir::worker_push_interleaved (worker.worker, x.data(), queue_frames + 10) == queue_frames);
+
+        pfir::Polyphase_FIR_Worker_Stats stats {};
+        pfir::worker_get_stats (worker.worker, &stats);
+        REQUIRE (stats.overrun_frames == 10);
+        REQUIRE (stats.input_frames_queued == queue_frames);
+        REQUIRE (stats.output_frames_queued == 0);
+
+        // nothing has been processed yet, so the output is all underruns
+        std::vector<float> y ((size_t) 20 * n_channels, 1.0f);
+        REQUIRE (pfir::worker_pop_interleaved (worker.worker, y.data(), 20) == 0);
+        REQUIRE (y == std::vector<float> (y.size(), 0.0f));
+
+        // the output ring holds the same duration as the input ring, so everything can be processed
+        REQUIRE (pfir::worker_process (worker.worker) == queue_frames);
+        pfir::worker_get_stats (worker.worker, &stats);
+        REQUIRE (stats.underrun_frames == 20);
+        REQUIRE (stats.input_frames_queued == 0);
+        REQUIRE (stats.output_frames_queued == queue_frames * factor);
+        REQUIRE (stats.batches == (unsigned long long) ((queue_frames + max_samples_in - 1) / max_samples_in));
+
+        // with the output ring full, the worker can't make progress until the consumer catches up
+        REQUIRE (pfir::worker_push_interleaved (worker.worker, x.data(), 10) == 10);
+        REQUIRE (pfir::worker_process (worker.worker) == 0);
+        REQUIRE (pfir::worker_pop_interleaved (worker.worker, y.data(), 20) == 20);
+        REQUIRE (pfir::worker_process (worker.worker) == 6);
+    }
+}
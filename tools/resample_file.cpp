@@ -0,0 +1,522 @@
+/*
+ * Offline file resampler.
+ *
+ * Since the FIR filters have finite memory, a long file can be split into chunks
+ * that each "warm up" from `taps_per_filter_padded` samples of overlap, and then
+ * run independently, producing exactly the same output as a serial pass.
+ */
+
+#include <chowdsp_polyphase_fir.h>
+#include <chowdsp_polyphase_fir_design.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pfir = chowdsp::polyphase_fir;
+
+namespace
+{
+/** Read-only or read-write memory mapping of a whole file */
+struct Mapped_File
+{
+    std::byte* data {};
+    size_t size {};
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping {};
+#else
+    int fd = -1;
+#endif
+
+    bool open_read (const char* path)
+    {
+#if defined(_WIN32)
+        file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER file_size {};
+        GetFileSizeEx (file, &file_size);
+        size = (size_t) file_size.QuadPart;
+        mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+            return false;
+        data = (std::byte*) MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+        fd = ::open (path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st {};
+        fstat (fd, &st);
+        size = (size_t) st.st_size;
+        auto* ptr = mmap (nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        data = ptr == MAP_FAILED ? nullptr : (std::byte*) ptr;
+        if (data != nullptr)
+            madvise (data, size, MADV_SEQUENTIAL);
+#endif
+        return data != nullptr;
+    }
+
+    bool open_write (const char* path, size_t bytes)
+    {
+        size = bytes;
+#if defined(_WIN32)
+        file = CreateFileA (path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER file_size {};
+        file_size.QuadPart = (LONGLONG) bytes;
+        SetFilePointerEx (file, file_size, nullptr, FILE_BEGIN);
+        SetEndOfFile (file);
+        mapping = CreateFileMappingA (file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (mapping == nullptr)
+            return false;
+        data = (std::byte*) MapViewOfFile (mapping, FILE_MAP_WRITE, 0, 0, 0);
+#else
+        fd = ::open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate (fd, (off_t) bytes) != 0)
+            return false;
+        auto* ptr = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        data = ptr == MAP_FAILED ? nullptr : (std::byte*) ptr;
+#endif
+        return data != nullptr;
+    }
+
+    ~Mapped_File()
+    {
+#if defined(_WIN32)
+        if (data != nullptr)
+            UnmapViewOfFile (data);
+        if (mapping != nullptr)
+            CloseHandle (mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle (file);
+#else
+        if (data != nullptr)
+            munmap (data, size);
+        if (fd >= 0)
+            ::close (fd);
+#endif
+    }
+};
+
+/** Interleaved float32 audio, either from a WAV file or raw */
+struct Audio_View
+{
+    const float* samples {};
+    int n_channels {};
+    int sample_rate {};
+    int64_t n_frames {};
+    bool is_wav {};
+};
+
+uint32_t read_u32 (const std::byte* p)
+{
+    uint32_t x;
+    std::memcpy (&x, p, sizeof (x));
+    return x;
+}
+
+uint16_t read_u16 (const std::byte* p)
+{
+    uint16_t x;
+    std::memcpy (&x, p, sizeof (x));
+    return x;
+}
+
+bool parse_wav (const Mapped_File& file, Audio_View& audio)
+{
+    if (file.size < 12 || std::memcmp (file.data, "RIFF", 4) != 0 || std::memcmp (file.data + 8, "WAVE", 4) != 0)
+        return false;
+
+    bool found_format = false;
+    size_t pos = 12;
+    while (pos + 8 <= file.size)
+    {
+        const auto* chunk = file.data + pos;
+        const auto chunk_size = (size_t) read_u32 (chunk + 4);
+        if (std::memcmp (chunk, "fmt ", 4) == 0)
+        {
+            auto format_tag = read_u16 (chunk + 8);
+            audio.n_channels = (int) read_u16 (chunk + 10);
+            audio.sample_rate = (int) read_u32 (chunk + 12);
+            const auto bits = read_u16 (chunk + 22);
+            if (format_tag == 0xFFFE && chunk_size >= 40) // WAVE_FORMAT_EXTENSIBLE
+                format_tag = read_u16 (chunk + 32);
+            if (format_tag != 3 || bits != 32)
+            {
+                std::fprintf (stderr, "Only 32-bit float WAV files are supported!\n");
+                return false;
+            }
+            found_format = true;
+        }
+        else if (std::memcmp (chunk, "data", 4) == 0 && found_format)
+        {
+            const auto data_bytes = std::min (chunk_size, file.size - pos - 8);
+            audio.samples = reinterpret_cast<const float*> (chunk + 8);
+            audio.n_frames = (int64_t) (data_bytes / (sizeof (float) * (size_t) audio.n_channels));
+            audio.is_wav = true;
+            return true;
+        }
+        pos += 8 + chunk_size + (chunk_size & 1);
+    }
+    return false;
+}
+
+constexpr size_t wav_header_bytes = 44;
+
+void write_wav_header (std::byte* dest, int n_channels, int sample_rate, int64_t n_frames)
+{
+    const auto data_bytes = (uint32_t) ((size_t) n_frames * (size_t) n_channels * sizeof (float));
+    const auto write_u32 = [] (std::byte* p, uint32_t x)
+    { std::memcpy (p, &x, sizeof (x)); };
+    const auto write_u16 = [] (std::byte* p, uint16_t x)
+    { std::memcpy (p, &x, sizeof (x)); };
+
+    std::memcpy (dest, "RIFF", 4);
+    write_u32 (dest + 4, 36 + data_bytes);
+    std::memcpy (dest + 8, "WAVEfmt ", 8);
+    write_u32 (dest + 16, 16);
+    write_u16 (dest + 20, 3); // IEEE float
+    write_u16 (dest + 22, (uint16_t) n_channels);
+    write_u32 (dest + 24, (uint32_t) sample_rate);
+    write_u32 (dest + 28, (uint32_t) (sample_rate * n_channels * (int) sizeof (float)));
+    write_u16 (dest + 32, (uint16_t) (n_channels * (int) sizeof (float)));
+    write_u16 (dest + 34, 32);
+    std::memcpy (dest + 36, "data", 4);
+    write_u32 (dest + 40, data_bytes);
+}
+
+struct Options
+{
+    const char* input_path {};
+    const char* output_path {};
+    bool decimate {};
+    int factor {};
+    int n_channels = 1;
+    int n_taps {};
+    double passband = 0.8;
+    double attenuation_db = 96.0;
+    int n_threads = (int) std::max (1u, std::thread::hardware_concurrency());
+    int64_t chunk_size = 1 << 16;
+    int block_size = 512;
+    bool use_avx {};
+    bool check {};
+    bool minimum_phase {};
+};
+
+struct Job
+{
+    const Options* options {};
+    const float* coeffs {};
+    const float* in {};
+    float* out {};
+    int n_channels {};
+    int64_t n_frames_in {};
+    int64_t chunk_size {};
+    int64_t n_chunks {};
+    std::atomic<int64_t> next_chunk { 0 };
+};
+
+void* allocate_aligned (size_t bytes, int alignment)
+{
+    return ::operator new (bytes, std::align_val_t { (size_t) alignment });
+}
+
+void free_aligned (void* ptr, int alignment)
+{
+    ::operator delete (ptr, std::align_val_t { (size_t) alignment });
+}
+
+/** Pulls chunks off the job until none are left */
+void run_worker (Job& job)
+{
+    const auto& options = *job.options;
+    const auto n_channels = job.n_channels;
+    const auto factor = options.factor;
+    const auto alignment = options.use_avx ? 32 : 16;
+    const auto block_in = options.decimate ? options.block_size * factor : options.block_size;
+    const auto block_out = options.decimate ? options.block_size : options.block_size * factor;
+
+    const auto persistent_bytes = pfir::persistent_bytes_required (n_channels, options.n_taps, factor, options.block_size, alignment);
+    const auto scratch_bytes = pfir::scratch_bytes_required (options.n_taps, factor, options.block_size, alignment);
+    auto* persistent_data = allocate_aligned (persistent_bytes, alignment);
+    auto* scratch_data = allocate_aligned (scratch_bytes, alignment);
+    auto* state = pfir::init (n_channels, options.n_taps, factor, options.block_size, persistent_data, alignment);
+    pfir::load_coeffs (state, job.coeffs, options.n_taps);
+
+    // overlap needed to fully re-build the filter history, in input samples
+    const auto warm_up = (int64_t) state->taps_per_filter_padded * (options.decimate ? factor : 1);
+
+    std::vector<float> planar_in ((size_t) (n_channels * block_in));
+    std::vector<float> planar_out ((size_t) (n_channels * block_out));
+    std::vector<const float*> in_ptrs ((size_t) n_channels);
+    std::vector<float*> out_ptrs ((size_t) n_channels);
+    for (int ch = 0; ch < n_channels; ++ch)
+    {
+        in_ptrs[(size_t) ch] = planar_in.data() + ch * block_in;
+        out_ptrs[(size_t) ch] = planar_out.data() + ch * block_out;
+    }
+
+    const auto process_range = [&] (int64_t start, int64_t end, bool write_output)
+    {
+        for (auto pos = start; pos < end; pos += block_in)
+        {
+            const auto n_in = (int) std::min ((int64_t) block_in, end - pos);
+            for (int ch = 0; ch < n_channels; ++ch)
+                for (int n = 0; n < n_in; ++n)
+                    planar_in[(size_t) (ch * block_in + n)] = job.in[(pos + n) * n_channels + ch];
+
+            int n_out;
+            int64_t out_pos;
+            if (options.decimate)
+            {
+                pfir::process_decimate (state, in_ptrs.data(), out_ptrs.data(), n_channels, n_in, scratch_data, options.use_avx);
+                n_out = n_in / factor;
+                out_pos = pos / factor;
+            }
+            else
+            {
+                pfir::process_interpolate (state, in_ptrs.data(), out_ptrs.data(), n_channels, n_in, scratch_data, options.use_avx);
+                n_out = n_in * factor;
+                out_pos = pos * factor;
+            }
+
+            if (! write_output)
+                continue;
+
+            for (int n = 0; n < n_out; ++n)
+                for (int ch = 0; ch < n_channels; ++ch)
+                    job.out[(out_pos + n) * n_channels + ch] = planar_out[(size_t) (ch * block_out + n)];
+        }
+    };
+
+    for (auto chunk = job.next_chunk++; chunk < job.n_chunks; chunk = job.next_chunk++)
+    {
+        const auto chunk_start = chunk * job.chunk_size;
+        const auto chunk_end = std::min (chunk_start + job.chunk_size, job.n_frames_in);
+
+        pfir::reset (state);
+        process_range (std::max ((int64_t) 0, chunk_start - warm_up), chunk_start, false);
+        process_range (chunk_start, chunk_end, true);
+    }
+
+    free_aligned (scratch_data, alignment);
+    free_aligned (persistent_data, alignment);
+}
+
+void run_job (const Options& options, const float* coeffs, const float* in, float* out, int n_channels, int64_t n_frames_in, int n_threads)
+{
+    Job job;
+    job.options = &options;
+    job.coeffs = coeffs;
+    job.in = in;
+    job.out = out;
+    job.n_channels = n_channels;
+    job.n_frames_in = n_frames_in;
+    job.chunk_size = options.chunk_size;
+    job.n_chunks = (n_frames_in + job.chunk_size - 1) / job.chunk_size;
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n_threads; ++i)
+        threads.emplace_back (run_worker, std::ref (job));
+    run_worker (job);
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void print_usage()
+{
+    std::printf ("Usage: resample_chowdsp_polyphase_fir <input> <output> (--interpolate <factor> | --decimate <factor>) [options]\n"
+                 "\n"
+                 "Inputs may be 32-bit float WAV files, or raw interleaved float32 data.\n"
+                 "\n"
+                 "Options:\n"
+                 "  --channels <n>      Number of channels for raw input (default: 1)\n"
+                 "  --taps <n>          Number of filter taps (default: enough for the stopband to start at the low-rate Nyquist frequency)\n"
+                 "  --passband <f>      Passband edge, relative to the low-rate Nyquist frequency (default: 0.8)\n"
+                 "  --attenuation <dB>  Stopband attenuation (default: 96)\n"
+                 "  --threads <n>       Number of worker threads (default: hardware concurrency)\n"
+                 "  --chunk-size <n>    Input frames per parallel chunk (default: 65536)\n"
+                 "  --block-size <n>    Low-rate frames per processing call (default: 512)\n"
+                 "  --avx               Use the AVX kernels\n"
+                 "  --minimum-phase     Use a minimum-phase filter, for lower latency\n"
+                 "  --check             Also run single-threaded, and verify that the outputs are identical\n");
+}
+
+bool parse_options (int argc, char** argv, Options& options)
+{
+    std::vector<const char*> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const auto next_int = [&]
+        { return i + 1 < argc ? std::atoll (argv[++i]) : 0; };
+        const auto next_double = [&]
+        { return i + 1 < argc ? std::atof (argv[++i]) : 0.0; };
+
+        if (arg == "--interpolate")
+            options.factor = (int) next_int();
+        else if (arg == "--decimate")
+            options.factor = (int) next_int(), options.decimate = true;
+        else if (arg == "--channels")
+            options.n_channels = (int) next_int();
+        else if (arg == "--taps")
+            options.n_taps = (int) next_int();
+        else if (arg == "--passband")
+            options.passband = next_double();
+        else if (arg == "--attenuation")
+            options.attenuation_db = next_double();
+        else if (arg == "--threads")
+            options.n_threads = (int) next_int();
+        else if (arg == "--chunk-size")
+            options.chunk_size = next_int();
+        else if (arg == "--block-size")
+            options.block_size = (int) next_int();
+        else if (arg == "--avx")
+            options.use_avx = true;
+        else if (arg == "--minimum-phase")
+            options.minimum_phase = true;
+        else if (arg == "--check")
+            options.check = true;
+        else if (arg.rfind ("--", 0) == 0)
+            return false;
+        else
+            positional.push_back (argv[i]);
+    }
+
+    if (positional.size() != 2 || options.factor < 1 || options.n_channels < 1 || options.n_threads < 1
+        || options.block_size < 1 || options.chunk_size < 1 || options.passband <= 0.0 || options.passband >= 1.0)
+        return false;
+
+    options.input_path = positional[0];
+    options.output_path = positional[1];
+    if (options.n_taps == 0)
+        options.n_taps = pfir::kaiser_taps_required (options.factor, options.passband, options.attenuation_db);
+    options.n_taps = std::max (options.n_taps, 16);
+    if (options.decimate) // chunks must start on a low-rate sample
+        options.chunk_size = (options.chunk_size + options.factor - 1) / options.factor * options.factor;
+
+#if ! (defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64))
+    options.use_avx = false;
+#endif
+    return true;
+}
+} // namespace
+
+int main (int argc, char** argv)
+{
+    Options options;
+    if (! parse_options (argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    Mapped_File input_file;
+    if (! input_file.open_read (options.input_path))
+    {
+        std::fprintf (stderr, "Unable to open input file: %s\n", options.input_path);
+        return 1;
+    }
+
+    Audio_View audio;
+    if (! parse_wav (input_file, audio))
+    {
+        if (std::memcmp (input_file.data, "RIFF", 4) == 0)
+            return 1;
+        audio.samples = reinterpret_cast<const float*> (input_file.data);
+        audio.n_channels = options.n_channels;
+        audio.n_frames = (int64_t) (input_file.size / (sizeof (float) * (size_t) options.n_channels));
+    }
+
+    auto n_frames_in = audio.n_frames;
+    int64_t n_frames_out;
+    if (options.decimate)
+    {
+        n_frames_in = n_frames_in / options.factor * options.factor; // trailing partial frames are dropped
+        n_frames_out = n_frames_in / options.factor;
+    }
+    else
+    {
+        n_frames_out = n_frames_in * options.factor;
+    }
+
+    const auto header_bytes = audio.is_wav ? wav_header_bytes : 0;
+    const auto output_sample_bytes = (size_t) n_frames_out * (size_t) audio.n_channels * sizeof (float);
+    Mapped_File output_file;
+    if (! output_file.open_write (options.output_path, header_bytes + output_sample_bytes))
+    {
+        std::fprintf (stderr, "Unable to open output file: %s\n", options.output_path);
+        return 1;
+    }
+    if (audio.is_wav)
+    {
+        const auto output_rate = options.decimate ? audio.sample_rate / options.factor : audio.sample_rate * options.factor;
+        write_wav_header (output_file.data, audio.n_channels, output_rate, n_frames_out);
+    }
+    auto* output_samples = reinterpret_cast<float*> (output_file.data + header_bytes);
+
+    std::vector<float> coeffs ((size_t) options.n_taps);
+    pfir::Polyphase_FIR_Design design;
+    design.n_taps = options.n_taps;
+    design.factor = options.factor;
+    design.passband = options.passband;
+    design.stopband_attenuation_db = options.attenuation_db;
+    design.gain = options.decimate ? 1.0 : (double) options.factor;
+    pfir::design_kaiser_lowpass (design, coeffs.data());
+    if (options.minimum_phase)
+    {
+        std::vector<std::byte> scratch (pfir::minimum_phase_scratch_bytes_required (options.n_taps));
+        pfir::make_minimum_phase (coeffs.data(), coeffs.data(), options.n_taps, scratch.data());
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    run_job (options, coeffs.data(), audio.samples, output_samples, audio.n_channels, n_frames_in, options.n_threads);
+    const auto seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+
+    const auto samples_in = (double) n_frames_in * audio.n_channels;
+    const auto samples_out = (double) n_frames_out * audio.n_channels;
+    std::printf ("Processed %lld frames x %d channels with %d threads in %.3f seconds\n",
+                 (long long) n_frames_in,
+                 audio.n_channels,
+                 options.n_threads,
+                 seconds);
+    std::printf ("Throughput: %.3e input samples/sec, %.3e output samples/sec\n",
+                 samples_in / seconds,
+                 samples_out / seconds);
+
+    if (options.check)
+    {
+        std::vector<float> serial_out ((size_t) n_frames_out * (size_t) audio.n_channels);
+        auto serial_options = options;
+        serial_options.chunk_size = std::max (n_frames_in, (int64_t) 1);
+        run_job (serial_options, coeffs.data(), audio.samples, serial_out.data(), audio.n_channels, n_frames_in, 1);
+        if (std::memcmp (serial_out.data(), output_samples, output_sample_bytes) != 0)
+        {
+            std::fprintf (stderr, "Chunk-parallel output does not match the serial output!\n");
+            return 1;
+        }
+        std::printf ("Chunk-parallel output matches the serial output\n");
+    }
+
+    return 0;
+}